@@ -0,0 +1,40 @@
+# Checks that restarting the analyzer on a capture that grew gives the same
+# results as analyzing the whole capture at once. Writes a capture with
+# swd_generate, analyzes it with swd_analyze, then again restarted at each of
+# RESTART_AT, and fails unless all the exports are the same.
+#
+# ctest runs it with cmake -P and these variables:
+#   SWD_GENERATE, SWD_ANALYZE   the tools
+#   WORK_DIR                    where the capture and the exports go
+#   GENERATE_ARGS               swd_generate's options, a list
+#   ANALYZE_ARGS                swd_analyze's options for every run, a list
+#   RESTART_AT                  the samples to restart at, a list
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(CAPTURE ${WORK_DIR}/capture)
+
+execute_process(COMMAND ${SWD_GENERATE} ${GENERATE_ARGS} ${CAPTURE} RESULT_VARIABLE result OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "swd_generate failed: ${result}")
+endif()
+
+set(FILES ${CAPTURE}.swdio.edges ${CAPTURE}.swclk.edges)
+
+execute_process(COMMAND ${SWD_ANALYZE} ${ANALYZE_ARGS} --export ${WORK_DIR}/full.txt ${FILES} RESULT_VARIABLE result OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "swd_analyze failed: ${result}")
+endif()
+
+foreach(sample ${RESTART_AT})
+    set(export ${WORK_DIR}/restart_${sample}.txt)
+    execute_process(COMMAND ${SWD_ANALYZE} ${ANALYZE_ARGS} --restart-at ${sample} --export ${export} ${FILES}
+                    RESULT_VARIABLE result OUTPUT_QUIET)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "swd_analyze --restart-at ${sample} failed: ${result}")
+    endif()
+
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/full.txt ${export} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "restarting at ${sample} gives other results than the full run, see ${export}")
+    endif()
+endforeach()
@@ -0,0 +1,83 @@
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include <map>
+#include <memory>
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerChannelData.h"
+#include "AnalyzerResults.h"
+#include "AnalyzerSettings.h"
+#include "SimulationChannelDescriptor.h"
+
+// The base of the analyzers. Where Logic runs WorkerThread on a thread of its
+// own, the stand-in runs it in RunWorkerThread on the calling thread, over the
+// channel data it was given, until the data runs out.
+class LOGICAPI Analyzer
+{
+  public:
+    Analyzer();
+    virtual ~Analyzer() = 0;
+
+    // override these
+    virtual void SetupResults();
+    virtual void WorkerThread() = 0;
+    virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels ) = 0;
+    virtual U32 GetMinimumSampleRateHz() = 0;
+    virtual const char* GetAnalyzerName() const = 0;
+    virtual bool NeedsRerun() = 0;
+
+    // use these
+    void SetAnalyzerSettings( AnalyzerSettings* settings );
+    AnalyzerChannelData* GetAnalyzerChannelData( Channel& channel );
+    void ReportProgress( U64 sample_number );
+    void SetAnalyzerResults( AnalyzerResults* results );
+    U32 GetSimulationSampleRate();
+    U32 GetSampleRate();
+    U64 GetTriggerSample();
+
+    void CheckIfThreadShouldExit();
+    double GetAnalyzerProgress();
+
+    // call this from the destructor
+    void KillThread();
+
+    // stand-in only, for setting up and running the analyzer
+    void SetSampleRate( U32 sample_rate );
+    void SetTriggerSample( U64 trigger_sample );
+
+    // the channel data isn't owned by the analyzer
+    void SetChannelData( const Channel& channel, AnalyzerChannelData* channel_data );
+
+    AnalyzerSettings* GetAnalyzerSettings() const;
+    AnalyzerResults* GetAnalyzerResults() const;
+
+    // the sample last passed to ReportProgress
+    U64 GetProgressSample() const;
+
+    // runs WorkerThread until it runs out of channel data
+    void RunWorkerThread();
+
+  protected:
+    // not copyable
+    Analyzer( const Analyzer& );
+    Analyzer& operator=( const Analyzer& );
+
+    AnalyzerSettings* mSettings;
+    AnalyzerResults* mResults;
+
+    std::map<Channel, AnalyzerChannelData*> mChannelData;
+
+    U32 mSampleRate;
+    U64 mTriggerSample;
+    U64 mProgressSample;
+};
+
+class LOGICAPI Analyzer2 : public Analyzer
+{
+  public:
+    Analyzer2();
+    virtual void SetupResults();
+};
+
+#endif // ANALYZER_H
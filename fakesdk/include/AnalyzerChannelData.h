@@ -0,0 +1,72 @@
+#ifndef ANALYZERCHANNELDATA
+#define ANALYZERCHANNELDATA
+
+#include <cstddef>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+// Stand-in only: thrown when the analyzer asks for data past the end of the
+// capture. Logic blocks until more data comes in, or kills the worker thread,
+// while the stand-in ends the worker thread with this.
+struct AnalyzerChannelDataEnd
+{
+};
+
+// A channel's data, backed by the list of its transitions.
+// The capture ends at last_sample, which may be after the last transition.
+class LOGICAPI AnalyzerChannelData
+{
+  public:
+    // stand-in only
+    AnalyzerChannelData( BitState initial_state, const std::vector<U64>& edges, U64 last_sample );
+    ~AnalyzerChannelData();
+
+    U64 GetSampleNumber();
+    BitState GetBitState();
+
+    // these move forward and return how many times the bit changed state on the way
+    U32 Advance( U32 num_samples );
+    U32 AdvanceToAbsPosition( U64 sample_number );
+
+    // moves forward until the bit state changes from what it is now
+    void AdvanceToNextEdge();
+
+    // the sample of the next transition, without moving
+    U64 GetSampleOfNextEdge();
+
+    // whether moving forward would go over a transition
+    bool WouldAdvancingCauseTransition( U32 num_samples );
+    bool WouldAdvancingToAbsPositionCauseTransition( U64 sample_number );
+
+    // the shortest pulse gone over since tracking was turned on
+    void TrackMinimumPulseWidth();
+    U64 GetMinimumPulseWidthSoFar();
+
+    bool DoMoreTransitionsExistInCurrentData();
+
+    // stand-in only
+    U64 GetLastSample() const;
+
+  protected:
+    // not copyable
+    AnalyzerChannelData( const AnalyzerChannelData& );
+    AnalyzerChannelData& operator=( const AnalyzerChannelData& );
+
+    void UpdatePulseWidth();
+
+    std::vector<U64> mEdges;
+    U64 mLastSample;
+
+    U64 mSampleNumber;
+    BitState mBitState;
+
+    // the index of the next transition
+    size_t mNextEdge;
+
+    bool mTrackPulseWidth;
+    U64 mMinimumPulseWidth;
+    U64 mLastEdge;
+};
+
+#endif // ANALYZERCHANNELDATA
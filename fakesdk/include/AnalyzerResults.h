@@ -0,0 +1,139 @@
+#ifndef ANALYZER_RESULTS
+#define ANALYZER_RESULTS
+
+#include <string>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+#define DISPLAY_AS_ERROR_FLAG ( 1 << 7 )
+#define DISPLAY_AS_WARNING_FLAG ( 1 << 6 )
+
+#define INVALID_RESULT_INDEX 0xFFFFFFFFFFFFFFFFull
+
+class LOGICAPI Frame
+{
+  public:
+    Frame();
+    Frame( const Frame& frame );
+    ~Frame();
+
+    S64 mStartingSampleInclusive;
+    S64 mEndingSampleInclusive;
+    U64 mData1;
+    U64 mData2;
+    U8 mType;
+    U8 mFlags;
+
+    bool HasFlag( U8 flag );
+};
+
+// The results of an analyzer, kept in memory.
+// Everything added is recorded as it comes, along with which of it was
+// committed, so the results can be checked once the worker thread is done.
+class LOGICAPI AnalyzerResults
+{
+  public:
+    enum MarkerType
+    {
+        Dot,
+        ErrorDot,
+        Square,
+        ErrorSquare,
+        UpArrow,
+        DownArrow,
+        X,
+        ErrorX,
+        Start,
+        Stop,
+        One,
+        Zero
+    };
+
+    // stand-in only
+    struct Marker
+    {
+        U64 mSample;
+        MarkerType mType;
+    };
+
+    AnalyzerResults();
+    virtual ~AnalyzerResults();
+
+    // override these
+    virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base ) = 0;
+    virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id ) = 0;
+    virtual void GenerateFrameTabularText( U64 frame_index, DisplayBase display_base ) = 0;
+    virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) = 0;
+    virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) = 0;
+
+    // use these when creating results
+    void AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel );
+
+    U64 AddFrame( const Frame& frame );
+    U64 CommitPacketAndStartNewPacket();
+    void CancelPacketAndStartNewPacket();
+    void AddPacketToTransaction( U64 transaction_id, U64 packet_id );
+    void AddChannelBubblesWillAppearOn( const Channel& channel );
+
+    void CommitResults();
+
+    // use these when generating bubbles, tabular text and exports
+    U64 GetNumFrames();
+    U64 GetNumPackets();
+    Frame GetFrame( U64 frame_id );
+
+    U64 GetPacketContainingFrame( U64 frame_id );
+    U64 GetPacketContainingFrameSequential( U64 frame_id );
+    void GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id );
+
+    void ClearResultStrings();
+    void AddResultString( const char* str1, const char* str2 = 0, const char* str3 = 0, const char* str4 = 0, const char* str5 = 0,
+                          const char* str6 = 0 );
+
+    void ClearTabularText();
+    void AddTabularText( const char* str1, const char* str2 = 0, const char* str3 = 0, const char* str4 = 0, const char* str5 = 0,
+                         const char* str6 = 0 );
+
+    // returns true if the export should be cancelled
+    bool UpdateExportProgressAndCheckForCancel( U64 completed_frames, U64 total_frames );
+
+    // stand-in only, for looking at what the analyzer produced
+    U64 GetNumCommittedFrames() const;
+    U64 GetNumCommits() const;
+    U64 GetNumMarkers( const Channel& channel ) const;
+    Marker GetMarker( const Channel& channel, U64 marker_index ) const;
+    const std::vector<Channel>& GetBubbleChannels() const;
+    const std::vector<std::string>& GetResultStrings() const;
+    const std::vector<std::string>& GetTabularText() const;
+
+  protected:
+    // not copyable
+    AnalyzerResults( const AnalyzerResults& );
+    AnalyzerResults& operator=( const AnalyzerResults& );
+
+    struct ChannelMarkers
+    {
+        Channel mChannel;
+        std::vector<Marker> mMarkers;
+    };
+
+    const ChannelMarkers* FindMarkers( const Channel& channel ) const;
+
+    std::vector<Frame> mFrames;
+    std::vector<ChannelMarkers> mMarkers;
+
+    // the first frame of each packet, and the packet of each transaction
+    std::vector<U64> mPacketStarts;
+    std::vector<std::pair<U64, U64> > mTransactionPackets;
+    U64 mPacketStart;
+
+    U64 mCommittedFrames;
+    U64 mCommits;
+
+    std::vector<Channel> mBubbleChannels;
+    std::vector<std::string> mResultStrings;
+    std::vector<std::string> mTabularText;
+};
+
+#endif // ANALYZER_RESULTS
@@ -0,0 +1,56 @@
+#ifndef ANALYZER_SETTINGS
+#define ANALYZER_SETTINGS
+
+#include <string>
+#include <vector>
+
+#include "LogicPublicTypes.h"
+#include "AnalyzerSettingInterface.h"
+
+class LOGICAPI AnalyzerSettings
+{
+  public:
+    AnalyzerSettings();
+    virtual ~AnalyzerSettings();
+
+    // override these
+    virtual bool SetSettingsFromInterfaces() = 0;
+    virtual void LoadSettings( const char* settings ) = 0;
+    virtual const char* SaveSettings() = 0;
+
+    // stand-in only, the channels the analyzer reported and whether it uses them
+    struct ChannelUse
+    {
+        Channel mChannel;
+        std::string mLabel;
+        bool mIsUsed;
+    };
+
+    // stand-in only, for setting things up the way Logic's dialog would
+    U32 GetNumInterfaces() const;
+    AnalyzerSettingInterface* GetInterface( U32 index ) const;
+    const std::vector<ChannelUse>& GetChannels() const;
+    const char* GetErrorText() const;
+
+    // use these in the constructor
+    void ClearChannels();
+    void AddChannel( Channel& channel, const char* channel_label, bool is_used );
+
+    void SetErrorText( const char* error_text );
+    void AddInterface( AnalyzerSettingInterface* analyzer_setting_interface );
+
+    void AddExportOption( U32 user_id, const char* menu_text );
+    void AddExportExtension( U32 user_id, const char* extension_description, const char* extension );
+
+    // SaveSettings returns its string through this, which keeps it alive until the next call
+    const char* SetReturnString( const char* str );
+
+  protected:
+    std::vector<AnalyzerSettingInterface*> mInterfaces;
+    std::vector<ChannelUse> mChannels;
+
+    std::string mErrorText;
+    std::string mReturnString;
+};
+
+#endif // ANALYZER_SETTINGS
@@ -0,0 +1,71 @@
+#ifndef LOGICPUBLICTYPES
+#define LOGICPUBLICTYPES
+
+// Stand-in for the Analyzer SDK, see fakesdk/CMakeLists.txt.
+// The declarations follow the SDK headers, so that the analyzer builds
+// against either one unchanged. What only the stand-in has is marked so.
+
+#ifndef _WIN32
+#define __cdecl
+#define __stdcall
+#define __fastcall
+#endif
+
+// the stand-in is a static library, so only the plugin entry points are exported
+#define LOGICAPI
+
+#ifdef _WIN32
+#define ANALYZER_EXPORT __declspec( dllexport )
+#else
+#define ANALYZER_EXPORT __attribute__( ( visibility( "default" ) ) )
+#endif
+
+typedef signed char S8;
+typedef short S16;
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+enum DisplayBase
+{
+    Binary,
+    Decimal,
+    Hexadecimal,
+    ASCII,
+    AsciiHex
+};
+
+enum BitState
+{
+    BIT_LOW,
+    BIT_HIGH
+};
+
+#define Toggle( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+#define Invert( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+
+class LOGICAPI Channel
+{
+  public:
+    Channel();
+    Channel( const Channel& channel );
+    Channel( U64 device_id, U32 channel_index );
+    ~Channel();
+
+    Channel& operator=( const Channel& channel );
+    bool operator==( const Channel& channel ) const;
+    bool operator!=( const Channel& channel ) const;
+    bool operator>( const Channel& channel ) const;
+    bool operator<( const Channel& channel ) const;
+
+    U64 mDeviceId;
+    U32 mChannelIndex;
+};
+
+#define UNDEFINED_CHANNEL Channel( 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF )
+
+#endif // LOGICPUBLICTYPES
@@ -0,0 +1,71 @@
+#ifndef SIMULATION_CHANNEL_DESCRIPTOR
+#define SIMULATION_CHANNEL_DESCRIPTOR
+
+#include <vector>
+
+#include "LogicPublicTypes.h"
+
+// A simulated channel, kept as its initial state and the samples of its transitions.
+class LOGICAPI SimulationChannelDescriptor
+{
+  public:
+    SimulationChannelDescriptor();
+    SimulationChannelDescriptor( const SimulationChannelDescriptor& other );
+    ~SimulationChannelDescriptor();
+    SimulationChannelDescriptor& operator=( const SimulationChannelDescriptor& other );
+
+    void Transition();
+    void TransitionIfNeeded( BitState bit_state );
+    void Advance( U32 num_samples_to_advance );
+
+    BitState GetCurrentBitState();
+    U64 GetCurrentSampleNumber();
+
+    void SetChannel( Channel& channel );
+    void SetSampleRate( U32 sample_rate_hz );
+    void SetInitialBitState( BitState intial_bit_state );
+
+    Channel GetChannel();
+    U32 GetSampleRate();
+    BitState GetInitialBitState();
+
+    // stand-in only, the samples of the transitions so far
+    const std::vector<U64>& GetTransitions() const;
+
+  protected:
+    Channel mChannel;
+    U32 mSampleRate;
+
+    BitState mInitialBitState;
+    BitState mBitState;
+    U64 mSampleNumber;
+
+    std::vector<U64> mTransitions;
+};
+
+class LOGICAPI SimulationChannelDescriptorGroup
+{
+  public:
+    SimulationChannelDescriptorGroup();
+    ~SimulationChannelDescriptorGroup();
+
+    SimulationChannelDescriptor* Add( Channel& channel, U32 sample_rate, BitState intial_bit_state );
+
+    void AdvanceAll( U32 num_samples_to_advance );
+
+    // the descriptors are contiguous, as Logic expects them
+    SimulationChannelDescriptor* GetArray();
+    U32 GetCount();
+
+    // the pointers returned by Add stay valid for up to this many channels
+    static const U32 MAX_CHANNELS = 64;
+
+  protected:
+    // not copyable
+    SimulationChannelDescriptorGroup( const SimulationChannelDescriptorGroup& );
+    SimulationChannelDescriptorGroup& operator=( const SimulationChannelDescriptorGroup& );
+
+    std::vector<SimulationChannelDescriptor> mChannels;
+};
+
+#endif // SIMULATION_CHANNEL_DESCRIPTOR
@@ -0,0 +1,126 @@
+#include <stdexcept>
+
+#include "Analyzer.h"
+
+Analyzer::Analyzer() : mSettings( 0 ), mResults( 0 ), mSampleRate( 0 ), mTriggerSample( 0 ), mProgressSample( 0 )
+{
+}
+
+Analyzer::~Analyzer()
+{
+}
+
+void Analyzer::SetupResults()
+{
+}
+
+void Analyzer::SetAnalyzerSettings( AnalyzerSettings* settings )
+{
+    mSettings = settings;
+}
+
+AnalyzerChannelData* Analyzer::GetAnalyzerChannelData( Channel& channel )
+{
+    std::map<Channel, AnalyzerChannelData*>::iterator ci = mChannelData.find( channel );
+    if( ci == mChannelData.end() )
+        throw std::runtime_error( "no data was given for the channel" );
+
+    return ci->second;
+}
+
+void Analyzer::ReportProgress( U64 sample_number )
+{
+    mProgressSample = sample_number;
+}
+
+void Analyzer::SetAnalyzerResults( AnalyzerResults* results )
+{
+    mResults = results;
+}
+
+U32 Analyzer::GetSimulationSampleRate()
+{
+    return mSampleRate;
+}
+
+U32 Analyzer::GetSampleRate()
+{
+    return mSampleRate;
+}
+
+U64 Analyzer::GetTriggerSample()
+{
+    return mTriggerSample;
+}
+
+void Analyzer::CheckIfThreadShouldExit()
+{
+    // the worker thread runs on the caller's thread, which nothing else stops
+}
+
+double Analyzer::GetAnalyzerProgress()
+{
+    U64 last_sample = 0;
+    for( std::map<Channel, AnalyzerChannelData*>::iterator ci = mChannelData.begin(); ci != mChannelData.end(); ++ci )
+    {
+        if( ci->second->GetLastSample() > last_sample )
+            last_sample = ci->second->GetLastSample();
+    }
+
+    return last_sample != 0 ? double( mProgressSample ) / last_sample : 0.0;
+}
+
+void Analyzer::KillThread()
+{
+    // RunWorkerThread has returned by the time the analyzer is destroyed
+}
+
+void Analyzer::SetSampleRate( U32 sample_rate )
+{
+    mSampleRate = sample_rate;
+}
+
+void Analyzer::SetTriggerSample( U64 trigger_sample )
+{
+    mTriggerSample = trigger_sample;
+}
+
+void Analyzer::SetChannelData( const Channel& channel, AnalyzerChannelData* channel_data )
+{
+    mChannelData[ channel ] = channel_data;
+}
+
+AnalyzerSettings* Analyzer::GetAnalyzerSettings() const
+{
+    return mSettings;
+}
+
+AnalyzerResults* Analyzer::GetAnalyzerResults() const
+{
+    return mResults;
+}
+
+U64 Analyzer::GetProgressSample() const
+{
+    return mProgressSample;
+}
+
+void Analyzer::RunWorkerThread()
+{
+    try
+    {
+        WorkerThread();
+    }
+    catch( AnalyzerChannelDataEnd& )
+    {
+        // the analyzer went through all of the data
+    }
+}
+
+Analyzer2::Analyzer2()
+{
+}
+
+void Analyzer2::SetupResults()
+{
+}
@@ -0,0 +1,130 @@
+#include "AnalyzerChannelData.h"
+
+// mLastEdge when no transition was gone over since the pulse tracking started
+static const U64 NO_EDGE = ~0ull;
+
+AnalyzerChannelData::AnalyzerChannelData( BitState initial_state, const std::vector<U64>& edges, U64 last_sample )
+    : mEdges( edges ),
+      mLastSample( last_sample ),
+      mSampleNumber( 0 ),
+      mBitState( initial_state ),
+      mNextEdge( 0 ),
+      mTrackPulseWidth( false ),
+      mMinimumPulseWidth( 0 ),
+      mLastEdge( NO_EDGE )
+{
+    // the transitions on the first sample give its state
+    while( mNextEdge < mEdges.size() && mEdges[ mNextEdge ] == 0 )
+    {
+        mBitState = Toggle( mBitState );
+        ++mNextEdge;
+    }
+}
+
+AnalyzerChannelData::~AnalyzerChannelData()
+{
+}
+
+U64 AnalyzerChannelData::GetSampleNumber()
+{
+    return mSampleNumber;
+}
+
+BitState AnalyzerChannelData::GetBitState()
+{
+    return mBitState;
+}
+
+U32 AnalyzerChannelData::Advance( U32 num_samples )
+{
+    return AdvanceToAbsPosition( mSampleNumber + num_samples );
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition( U64 sample_number )
+{
+    if( sample_number > mLastSample )
+        throw AnalyzerChannelDataEnd();
+
+    U32 num_transitions = 0;
+    while( mNextEdge < mEdges.size() && mEdges[ mNextEdge ] <= sample_number )
+    {
+        UpdatePulseWidth();
+        ++mNextEdge;
+        ++num_transitions;
+    }
+
+    if( num_transitions & 1 )
+        mBitState = Toggle( mBitState );
+
+    // we never go back
+    if( sample_number > mSampleNumber )
+        mSampleNumber = sample_number;
+
+    return num_transitions;
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+    if( mNextEdge == mEdges.size() )
+        throw AnalyzerChannelDataEnd();
+
+    UpdatePulseWidth();
+
+    mSampleNumber = mEdges[ mNextEdge++ ];
+    mBitState = Toggle( mBitState );
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+    if( mNextEdge == mEdges.size() )
+        throw AnalyzerChannelDataEnd();
+
+    return mEdges[ mNextEdge ];
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition( U32 num_samples )
+{
+    return WouldAdvancingToAbsPositionCauseTransition( mSampleNumber + num_samples );
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition( U64 sample_number )
+{
+    return mNextEdge < mEdges.size() && mEdges[ mNextEdge ] <= sample_number;
+}
+
+void AnalyzerChannelData::TrackMinimumPulseWidth()
+{
+    mTrackPulseWidth = true;
+}
+
+U64 AnalyzerChannelData::GetMinimumPulseWidthSoFar()
+{
+    return mMinimumPulseWidth;
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+    return mNextEdge < mEdges.size();
+}
+
+U64 AnalyzerChannelData::GetLastSample() const
+{
+    return mLastSample;
+}
+
+void AnalyzerChannelData::UpdatePulseWidth()
+{
+    // called for the next transition before we go over it
+    if( !mTrackPulseWidth )
+        return;
+
+    U64 edge = mEdges[ mNextEdge ];
+    if( mLastEdge != NO_EDGE )
+    {
+        U64 width = edge - mLastEdge;
+        if( mMinimumPulseWidth == 0 || width < mMinimumPulseWidth )
+            mMinimumPulseWidth = width;
+    }
+
+    mLastEdge = edge;
+}
@@ -0,0 +1,351 @@
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <stdexcept>
+
+#include "AnalyzerHelpers.h"
+
+bool AnalyzerHelpers::IsEven( U64 value )
+{
+    return ( value & 1 ) == 0;
+}
+
+bool AnalyzerHelpers::IsOdd( U64 value )
+{
+    return ( value & 1 ) != 0;
+}
+
+U32 AnalyzerHelpers::GetOnesCount( U64 value )
+{
+    U32 count = 0;
+    for( ; value != 0; value &= value - 1 )
+        ++count;
+
+    return count;
+}
+
+U32 AnalyzerHelpers::Diff32( U32 a, U32 b )
+{
+    return a > b ? a - b : b - a;
+}
+
+void AnalyzerHelpers::GetNumberString( U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string,
+                                       U32 result_string_max_length )
+{
+    if( num_data_bits < 64 )
+        number &= ( 1ull << num_data_bits ) - 1;
+
+    char ascii[ 16 ];
+    if( number >= 0x20 && number < 0x7F )
+        snprintf( ascii, sizeof( ascii ), "%c", char( number ) );
+    else
+        snprintf( ascii, sizeof( ascii ), "'%llu'", number );
+
+    if( display_base == Binary )
+    {
+        std::string bits( "0b" );
+        for( U32 i = num_data_bits; i > 0; --i )
+            bits += ( ( number >> ( i - 1 ) ) & 1 ) ? '1' : '0';
+
+        snprintf( result_string, result_string_max_length, "%s", bits.c_str() );
+    }
+    else if( display_base == Decimal )
+    {
+        snprintf( result_string, result_string_max_length, "%llu", number );
+    }
+    else if( display_base == Hexadecimal )
+    {
+        snprintf( result_string, result_string_max_length, "0x%0*llX", int( ( num_data_bits + 3 ) / 4 ), number );
+    }
+    else if( display_base == ASCII )
+    {
+        snprintf( result_string, result_string_max_length, "%s", ascii );
+    }
+    else
+    {
+        snprintf( result_string, result_string_max_length, "%s (0x%0*llX)", ascii, int( ( num_data_bits + 3 ) / 4 ), number );
+    }
+}
+
+void AnalyzerHelpers::GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string,
+                                     U32 result_string_max_length )
+{
+    double time_s = ( S64( sample ) - S64( trigger_sample ) ) / double( sample_rate_hz );
+
+    snprintf( result_string, result_string_max_length, "%.12f", time_s );
+}
+
+void AnalyzerHelpers::Assert( const char* message )
+{
+    throw std::logic_error( message );
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample( U64 target_sample, U32 sample_rate, U32 simulation_sample_rate )
+{
+    if( sample_rate == simulation_sample_rate )
+        return target_sample;
+
+    return U64( double( target_sample ) * simulation_sample_rate / sample_rate );
+}
+
+bool AnalyzerHelpers::DoChannelsOverlap( const Channel* channel_array, U32 num_channels )
+{
+    for( U32 i = 0; i < num_channels; ++i )
+    {
+        if( channel_array[ i ] == UNDEFINED_CHANNEL )
+            continue;
+
+        for( U32 j = i + 1; j < num_channels; ++j )
+        {
+            if( channel_array[ i ] == channel_array[ j ] )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void AnalyzerHelpers::SaveFile( const char* file_name, const U8* data, U32 data_length, bool is_binary )
+{
+    void* file = StartFile( file_name, is_binary );
+    AppendToFile( data, data_length, file );
+    EndFile( file );
+}
+
+S64 AnalyzerHelpers::ConvertToSignedNumber( U64 number, U32 num_bits )
+{
+    if( num_bits == 0 || num_bits >= 64 )
+        return S64( number );
+
+    U64 sign_bit = 1ull << ( num_bits - 1 );
+    number &= ( sign_bit << 1 ) - 1;
+
+    return S64( number ^ sign_bit ) - S64( sign_bit );
+}
+
+void* AnalyzerHelpers::StartFile( const char* file_name, bool is_binary )
+{
+    FILE* file = fopen( file_name, is_binary ? "wb" : "w" );
+    if( file == 0 )
+        throw std::runtime_error( std::string( "can't create " ) + file_name );
+
+    return file;
+}
+
+void AnalyzerHelpers::AppendToFile( const U8* data, U32 data_length, void* file )
+{
+    fwrite( data, 1, data_length, ( FILE* )file );
+}
+
+void AnalyzerHelpers::EndFile( void* file )
+{
+    fclose( ( FILE* )file );
+}
+
+ClockGenerator::ClockGenerator() : mSampleRateHz( 0 ), mSamplesPerHalfPeriod( 0 ), mError( 0 )
+{
+}
+
+ClockGenerator::~ClockGenerator()
+{
+}
+
+void ClockGenerator::Init( double target_frequency, U32 sample_rate_hz )
+{
+    mSampleRateHz = sample_rate_hz;
+    mSamplesPerHalfPeriod = sample_rate_hz / ( target_frequency * 2.0 );
+    mError = 0;
+}
+
+U32 ClockGenerator::AdvanceByHalfPeriod( double multiple )
+{
+    return AdvanceByTimeS( multiple * mSamplesPerHalfPeriod / mSampleRateHz );
+}
+
+U32 ClockGenerator::AdvanceByTimeS( double time_s )
+{
+    // carry the rounding over, so the clock doesn't drift
+    double samples = time_s * mSampleRateHz + mError;
+    U32 ret = U32( std::floor( samples + 0.5 ) );
+    mError = samples - ret;
+
+    return ret;
+}
+
+BitExtractor::BitExtractor( U64 data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits )
+    : mData( data ), mMask( shift_order == AnalyzerEnums::MsbFirst ? 1ull << ( num_bits - 1 ) : 1 ), mShiftOrder( shift_order )
+{
+}
+
+BitExtractor::~BitExtractor()
+{
+}
+
+BitState BitExtractor::GetNextBit()
+{
+    BitState bit = ( mData & mMask ) ? BIT_HIGH : BIT_LOW;
+
+    if( mShiftOrder == AnalyzerEnums::MsbFirst )
+        mMask >>= 1;
+    else
+        mMask <<= 1;
+
+    return bit;
+}
+
+DataBuilder::DataBuilder() : mData( 0 ), mMask( 0 ), mShiftOrder( AnalyzerEnums::MsbFirst )
+{
+}
+
+DataBuilder::~DataBuilder()
+{
+}
+
+void DataBuilder::Reset( U64* data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits )
+{
+    mData = data;
+    mShiftOrder = shift_order;
+    mMask = shift_order == AnalyzerEnums::MsbFirst ? 1ull << ( num_bits - 1 ) : 1;
+
+    *mData = 0;
+}
+
+void DataBuilder::AddBit( BitState bit )
+{
+    if( bit == BIT_HIGH )
+        *mData |= mMask;
+
+    if( mShiftOrder == AnalyzerEnums::MsbFirst )
+        mMask >>= 1;
+    else
+        mMask <<= 1;
+}
+
+SimpleArchive::SimpleArchive()
+{
+    mStream << std::setprecision( 17 );
+}
+
+SimpleArchive::~SimpleArchive()
+{
+}
+
+void SimpleArchive::SetString( const char* archive_string )
+{
+    mStream.str( archive_string );
+    mStream.clear();
+}
+
+const char* SimpleArchive::GetString()
+{
+    mString = mStream.str();
+
+    return mString.c_str();
+}
+
+bool SimpleArchive::operator<<( U64 data )
+{
+    return bool( mStream << data << ' ' );
+}
+
+bool SimpleArchive::operator<<( U32 data )
+{
+    return bool( mStream << data << ' ' );
+}
+
+bool SimpleArchive::operator<<( S64 data )
+{
+    return bool( mStream << data << ' ' );
+}
+
+bool SimpleArchive::operator<<( S32 data )
+{
+    return bool( mStream << data << ' ' );
+}
+
+bool SimpleArchive::operator<<( double data )
+{
+    return bool( mStream << data << ' ' );
+}
+
+bool SimpleArchive::operator<<( bool data )
+{
+    return bool( mStream << ( data ? 1 : 0 ) << ' ' );
+}
+
+bool SimpleArchive::operator<<( const char* data )
+{
+    std::string str( data );
+
+    return bool( mStream << str.size() << ':' << str << ' ' );
+}
+
+bool SimpleArchive::operator<<( Channel& data )
+{
+    return bool( mStream << data.mDeviceId << ' ' << data.mChannelIndex << ' ' );
+}
+
+bool SimpleArchive::operator>>( U64& data )
+{
+    return bool( mStream >> data );
+}
+
+bool SimpleArchive::operator>>( U32& data )
+{
+    return bool( mStream >> data );
+}
+
+bool SimpleArchive::operator>>( S64& data )
+{
+    return bool( mStream >> data );
+}
+
+bool SimpleArchive::operator>>( S32& data )
+{
+    return bool( mStream >> data );
+}
+
+bool SimpleArchive::operator>>( double& data )
+{
+    return bool( mStream >> data );
+}
+
+bool SimpleArchive::operator>>( bool& data )
+{
+    int value;
+    if( !( mStream >> value ) )
+        return false;
+
+    data = value != 0;
+
+    return true;
+}
+
+bool SimpleArchive::operator>>( char const*& data )
+{
+    size_t size;
+    char colon;
+    if( !( mStream >> size ) || !mStream.get( colon ) || colon != ':' )
+        return false;
+
+    std::string str( size, '\0' );
+    if( size != 0 && !mStream.read( &str[ 0 ], size ) )
+        return false;
+
+    // the strings stay alive as long as the archive
+    mStrings.push_back( str );
+    data = mStrings.back().c_str();
+
+    return true;
+}
+
+bool SimpleArchive::operator>>( Channel& data )
+{
+    Channel channel;
+    if( !( mStream >> channel.mDeviceId >> channel.mChannelIndex ) )
+        return false;
+
+    data = channel;
+
+    return true;
+}
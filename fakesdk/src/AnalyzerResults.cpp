@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "AnalyzerResults.h"
+
+Frame::Frame()
+    : mStartingSampleInclusive( 0 ), mEndingSampleInclusive( 0 ), mData1( 0 ), mData2( 0 ), mType( 0 ), mFlags( 0 )
+{
+}
+
+Frame::Frame( const Frame& frame )
+    : mStartingSampleInclusive( frame.mStartingSampleInclusive ),
+      mEndingSampleInclusive( frame.mEndingSampleInclusive ),
+      mData1( frame.mData1 ),
+      mData2( frame.mData2 ),
+      mType( frame.mType ),
+      mFlags( frame.mFlags )
+{
+}
+
+Frame::~Frame()
+{
+}
+
+bool Frame::HasFlag( U8 flag )
+{
+    return ( mFlags & flag ) != 0;
+}
+
+AnalyzerResults::AnalyzerResults() : mPacketStart( 0 ), mCommittedFrames( 0 ), mCommits( 0 )
+{
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+}
+
+void AnalyzerResults::AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel )
+{
+    Marker marker;
+    marker.mSample = sample_number;
+    marker.mType = marker_type;
+
+    // a couple of channels at most, so a linear search is fine
+    for( std::vector<ChannelMarkers>::iterator mi = mMarkers.begin(); mi != mMarkers.end(); ++mi )
+    {
+        if( mi->mChannel == channel )
+        {
+            mi->mMarkers.push_back( marker );
+            return;
+        }
+    }
+
+    mMarkers.push_back( ChannelMarkers() );
+    mMarkers.back().mChannel = channel;
+    mMarkers.back().mMarkers.push_back( marker );
+}
+
+U64 AnalyzerResults::AddFrame( const Frame& frame )
+{
+    mFrames.push_back( frame );
+
+    return mFrames.size() - 1;
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+    mPacketStarts.push_back( mPacketStart );
+    mPacketStart = mFrames.size();
+
+    return mPacketStarts.size() - 1;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+    mPacketStart = mFrames.size();
+}
+
+void AnalyzerResults::AddPacketToTransaction( U64 transaction_id, U64 packet_id )
+{
+    mTransactionPackets.push_back( std::make_pair( transaction_id, packet_id ) );
+}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn( const Channel& channel )
+{
+    mBubbleChannels.push_back( channel );
+}
+
+void AnalyzerResults::CommitResults()
+{
+    mCommittedFrames = mFrames.size();
+    ++mCommits;
+}
+
+U64 AnalyzerResults::GetNumFrames()
+{
+    return mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumPackets()
+{
+    return mPacketStarts.size();
+}
+
+Frame AnalyzerResults::GetFrame( U64 frame_id )
+{
+    return mFrames.at( frame_id );
+}
+
+U64 AnalyzerResults::GetPacketContainingFrame( U64 frame_id )
+{
+    // the packet starting last on or before the frame, if the frame isn't past the end of it
+    std::vector<U64>::iterator pi = std::upper_bound( mPacketStarts.begin(), mPacketStarts.end(), frame_id );
+    if( pi == mPacketStarts.begin() )
+        return INVALID_RESULT_INDEX;
+
+    U64 packet_id = ( pi - mPacketStarts.begin() ) - 1;
+
+    U64 first_frame_id, last_frame_id;
+    GetFramesContainedInPacket( packet_id, &first_frame_id, &last_frame_id );
+
+    return frame_id <= last_frame_id ? packet_id : INVALID_RESULT_INDEX;
+}
+
+U64 AnalyzerResults::GetPacketContainingFrameSequential( U64 frame_id )
+{
+    return GetPacketContainingFrame( frame_id );
+}
+
+void AnalyzerResults::GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id )
+{
+    *first_frame_id = mPacketStarts.at( packet_id );
+
+    // a packet ends where the next one starts, or with the frames added when it was committed
+    U64 end = packet_id + 1 < mPacketStarts.size() ? mPacketStarts[ packet_id + 1 ] : mPacketStart;
+    *last_frame_id = end - 1;
+}
+
+void AnalyzerResults::ClearResultStrings()
+{
+    mResultStrings.clear();
+}
+
+static std::string Concat( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6 )
+{
+    std::string ret( str1 );
+
+    const char* rest[] = { str2, str3, str4, str5, str6 };
+    for( size_t i = 0; i < sizeof( rest ) / sizeof( rest[ 0 ] ) && rest[ i ] != 0; ++i )
+        ret += rest[ i ];
+
+    return ret;
+}
+
+void AnalyzerResults::AddResultString( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5,
+                                       const char* str6 )
+{
+    mResultStrings.push_back( Concat( str1, str2, str3, str4, str5, str6 ) );
+}
+
+void AnalyzerResults::ClearTabularText()
+{
+    mTabularText.clear();
+}
+
+void AnalyzerResults::AddTabularText( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5,
+                                      const char* str6 )
+{
+    mTabularText.push_back( Concat( str1, str2, str3, str4, str5, str6 ) );
+}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel( U64 /* completed_frames */, U64 /* total_frames */ )
+{
+    // nobody to cancel it
+    return false;
+}
+
+U64 AnalyzerResults::GetNumCommittedFrames() const
+{
+    return mCommittedFrames;
+}
+
+U64 AnalyzerResults::GetNumCommits() const
+{
+    return mCommits;
+}
+
+const AnalyzerResults::ChannelMarkers* AnalyzerResults::FindMarkers( const Channel& channel ) const
+{
+    for( std::vector<ChannelMarkers>::const_iterator mi = mMarkers.begin(); mi != mMarkers.end(); ++mi )
+    {
+        if( mi->mChannel == channel )
+            return &*mi;
+    }
+
+    return 0;
+}
+
+U64 AnalyzerResults::GetNumMarkers( const Channel& channel ) const
+{
+    const ChannelMarkers* markers = FindMarkers( channel );
+
+    return markers != 0 ? markers->mMarkers.size() : 0;
+}
+
+AnalyzerResults::Marker AnalyzerResults::GetMarker( const Channel& channel, U64 marker_index ) const
+{
+    const ChannelMarkers* markers = FindMarkers( channel );
+    if( markers == 0 || marker_index >= markers->mMarkers.size() )
+        throw std::out_of_range( "no such marker" );
+
+    return markers->mMarkers[ marker_index ];
+}
+
+const std::vector<Channel>& AnalyzerResults::GetBubbleChannels() const
+{
+    return mBubbleChannels;
+}
+
+const std::vector<std::string>& AnalyzerResults::GetResultStrings() const
+{
+    return mResultStrings;
+}
+
+const std::vector<std::string>& AnalyzerResults::GetTabularText() const
+{
+    return mTabularText;
+}
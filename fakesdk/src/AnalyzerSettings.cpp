@@ -0,0 +1,312 @@
+#include "AnalyzerSettings.h"
+
+AnalyzerSettings::AnalyzerSettings()
+{
+}
+
+AnalyzerSettings::~AnalyzerSettings()
+{
+}
+
+void AnalyzerSettings::ClearChannels()
+{
+    mChannels.clear();
+}
+
+void AnalyzerSettings::AddChannel( Channel& channel, const char* channel_label, bool is_used )
+{
+    ChannelUse use;
+    use.mChannel = channel;
+    use.mLabel = channel_label;
+    use.mIsUsed = is_used;
+
+    mChannels.push_back( use );
+}
+
+void AnalyzerSettings::SetErrorText( const char* error_text )
+{
+    mErrorText = error_text;
+}
+
+void AnalyzerSettings::AddInterface( AnalyzerSettingInterface* analyzer_setting_interface )
+{
+    mInterfaces.push_back( analyzer_setting_interface );
+}
+
+void AnalyzerSettings::AddExportOption( U32 /* user_id */, const char* /* menu_text */ )
+{
+}
+
+void AnalyzerSettings::AddExportExtension( U32 /* user_id */, const char* /* extension_description */, const char* /* extension */ )
+{
+}
+
+const char* AnalyzerSettings::SetReturnString( const char* str )
+{
+    mReturnString = str;
+
+    return mReturnString.c_str();
+}
+
+U32 AnalyzerSettings::GetNumInterfaces() const
+{
+    return U32( mInterfaces.size() );
+}
+
+AnalyzerSettingInterface* AnalyzerSettings::GetInterface( U32 index ) const
+{
+    return mInterfaces.at( index );
+}
+
+const std::vector<AnalyzerSettings::ChannelUse>& AnalyzerSettings::GetChannels() const
+{
+    return mChannels;
+}
+
+const char* AnalyzerSettings::GetErrorText() const
+{
+    return mErrorText.c_str();
+}
+
+AnalyzerSettingInterface::AnalyzerSettingInterface() : mDisabled( false )
+{
+}
+
+AnalyzerSettingInterface::~AnalyzerSettingInterface()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterface::GetType()
+{
+    return INTERFACE_BASE;
+}
+
+const char* AnalyzerSettingInterface::GetToolTip()
+{
+    return mTooltip.c_str();
+}
+
+const char* AnalyzerSettingInterface::GetTitle()
+{
+    return mTitle.c_str();
+}
+
+bool AnalyzerSettingInterface::IsDisabled()
+{
+    return mDisabled;
+}
+
+void AnalyzerSettingInterface::SetTitleAndTooltip( const char* title, const char* tooltip )
+{
+    mTitle = title;
+    mTooltip = tooltip;
+}
+
+AnalyzerSettingInterfaceChannel::AnalyzerSettingInterfaceChannel() : mChannel( UNDEFINED_CHANNEL ), mSelectionOfNoneIsAllowed( false )
+{
+}
+
+AnalyzerSettingInterfaceChannel::~AnalyzerSettingInterfaceChannel()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceChannel::GetType()
+{
+    return INTERFACE_CHANNEL;
+}
+
+Channel AnalyzerSettingInterfaceChannel::GetChannel()
+{
+    return mChannel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetChannel( const Channel& channel )
+{
+    mChannel = channel;
+}
+
+bool AnalyzerSettingInterfaceChannel::GetSelectionOfNoneIsAllowed()
+{
+    return mSelectionOfNoneIsAllowed;
+}
+
+void AnalyzerSettingInterfaceChannel::SetSelectionOfNoneIsAllowed( bool is_allowed )
+{
+    mSelectionOfNoneIsAllowed = is_allowed;
+}
+
+AnalyzerSettingInterfaceNumberList::AnalyzerSettingInterfaceNumberList() : mNumber( 0 )
+{
+}
+
+AnalyzerSettingInterfaceNumberList::~AnalyzerSettingInterfaceNumberList()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceNumberList::GetType()
+{
+    return INTERFACE_NUMBER_LIST;
+}
+
+double AnalyzerSettingInterfaceNumberList::GetNumber()
+{
+    return mNumber;
+}
+
+void AnalyzerSettingInterfaceNumberList::SetNumber( double number )
+{
+    mNumber = number;
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxNumbersCount()
+{
+    return U32( mNumbers.size() );
+}
+
+double AnalyzerSettingInterfaceNumberList::GetListboxNumber( U32 index )
+{
+    return mNumbers.at( index );
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxStringsCount()
+{
+    return U32( mStrings.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxString( U32 index )
+{
+    return mStrings.at( index ).c_str();
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxTooltipsCount()
+{
+    return U32( mTooltips.size() );
+}
+
+const char* AnalyzerSettingInterfaceNumberList::GetListboxTooltip( U32 index )
+{
+    return mTooltips.at( index ).c_str();
+}
+
+void AnalyzerSettingInterfaceNumberList::AddNumber( double number, const char* str, const char* tooltip )
+{
+    mNumbers.push_back( number );
+    mStrings.push_back( str );
+    mTooltips.push_back( tooltip );
+}
+
+void AnalyzerSettingInterfaceNumberList::ClearNumbers()
+{
+    mNumbers.clear();
+    mStrings.clear();
+    mTooltips.clear();
+}
+
+AnalyzerSettingInterfaceInteger::AnalyzerSettingInterfaceInteger() : mInteger( 0 ), mMax( 0x7FFFFFFF ), mMin( -0x7FFFFFFF - 1 )
+{
+}
+
+AnalyzerSettingInterfaceInteger::~AnalyzerSettingInterfaceInteger()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceInteger::GetType()
+{
+    return INTERFACE_INTEGER;
+}
+
+int AnalyzerSettingInterfaceInteger::GetInteger()
+{
+    return mInteger;
+}
+
+void AnalyzerSettingInterfaceInteger::SetInteger( int integer )
+{
+    mInteger = integer;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMax()
+{
+    return mMax;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMin()
+{
+    return mMin;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMax( int max )
+{
+    mMax = max;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMin( int min )
+{
+    mMin = min;
+}
+
+AnalyzerSettingInterfaceText::AnalyzerSettingInterfaceText() : mTextType( NormalText )
+{
+}
+
+AnalyzerSettingInterfaceText::~AnalyzerSettingInterfaceText()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceText::GetType()
+{
+    return INTERFACE_TEXT;
+}
+
+const char* AnalyzerSettingInterfaceText::GetText()
+{
+    return mText.c_str();
+}
+
+void AnalyzerSettingInterfaceText::SetText( const char* text )
+{
+    mText = text;
+}
+
+AnalyzerSettingInterfaceText::TextType AnalyzerSettingInterfaceText::GetTextType()
+{
+    return mTextType;
+}
+
+void AnalyzerSettingInterfaceText::SetTextType( TextType text_type )
+{
+    mTextType = text_type;
+}
+
+AnalyzerSettingInterfaceBool::AnalyzerSettingInterfaceBool() : mValue( false )
+{
+}
+
+AnalyzerSettingInterfaceBool::~AnalyzerSettingInterfaceBool()
+{
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceBool::GetType()
+{
+    return INTERFACE_BOOL;
+}
+
+bool AnalyzerSettingInterfaceBool::GetValue()
+{
+    return mValue;
+}
+
+void AnalyzerSettingInterfaceBool::SetValue( bool value )
+{
+    mValue = value;
+}
+
+const char* AnalyzerSettingInterfaceBool::GetCheckBoxText()
+{
+    return mCheckBoxText.c_str();
+}
+
+void AnalyzerSettingInterfaceBool::SetCheckBoxText( const char* text )
+{
+    mCheckBoxText = text;
+}
@@ -0,0 +1,136 @@
+#include "SimulationChannelDescriptor.h"
+
+SimulationChannelDescriptor::SimulationChannelDescriptor()
+    : mSampleRate( 0 ), mInitialBitState( BIT_LOW ), mBitState( BIT_LOW ), mSampleNumber( 0 )
+{
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor( const SimulationChannelDescriptor& other )
+    : mChannel( other.mChannel ),
+      mSampleRate( other.mSampleRate ),
+      mInitialBitState( other.mInitialBitState ),
+      mBitState( other.mBitState ),
+      mSampleNumber( other.mSampleNumber ),
+      mTransitions( other.mTransitions )
+{
+}
+
+SimulationChannelDescriptor::~SimulationChannelDescriptor()
+{
+}
+
+SimulationChannelDescriptor& SimulationChannelDescriptor::operator=( const SimulationChannelDescriptor& other )
+{
+    mChannel = other.mChannel;
+    mSampleRate = other.mSampleRate;
+    mInitialBitState = other.mInitialBitState;
+    mBitState = other.mBitState;
+    mSampleNumber = other.mSampleNumber;
+    mTransitions = other.mTransitions;
+
+    return *this;
+}
+
+void SimulationChannelDescriptor::Transition()
+{
+    mBitState = Toggle( mBitState );
+    mTransitions.push_back( mSampleNumber );
+}
+
+void SimulationChannelDescriptor::TransitionIfNeeded( BitState bit_state )
+{
+    if( bit_state != mBitState )
+        Transition();
+}
+
+void SimulationChannelDescriptor::Advance( U32 num_samples_to_advance )
+{
+    mSampleNumber += num_samples_to_advance;
+}
+
+BitState SimulationChannelDescriptor::GetCurrentBitState()
+{
+    return mBitState;
+}
+
+U64 SimulationChannelDescriptor::GetCurrentSampleNumber()
+{
+    return mSampleNumber;
+}
+
+void SimulationChannelDescriptor::SetChannel( Channel& channel )
+{
+    mChannel = channel;
+}
+
+void SimulationChannelDescriptor::SetSampleRate( U32 sample_rate_hz )
+{
+    mSampleRate = sample_rate_hz;
+}
+
+void SimulationChannelDescriptor::SetInitialBitState( BitState intial_bit_state )
+{
+    mInitialBitState = intial_bit_state;
+    mBitState = intial_bit_state;
+}
+
+Channel SimulationChannelDescriptor::GetChannel()
+{
+    return mChannel;
+}
+
+U32 SimulationChannelDescriptor::GetSampleRate()
+{
+    return mSampleRate;
+}
+
+BitState SimulationChannelDescriptor::GetInitialBitState()
+{
+    return mInitialBitState;
+}
+
+const std::vector<U64>& SimulationChannelDescriptor::GetTransitions() const
+{
+    return mTransitions;
+}
+
+SimulationChannelDescriptorGroup::SimulationChannelDescriptorGroup()
+{
+    mChannels.reserve( MAX_CHANNELS );
+}
+
+SimulationChannelDescriptorGroup::~SimulationChannelDescriptorGroup()
+{
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::Add( Channel& channel, U32 sample_rate, BitState intial_bit_state )
+{
+    // growing would move the descriptors handed out so far
+    if( mChannels.size() == MAX_CHANNELS )
+        return 0;
+
+    mChannels.push_back( SimulationChannelDescriptor() );
+
+    SimulationChannelDescriptor& descriptor( mChannels.back() );
+    descriptor.SetChannel( channel );
+    descriptor.SetSampleRate( sample_rate );
+    descriptor.SetInitialBitState( intial_bit_state );
+
+    return &descriptor;
+}
+
+void SimulationChannelDescriptorGroup::AdvanceAll( U32 num_samples_to_advance )
+{
+    for( std::vector<SimulationChannelDescriptor>::iterator ci = mChannels.begin(); ci != mChannels.end(); ++ci )
+        ci->Advance( num_samples_to_advance );
+}
+
+SimulationChannelDescriptor* SimulationChannelDescriptorGroup::GetArray()
+{
+    return mChannels.empty() ? 0 : &mChannels[ 0 ];
+}
+
+U32 SimulationChannelDescriptorGroup::GetCount()
+{
+    return U32( mChannels.size() );
+}
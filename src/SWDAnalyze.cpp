@@ -0,0 +1,302 @@
+// swd_analyze: runs the analyzer's worker thread headless.
+//
+// Only builds against the stand-in SDK in fakesdk, which provides the channel
+// data and keeps the results in memory. The data is either the analyzer's own
+// simulation data or a capture in the raw edge list format.
+// Run it with --help for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <AnalyzerHelpers.h>
+
+#include "SWDAnalyzer.h"
+#include "SWDCaptureFile.h"
+#include "SWDTrace.h"
+
+// the channels the analyzer is set up with
+static Channel SWDIO_CHANNEL( 0, 0 );
+static Channel SWCLK_CHANNEL( 0, 1 );
+
+static void PrintUsage()
+{
+    std::cerr << "usage: swd_analyze [options] [swdio_file swclk_file]\n"
+                 "\n"
+                 "Analyzes the two raw edge list files, or the analyzer's simulation data without them.\n"
+                 "\n"
+                 "options:\n"
+                 "  --samples N           samples of simulation data, 10000000 by default\n"
+                 "  --sample-rate HZ      simulation sample rate, 100000000 by default\n"
+                 "  --export FILE         write the analyzer's export to FILE\n"
+                 "  --stats FILE          write the decoder statistics export to FILE\n"
+                 "  --trace FILE          write the decoder trace export to FILE, in builds configured with SWD_TRACE=ON\n"
+                 "  --commit-operations N commit the results after N operations, 1000 by default, 0 for no limit\n"
+                 "  --commit-samples N    commit the results once they span N samples, 1000000 by default, 0 for no limit\n"
+                 "  --no-caught-up-commit don't commit the results when the decoder has caught up with the data\n"
+                 "  --markers MODE        all, turnarounds, errors or none, all by default\n"
+                 "  --compact             one frame per operation instead of one for each of its fields\n"
+                 "  --retries MODE        one frame for the retries in a row of: wait, fault (WAIT or FAULT) or none;\n"
+                 "                        none by default\n"
+                 "  --collapse-repeats    one frame for the copies of operations that repeat right after themselves\n"
+                 "  --restart-at SAMPLE   analyze the data up to SAMPLE first, then run the analyzer again over all of it,\n"
+                 "                        as Logic does when it restarts the analyzer on a capture that grew\n";
+}
+
+// a channel's data, which can be handed to the analyzer more than once
+struct SWDCapturedChannel
+{
+    BitState initial_state;
+    std::vector<U64> edges;
+    U64 last_sample;
+
+    // the data up to end_sample, or all of it
+    AnalyzerChannelData* MakeChannelData( U64 end_sample ) const
+    {
+        if( end_sample >= last_sample )
+            return new AnalyzerChannelData( initial_state, edges, last_sample );
+
+        std::vector<U64> cut( edges.begin(), std::upper_bound( edges.begin(), edges.end(), end_sample ) );
+        return new AnalyzerChannelData( initial_state, cut, end_sample );
+    }
+};
+
+// reads all of the transitions of an edge list file
+static bool ReadEdgeList( const std::string& path, BitState& initial_state, std::vector<U64>& edges, U32& sample_rate,
+                          std::string& error )
+{
+    SWDMappedFile file;
+    SWDEdgeListChannel channel;
+    if( !file.Open( path, error ) || !channel.Open( file, error ) )
+        return false;
+
+    initial_state = channel.GetBitState();
+    sample_rate = channel.GetSampleRate();
+
+    while( channel.DoMoreTransitionsExistInCurrentData() )
+    {
+        channel.AdvanceToNextEdge();
+        edges.push_back( channel.GetSampleNumber() );
+    }
+
+    return true;
+}
+
+int main( int argc, char* argv[] )
+{
+    U64 num_samples = 10000000;
+    U32 sample_rate = 100000000;
+    std::string export_file;
+    std::string stats_file;
+    std::string trace_file;
+    U64 restart_at = 0;
+    U32 commit_operations = 1000;
+    U32 commit_samples = 1000000;
+    bool commit_when_caught_up = true;
+    U32 marker_density = SWDMD_Full;
+    bool compact_frames = false;
+    U32 retry_coalescing = SWDRC_None;
+    bool collapse_repeats = false;
+    std::vector<std::string> files;
+
+    for( int ndx = 1; ndx < argc; ++ndx )
+    {
+        const std::string arg = argv[ ndx ];
+        const bool has_value = ndx + 1 < argc;
+
+        if( arg == "--samples" && has_value )
+            num_samples = strtoull( argv[ ++ndx ], 0, 10 );
+        else if( arg == "--sample-rate" && has_value )
+            sample_rate = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--export" && has_value )
+            export_file = argv[ ++ndx ];
+        else if( arg == "--stats" && has_value )
+            stats_file = argv[ ++ndx ];
+        else if( arg == "--trace" && has_value )
+            trace_file = argv[ ++ndx ];
+        else if( arg == "--commit-operations" && has_value )
+            commit_operations = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--commit-samples" && has_value )
+            commit_samples = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--no-caught-up-commit" )
+            commit_when_caught_up = false;
+        else if( arg == "--markers" && has_value )
+        {
+            const std::string mode = argv[ ++ndx ];
+            const char* MODES[ SWDMD_Count ] = { "all", "turnarounds", "errors", "none" };
+
+            marker_density = SWDMD_Count;
+            for( U32 i = 0; i < SWDMD_Count; ++i )
+            {
+                if( mode == MODES[ i ] )
+                    marker_density = i;
+            }
+
+            if( marker_density == SWDMD_Count )
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( arg == "--compact" )
+            compact_frames = true;
+        else if( arg == "--retries" && has_value )
+        {
+            const std::string mode = argv[ ++ndx ];
+            if( mode == "none" )
+                retry_coalescing = SWDRC_None;
+            else if( mode == "wait" )
+                retry_coalescing = SWDRC_Wait;
+            else if( mode == "fault" )
+                retry_coalescing = SWDRC_WaitAndFault;
+            else
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( arg == "--collapse-repeats" )
+            collapse_repeats = true;
+        else if( arg == "--restart-at" && has_value )
+            restart_at = strtoull( argv[ ++ndx ], 0, 10 );
+        else if( arg.size() > 1 && arg[ 0 ] == '-' )
+        {
+            PrintUsage();
+            return 2;
+        }
+        else
+            files.push_back( arg );
+    }
+
+    if( ( files.size() != 0 && files.size() != 2 ) || sample_rate == 0 )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if( !trace_file.empty() && !SWDTrace::IsBuiltIn() )
+    {
+        std::cerr << "--trace needs a build configured with SWD_TRACE=ON" << std::endl;
+        return 2;
+    }
+
+    SWDAnalyzer analyzer;
+
+    // set the channels up through the settings, as Logic does when loading them
+    SimpleArchive archive;
+    archive << SWDIO_CHANNEL;
+    archive << SWCLK_CHANNEL;
+    archive << commit_operations;
+    archive << commit_samples;
+    archive << commit_when_caught_up;
+    archive << marker_density;
+    archive << compact_frames;
+    archive << retry_coalescing;
+    archive << collapse_repeats;
+    analyzer.GetAnalyzerSettings()->LoadSettings( archive.GetString() );
+
+    SWDCapturedChannel swdio;
+    SWDCapturedChannel swclk;
+
+    if( files.empty() )
+    {
+        analyzer.SetSampleRate( sample_rate );
+
+        SimulationChannelDescriptor* descriptors;
+        U32 num_descriptors = analyzer.GenerateSimulationData( num_samples, sample_rate, &descriptors );
+
+        for( U32 i = 0; i < num_descriptors; ++i )
+        {
+            SimulationChannelDescriptor& descriptor( descriptors[ i ] );
+            SWDCapturedChannel& channel = descriptor.GetChannel() == SWDIO_CHANNEL ? swdio : swclk;
+
+            channel.initial_state = descriptor.GetInitialBitState();
+            channel.edges = descriptor.GetTransitions();
+            channel.last_sample = descriptor.GetCurrentSampleNumber();
+        }
+    }
+    else
+    {
+        SWDCapturedChannel* channels[ 2 ] = { &swdio, &swclk };
+        U32 file_sample_rate[ 2 ];
+
+        for( size_t i = 0; i < 2; ++i )
+        {
+            std::string error;
+            if( !ReadEdgeList( files[ i ], channels[ i ]->initial_state, channels[ i ]->edges, file_sample_rate[ i ], error ) )
+            {
+                std::cerr << files[ i ] << ": " << error << std::endl;
+                return 1;
+            }
+        }
+
+        // the capture ends with the last transition on either channel
+        U64 last_sample = 0;
+        for( size_t i = 0; i < 2; ++i )
+        {
+            if( !channels[ i ]->edges.empty() && channels[ i ]->edges.back() > last_sample )
+                last_sample = channels[ i ]->edges.back();
+        }
+
+        analyzer.SetSampleRate( file_sample_rate[ 0 ] );
+
+        swdio.last_sample = last_sample;
+        swclk.last_sample = last_sample;
+    }
+
+    // the data of each run, with the data of the restart last
+    std::vector<U64> run_ends;
+    if( restart_at != 0 )
+        run_ends.push_back( restart_at );
+    run_ends.push_back( ~0ULL );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( size_t run = 0; run < run_ends.size(); ++run )
+    {
+        // Logic runs the analyzer again from the start of the data if it asks for it
+        do
+        {
+            std::unique_ptr<AnalyzerChannelData> swdio_data( swdio.MakeChannelData( run_ends[ run ] ) );
+            std::unique_ptr<AnalyzerChannelData> swclk_data( swclk.MakeChannelData( run_ends[ run ] ) );
+
+            analyzer.SetChannelData( SWDIO_CHANNEL, swdio_data.get() );
+            analyzer.SetChannelData( SWCLK_CHANNEL, swclk_data.get() );
+
+            analyzer.SetupResults();
+
+            try
+            {
+                analyzer.RunWorkerThread();
+            }
+            catch( std::exception& e )
+            {
+                std::cerr << "the analyzer failed: " << e.what() << std::endl;
+                return 1;
+            }
+        } while( analyzer.NeedsRerun() );
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    AnalyzerResults* results = analyzer.GetAnalyzerResults();
+    if( !export_file.empty() )
+        results->GenerateExportFile( export_file.c_str(), Hexadecimal, SWDET_Text );
+    if( !stats_file.empty() )
+        results->GenerateExportFile( stats_file.c_str(), Hexadecimal, SWDET_Statistics );
+    if( !trace_file.empty() )
+        results->GenerateExportFile( trace_file.c_str(), Hexadecimal, SWDET_Trace );
+
+    std::cout << "samples:           " << analyzer.GetProgressSample() << "\n"
+              << "frames:            " << results->GetNumFrames() << "\n"
+              << "committed frames:  " << results->GetNumCommittedFrames() << "\n"
+              << "commits:           " << results->GetNumCommits() << "\n"
+              << "SWDIO markers:     " << results->GetNumMarkers( SWDIO_CHANNEL ) << "\n"
+              << "SWCLK markers:     " << results->GetNumMarkers( SWCLK_CHANNEL ) << "\n"
+              << "resumed from:      " << analyzer.GetStats().resumed_from << "\n"
+              << "seconds:           " << elapsed.count() << std::endl;
+
+    return 0;
+}
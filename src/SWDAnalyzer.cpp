@@ -1,15 +1,25 @@
 #include <vector>
 #include <algorithm>
+#include <thread>
 
 #include <AnalyzerChannelData.h>
 
 #include "SWDAnalyzer.h"
 #include "SWDAnalyzerSettings.h"
+#include "SWDTrace.h"
 #include "SWDUtils.h"
 
-SWDAnalyzer::SWDAnalyzer() : mSimulationInitilized( false )
+SWDAnalyzer::SWDAnalyzer() : mBitsSampled( 0 ), mSampledTo( 0 ), mNumCommits( 0 ), mNumMarkers( 0 ), mCommittedTo( 0 ),
+      mNumUncommitted( 0 ),
+      mUncommittedFrom( 0 ),
+      mAddedTo( 0 ),
+      mRunStartCommits( 0 ),
+      mNeedsRerun( false ), mSimulationInitilized( false )
 {
     SetAnalyzerSettings( &mSettings );
+
+    mStats = SWDAnalyzerStats();
+    mCheckpoint = SWDAnalyzerCheckpoint();
 }
 
 SWDAnalyzer::~SWDAnalyzer()
@@ -18,6 +28,17 @@ SWDAnalyzer::~SWDAnalyzer()
 }
 
 void SWDAnalyzer::SetupResults()
+{
+    // the next run carries on from the checkpoint with the results we have
+    if( CanResume() )
+        return;
+
+    mCheckpoint = SWDAnalyzerCheckpoint();
+
+    NewResults();
+}
+
+void SWDAnalyzer::NewResults()
 {
     // reset the results
     mResults.reset( new SWDAnalyzerResults( this, &mSettings ) );
@@ -28,6 +49,26 @@ void SWDAnalyzer::SetupResults()
     mResults->AddChannelBubblesWillAppearOn( mSettings.mSWCLK );
 }
 
+// Closes the bit queue and waits for the decoder thread to finish
+// the bits it was given when WorkerThread exits.
+class SWDDecoderThreadJoiner
+{
+  public:
+    SWDDecoderThreadJoiner( SWDBitQueue& bit_queue, std::thread& decoder ) : mBitQueue( bit_queue ), mDecoder( decoder )
+    {
+    }
+
+    ~SWDDecoderThreadJoiner()
+    {
+        mBitQueue.Close();
+        mDecoder.join();
+    }
+
+  private:
+    SWDBitQueue& mBitQueue;
+    std::thread& mDecoder;
+};
+
 void SWDAnalyzer::WorkerThread()
 {
     // SetupResults();
@@ -35,51 +76,439 @@ void SWDAnalyzer::WorkerThread()
     mSWDIO = GetAnalyzerChannelData( mSettings.mSWDIO );
     mSWCLK = GetAnalyzerChannelData( mSettings.mSWCLK );
 
-    mSWDParser.Setup( mSWDIO, mSWCLK, this );
+    mSWDIOChannel.SetChannelData( mSWDIO );
+    mSWCLKChannel.SetChannelData( mSWCLK );
 
-    // these are our three objects that SWDParser will fill with data
-    // on calls to IsOperation or IsLineReset
-    SWDOperation tran;
-    SWDLineReset reset;
-    SWDBit error_bit;
+    mNeedsRerun = false;
+    U64 resume_sample = 0;
+    if( mCheckpoint.valid )
+    {
+        // If this isn't the capture the results are from, this run ends here
+        // with empty results, and the next one starts over.
+        mNeedsRerun = true;
+        if( !IsCheckpointInCapture() )
+        {
+            mCheckpoint = SWDAnalyzerCheckpoint();
+            NewResults();
+            return;
+        }
 
-    mSWDParser.Clear();
+        mNeedsRerun = false;
+
+        resume_sample = U64( mCheckpoint.parser.resume_sample );
+        mSWCLK->AdvanceToAbsPosition( resume_sample );
+        mSWDIO->AdvanceToAbsPosition( resume_sample );
+    }
+    else
+        mCheckpoint.settings = mSettings.SaveSettings();
+
+    mBitSampler.Setup( &mSWDIOChannel, &mSWCLKChannel );
+    mBitQueue.Reset();
+    mSWDParser.Setup( this );
+
+    mBitsSampled = 0;
+    mSampledTo = resume_sample;
+    {
+        std::lock_guard<std::mutex> lock( mStatsMutex );
+        mStats = SWDAnalyzerStats();
+        mStats.resumed_from = resume_sample;
+    }
+
+    // This thread samples the channels, and the decoder thread turns the bits
+    // into results. We only leave the loop below with an exception,
+    // when the analyzer is killed or when the decoder thread failed.
+    std::thread decoder( [this]() { DecoderThread(); } );
+    SWDDecoderThreadJoiner joiner( mBitQueue, decoder );
+
+    SWDTrace::SetThreadName( "worker" );
 
-    // For every new bit the parser extracts from the stream,
-    // ask if this can be a valid operation or line reset.
-    // A valid operation will have the constant part of the request correctly set,
-    // and also the parity bits will be correct.
-    // A valid line reset has at least 50 high bits in succession.
     for( ;; )
     {
-        if( mSWDParser.IsOperation( tran ) )
+        SWDBitBatch& batch = mBitQueue.GetFreeBatch();
         {
-            tran.AddFrames( mResults.get() );
-            tran.AddMarkers( mResults.get() );
+            SWD_TRACE_SPAN( "SampleBits" );
+            batch.num_bits = mBitSampler.SampleBits( batch.bits, SWDBitBatch::MAX_BITS );
+            batch.at_capture_head = mBitSampler.IsAtCaptureHead();
+        }
+        mBitQueue.Push();
+
+        mBitsSampled.fetch_add( batch.num_bits, std::memory_order_relaxed );
+        mSampledTo.store( mBitSampler.GetSampleNumber(), std::memory_order_relaxed );
+
+        SWD_TRACE_SPAN( "ReportProgress" );
+        ReportProgress( mBitSampler.GetSampleNumber() );
+    }
+}
+
+void SWDAnalyzer::DecoderThread()
+{
+    try
+    {
+        SWDTrace::SetThreadName( "decoder" );
 
-            mResults->CommitResults();
+        if( mCheckpoint.valid )
+        {
+            mSWDParser.Resume( mCheckpoint.parser );
+
+            mNumCommits = mCheckpoint.num_commits;
+            mNumMarkers = mCheckpoint.num_markers;
+            mCommittedTo = U64( mCheckpoint.parser.resume_sample );
         }
-        else if( mSWDParser.IsLineReset( reset ) )
+        else
         {
-            reset.AddFrames( mResults.get() );
+            mSWDParser.Clear();
 
-            mResults->CommitResults();
+            mNumCommits = 0;
+            mNumMarkers = 0;
+            mCommittedTo = 0;
         }
+
+        mNumUncommitted = 0;
+        mAddedTo = mCommittedTo;
+        mRetries.Clear();
+        mRetriesResults.Clear();
+        mFirstRetryResults.Clear();
+
+        mRepeatDetector.Setup( this );
+        if( mCheckpoint.valid )
+            mRepeatDetector.Resume( mCheckpoint.repeat_history );
         else
+            mRepeatDetector.Clear();
+
+        mRunStart = std::chrono::steady_clock::now();
+        mRunStartCommits = mNumCommits;
+
+        // the parser calls us back with the operations and line resets it finds in the bits
+        for( ;; )
         {
-            // This is neither a valid transaction nor a valid reset,
-            // so remove the first bit and try again.
-            // We're dropping the error bit into oblivion.
-            error_bit = mSWDParser.PopFrontBit();
+            const SWDBitBatch& batch = mBitQueue.GetFullBatch();
+            mSWDParser.Feed( batch.bits, batch.num_bits );
+
+            // We'd have to wait for the capture to go on, so show what we have.
+            // The retries and the results held back wait for what ends them,
+            // so that where the capture was at doesn't change the results.
+            if( batch.at_capture_head && mSettings.mCommitWhenCaughtUp )
+                Commit();
+
+            mBitQueue.Pop();
+
+            PublishStats();
         }
+    }
+    catch( SWDBitQueueClosed& )
+    {
+        // The worker thread is done, and so are we. The results held back are
+        // shown as well, but the checkpoint stays before them, since the next
+        // run would split them if it resumed after them, even where they were
+        // committed while being flushed.
+        if( IsHolding() )
+        {
+            const SWDAnalyzerCheckpoint checkpoint = mCheckpoint;
+            FlushResults();
+            CommitResults();
+            mCheckpoint = checkpoint;
+        }
+        else
+        {
+            Commit();
+        }
+
+        PublishStats();
+    }
+    catch( ... )
+    {
+        // let the worker thread rethrow it
+        mBitQueue.Abort( std::current_exception() );
+    }
+}
+
+void SWDAnalyzer::PublishStats()
+{
+    // once per batch of bits, which makes the lock cheap enough
+    std::lock_guard<std::mutex> lock( mStatsMutex );
+
+    mStats.parser = mSWDParser.GetStats();
+    mStats.bits_sampled = mBitsSampled.load( std::memory_order_relaxed );
+    mStats.frames = mResults->GetNumFrames();
+    mStats.markers = mNumMarkers;
+    mStats.commits = mNumCommits;
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - mRunStart;
+    mStats.commits_per_second = elapsed.count() > 0 ? ( mNumCommits - mRunStartCommits ) / elapsed.count() : 0;
+
+    const U64 sampled_to = mSampledTo.load( std::memory_order_relaxed );
+    mStats.decode_lag = sampled_to > mCommittedTo ? sampled_to - mCommittedTo : 0;
+    mStats.peak_decode_lag = std::max( mStats.peak_decode_lag, mStats.decode_lag );
+}
+
+SWDAnalyzerStats SWDAnalyzer::GetStats()
+{
+    std::lock_guard<std::mutex> lock( mStatsMutex );
+
+    return mStats;
+}
+
+void SWDAnalyzer::OnOperation( SWDOperation& tran )
+{
+    const bool coalesced = IsCoalesced( tran );
+    if( coalesced && mRetries.IsRetry( tran ) )
+    {
+        // the first operation of the retries keeps its markers, the rest get none
+        if( mRetries.count == 1 )
+        {
+            mRetriesResults.markers.swap( mFirstRetryResults.markers );
+            mFirstRetryResults.Clear();
+        }
+
+        mRetries.Add( tran );
+        mRetriesResults.checkpoint = mSWDParser.GetCheckpoint();
+        return;
+    }
+
+    AddRetries();
+
+    // it's shown like any other operation unless a retry follows it
+    if( coalesced )
+    {
+        HoldOperation( tran, mFirstRetryResults );
+        mRetries.Add( tran );
+        return;
+    }
+
+    HoldOperation( tran, mOperationResults );
+    AddResults( mOperationResults );
+}
+
+void SWDAnalyzer::HoldOperation( SWDOperation& tran, SWDHeldResults& results )
+{
+    tran.AddFrames( &results, mSettings );
+    tran.AddMarkers( &results, mSettings );
+
+    results.key.SetOperation( tran );
+    results.start_sample = tran.bits.Front().GetStartSample();
+    results.end_sample = tran.bits.Back().GetEndSample();
+    results.checkpoint = mSWDParser.GetCheckpoint();
+}
+
+void SWDAnalyzer::OnLineReset( SWDLineReset& reset )
+{
+    // the operations after a line reset don't repeat the ones before it
+    FlushResults();
+    mRepeatDetector.Clear();
+
+    reset.AddFrames( &mLineResetResults );
 
-        ReportProgress( mSWDIO->GetSampleNumber() );
+    mLineResetResults.start_sample = reset.bits.GetStartSample();
+    mLineResetResults.end_sample = reset.bits.GetEndSample();
+    mLineResetResults.checkpoint = mSWDParser.GetCheckpoint();
+
+    OnResults( mLineResetResults );
+    mLineResetResults.Clear();
+}
+
+void SWDAnalyzer::OnDroppedBits( const SWDBitRun& /* bits */ )
+{
+    // the bits which aren't part of anything are not shown, the parser counts them
+}
+
+bool SWDAnalyzer::IsCoalesced( const SWDOperation& tran ) const
+{
+    const SWDRetryCoalescing coalescing = mSettings.mRetryCoalescing;
+
+    return ( tran.ACK == ACK_WAIT && coalescing != SWDRC_None ) || ( tran.ACK == ACK_FAULT && coalescing == SWDRC_WaitAndFault );
+}
+
+void SWDAnalyzer::AddRetries()
+{
+    if( mRetries.Empty() )
+        return;
+
+    // a single one isn't coalesced
+    if( mRetries.count == 1 )
+    {
+        mRetries.Clear();
+        AddResults( mFirstRetryResults );
+        return;
+    }
+
+    mRetries.AddFrames( &mRetriesResults );
+
+    mRetriesResults.key.SetRetries( mRetries );
+    mRetriesResults.start_sample = mRetries.start_sample;
+    mRetriesResults.end_sample = mRetries.end_sample;
+
+    mRetries.Clear();
+
+    AddResults( mRetriesResults );
+}
+
+void SWDAnalyzer::AddResults( SWDHeldResults& results )
+{
+    if( mSettings.mCollapseRepeats )
+    {
+        mRepeatDetector.Add( results );
     }
+    else
+    {
+        OnResults( results );
+        results.Clear();
+    }
+}
+
+void SWDAnalyzer::FlushResults()
+{
+    AddRetries();
+    mRepeatDetector.Flush();
+}
+
+void SWDAnalyzer::OnResults( SWDHeldResults& results )
+{
+    for( std::vector<Frame>::const_iterator fi = results.frames.begin(); fi != results.frames.end(); ++fi )
+        mResults->AddFrame( *fi );
+
+    for( std::vector<SWDHeldResults::Marker>::const_iterator mi = results.markers.begin(); mi != results.markers.end(); ++mi )
+        mResults->AddMarker( mi->sample_number, mi->marker_type, mSettings.mSWCLK );
+
+    mNumMarkers += results.markers.size();
+
+    ResultsAdded( U64( results.start_sample ), U64( results.end_sample ), results.checkpoint );
+}
+
+void SWDAnalyzer::OnRepeat( const SWDRepeat& repeat )
+{
+    Frame f;
+    f.mType = SWDFT_Repeat;
+    f.mStartingSampleInclusive = repeat.start_sample;
+    f.mEndingSampleInclusive = repeat.end_sample;
+    f.mData1 = repeat.count;
+    f.mData2 = repeat.period;
+    f.mFlags = 0;
+
+    mResults->AddFrame( f );
+
+    ResultsAdded( U64( repeat.start_sample ), U64( repeat.end_sample ), repeat.checkpoint );
+}
+
+void SWDAnalyzer::ResultsAdded( U64 start_sample, U64 end_sample, const SWDParserCheckpoint& checkpoint )
+{
+    if( mNumUncommitted == 0 )
+        mUncommittedFrom = start_sample;
+
+    ++mNumUncommitted;
+    mAddedTo = end_sample;
+    mAddedCheckpoint = checkpoint;
+
+    const U32 max_operations = mSettings.mCommitOperations;
+    const U32 max_samples = mSettings.mCommitSamples;
+
+    if( ( max_operations != 0 && mNumUncommitted >= max_operations ) || ( max_samples != 0 && end_sample - mUncommittedFrom >= max_samples ) )
+        Commit();
+}
+
+void SWDAnalyzer::Commit()
+{
+    // Resuming in the middle of retries or of a repeat would split them, so
+    // the checkpoint stays where nothing was held. The results committed past
+    // it can't be taken back, which makes the next run start over.
+    if( CommitResults() && !IsHolding() )
+        RecordCheckpoint();
+}
+
+bool SWDAnalyzer::CommitResults()
+{
+    if( mNumUncommitted == 0 )
+        return false;
+
+    {
+        SWD_TRACE_SPAN( "CommitResults" );
+        mResults->CommitResults();
+    }
+
+    ++mNumCommits;
+    mNumUncommitted = 0;
+    mCommittedTo = mAddedTo;
+
+    return true;
+}
+
+bool SWDAnalyzer::IsHolding() const
+{
+    return !mRetries.Empty() || mRepeatDetector.IsHolding();
+}
+
+void SWDAnalyzer::RecordCheckpoint()
+{
+    mCheckpoint.valid = true;
+    mCheckpoint.parser = mAddedCheckpoint;
+    mCheckpoint.repeat_history = mRepeatDetector.GetHistory();
+    mCheckpoint.num_frames = mResults->GetNumFrames();
+    mCheckpoint.num_markers = mNumMarkers;
+    mCheckpoint.num_commits = mNumCommits;
+}
+
+bool SWDAnalyzer::CanResume()
+{
+    if( !mCheckpoint.valid || mResults.get() == 0 )
+        return false;
+
+    // the frames after the checkpoint, which a run killed before committing them
+    // would have left, can't be taken back
+    return mCheckpoint.settings == mSettings.SaveSettings() && mResults->GetNumFrames() == mCheckpoint.num_frames;
+}
+
+bool SWDAnalyzer::IsCheckpointInCapture()
+{
+    const SWDParserCheckpoint& checkpoint = mCheckpoint.parser;
+
+    // the bits of the fingerprint have to have the same edges and levels
+    mSWCLK->AdvanceToAbsPosition( U64( checkpoint.first_rising ) );
+
+    SWDBit bit;
+    U64 fingerprint = 0;
+    for( U32 ndx = 0; ndx < checkpoint.num_fingerprint_bits; ++ndx )
+    {
+        if( !ReadCheckpointBit( bit ) )
+            return false;
+
+        fingerprint = SWDParserCheckpoint::AddToFingerprint( fingerprint, bit );
+    }
+
+    if( fingerprint != checkpoint.fingerprint )
+        return false;
+
+    // and so does the last bit, if it comes after them
+    if( bit.falling == checkpoint.resume_sample )
+        return true;
+
+    mSWCLK->AdvanceToAbsPosition( U64( checkpoint.last_rising ) );
+
+    return ReadCheckpointBit( bit ) && bit.rising == checkpoint.last_rising && bit.falling == checkpoint.resume_sample;
+}
+
+bool SWDAnalyzer::ReadCheckpointBit( SWDBit& bit )
+{
+    // SWCLK has to be low before the rising edge, as the sampler reads the bits
+    if( mSWCLK->GetBitState() != BIT_LOW )
+        return false;
+
+    bit.rising = S64( mSWCLK->GetSampleOfNextEdge() ) - 1;
+    mSWDIO->AdvanceToAbsPosition( U64( bit.rising ) );
+    bit.state_rising = mSWDIO->GetBitState();
+
+    mSWCLK->AdvanceToNextEdge();
+
+    bit.falling = S64( mSWCLK->GetSampleOfNextEdge() );
+    mSWDIO->AdvanceToAbsPosition( U64( bit.falling ) );
+    bit.state_falling = mSWDIO->GetBitState();
+
+    mSWCLK->AdvanceToNextEdge();
+
+    return true;
 }
 
 bool SWDAnalyzer::NeedsRerun()
 {
-    return false;
+    return mNeedsRerun;
 }
 
 U32 SWDAnalyzer::GenerateSimulationData( U64 minimum_sample_index, U32 device_sample_rate,
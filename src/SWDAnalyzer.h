@@ -1,15 +1,116 @@
 #ifndef SWD_ANALYZER_H
 #define SWD_ANALYZER_H
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+
 #include <Analyzer.h>
+#include <AnalyzerChannelData.h>
 
 #include "SWDAnalyzerSettings.h"
 #include "SWDAnalyzerResults.h"
 #include "SWDSimulationDataGenerator.h"
 
+#include "SWDBitQueue.h"
+#include "SWDBitSampler.h"
+#include "SWDChannel.h"
+#include "SWDParser.h"
+#include "SWDRepeatDetector.h"
 #include "SWDTypes.h"
 
-class SWDAnalyzer : public Analyzer2
+// the SDK's channel data as seen by SWDBitSampler
+class SWDAnalyzerChannel : public SWDChannel
+{
+  public:
+    SWDAnalyzerChannel() : mChannelData( 0 )
+    {
+    }
+
+    void SetChannelData( AnalyzerChannelData* channel_data )
+    {
+        mChannelData = channel_data;
+    }
+
+    virtual U64 GetSampleNumber()
+    {
+        return mChannelData->GetSampleNumber();
+    }
+    virtual BitState GetBitState()
+    {
+        return mChannelData->GetBitState();
+    }
+
+    virtual void AdvanceToNextEdge()
+    {
+        mChannelData->AdvanceToNextEdge();
+    }
+    virtual void AdvanceToAbsPosition( U64 sample )
+    {
+        mChannelData->AdvanceToAbsPosition( sample );
+    }
+
+    virtual U64 GetSampleOfNextEdge()
+    {
+        return mChannelData->GetSampleOfNextEdge();
+    }
+    virtual bool DoMoreTransitionsExistInCurrentData()
+    {
+        return mChannelData->DoMoreTransitionsExistInCurrentData();
+    }
+
+  private:
+    AnalyzerChannelData* mChannelData;
+};
+
+// What the analyzer has done in the current run, for the statistics export.
+struct SWDAnalyzerStats
+{
+    SWDParserStats parser;
+
+    U64 bits_sampled;
+
+    U64 frames;
+    U64 markers;
+    U64 commits;
+
+    // the commits of the current run, per second it has run
+    double commits_per_second;
+
+    // the samples between the sampler and the end of the last committed result,
+    // now and at the most
+    U64 decode_lag;
+    U64 peak_decode_lag;
+
+    // the sample the run carried on from, 0 if it decoded the capture from the start
+    U64 resumed_from;
+};
+
+// The end of the results committed so far. When the analyzer is run again
+// with the same settings, it keeps the results and carries on decoding
+// from here instead of from the start of the capture.
+struct SWDAnalyzerCheckpoint
+{
+    // false until something was committed
+    bool valid;
+
+    SWDParserCheckpoint parser;
+
+    // what the repeat detector compares the results after the checkpoint to
+    std::deque<SWDRepeatKey> repeat_history;
+
+    // the settings the results were decoded with, as saved
+    std::string settings;
+
+    // the results up to the checkpoint
+    U64 num_frames;
+    U64 num_markers;
+    U64 num_commits;
+};
+
+class SWDAnalyzer : public Analyzer2, public SWDParserListener, public SWDRepeatDetectorListener
 {
   public:
     SWDAnalyzer();
@@ -23,6 +124,73 @@ class SWDAnalyzer : public Analyzer2
     virtual const char* GetAnalyzerName() const;
     virtual bool NeedsRerun();
 
+    // SWDParserListener
+    virtual void OnOperation( SWDOperation& tran );
+    virtual void OnLineReset( SWDLineReset& reset );
+    virtual void OnDroppedBits( const SWDBitRun& bits );
+
+    // SWDRepeatDetectorListener
+    virtual void OnResults( SWDHeldResults& results );
+    virtual void OnRepeat( const SWDRepeat& repeat );
+
+    // a snapshot of the statistics, which can be taken while the analysis runs
+    SWDAnalyzerStats GetStats();
+
+  protected:
+    void DecoderThread();
+
+    // updates the snapshot returned by GetStats, on the decoder thread
+    void PublishStats();
+
+    // counts the operation, line reset or retries just added to the results,
+    // which the parser can resume after from checkpoint, and commits them if
+    // the settings say it's time
+    void ResultsAdded( U64 start_sample, U64 end_sample, const SWDParserCheckpoint& checkpoint );
+
+    // whether the settings coalesce the retries of this operation
+    bool IsCoalesced( const SWDOperation& tran ) const;
+
+    // adds the frame of the retries so far if there are two or more, or the
+    // frames of the one there is
+    void AddRetries();
+
+    // puts the frames and markers of the operation in results
+    void HoldOperation( SWDOperation& tran, SWDHeldResults& results );
+
+    // shows the results of an operation or of retries, or gives them to the
+    // repeat detector if the settings collapse repeats, which leaves them empty
+    void AddResults( SWDHeldResults& results );
+
+    // adds the retries, the repeat and the results the detector holds back,
+    // at a line reset, which ends them, and at the end of the run
+    void FlushResults();
+
+    // commits the results added since the last commit, if there are any,
+    // and records the checkpoint if nothing is held back
+    void Commit();
+
+    // commits without recording the checkpoint, returns false if there was nothing to commit
+    bool CommitResults();
+
+    // whether there are retries or results for the repeat detector held back
+    bool IsHolding() const;
+
+    // on the decoder thread, after each commit
+    void RecordCheckpoint();
+
+    // whether the results and the checkpoint can be kept for the next run
+    bool CanResume();
+
+    // whether the channel data has the bits of the checkpoint where they were
+    bool IsCheckpointInCapture();
+
+    // reads the next bit off the channels for IsCheckpointInCapture,
+    // returns false if SWCLK isn't low before it
+    bool ReadCheckpointBit( SWDBit& bit );
+
+    // replaces the results with empty ones
+    void NewResults();
+
   protected: // vars
     SWDAnalyzerSettings mSettings;
     std::auto_ptr<SWDAnalyzerResults> mResults;
@@ -30,10 +198,61 @@ class SWDAnalyzer : public Analyzer2
     AnalyzerChannelData* mSWDIO;
     AnalyzerChannelData* mSWCLK;
 
+    SWDAnalyzerChannel mSWDIOChannel;
+    SWDAnalyzerChannel mSWCLKChannel;
+
     SWDSimulationDataGenerator mSimulationDataGenerator;
 
+    // the bits go from the sampler on the worker thread
+    // through the queue to the parser on the decoder thread
+    SWDBitSampler mBitSampler;
+    SWDBitQueue mBitQueue;
     SWDParser mSWDParser;
 
+    // the sampler's progress, from the worker thread
+    std::atomic<U64> mBitsSampled;
+    std::atomic<U64> mSampledTo;
+
+    // the decoder thread's counters, and where its last committed result ends
+    U64 mNumCommits;
+    U64 mNumMarkers;
+    U64 mCommittedTo;
+
+    // the operations and line resets added since the last commit, where the
+    // first of them starts and where the last one ends
+    U64 mNumUncommitted;
+    U64 mUncommittedFrom;
+    U64 mAddedTo;
+    SWDParserCheckpoint mAddedCheckpoint;
+
+    // the retries waiting for the operation that ends them, and the markers of the first one
+    SWDRetryBurst mRetries;
+    SWDHeldResults mRetriesResults;
+
+    // the frames and markers of the first retry, until a second one makes them a burst
+    SWDHeldResults mFirstRetryResults;
+
+    // the frames and markers of the operation being added
+    SWDHeldResults mOperationResults;
+
+    // the frame of the line reset being added
+    SWDHeldResults mLineResetResults;
+
+    SWDRepeatDetector mRepeatDetector;
+
+    // when the decoder thread started, and the commits there were then
+    std::chrono::steady_clock::time_point mRunStart;
+    U64 mRunStartCommits;
+
+    std::mutex mStatsMutex;
+    SWDAnalyzerStats mStats;
+
+    // written by the decoder thread, and used by the next run once it's done
+    SWDAnalyzerCheckpoint mCheckpoint;
+
+    // set when the capture isn't the one the checkpoint was recorded in
+    bool mNeedsRerun;
+
     bool mSimulationInitilized;
 };
 
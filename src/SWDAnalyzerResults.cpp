@@ -1,12 +1,16 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
 
 #include <AnalyzerHelpers.h>
 
 #include "SWDAnalyzerResults.h"
 #include "SWDAnalyzer.h"
 #include "SWDAnalyzerSettings.h"
+#include "SWDTrace.h"
 #include "SWDUtils.h"
 
 SWDAnalyzerResults::SWDAnalyzerResults( SWDAnalyzer* analyzer, SWDAnalyzerSettings* settings )
@@ -36,6 +40,38 @@ std::string SWDAnalyzerResults::GetSampleTimeStr( S64 sample ) const
     return time_str;
 }
 
+// the ACK as the export and the compact frames show it
+static std::string GetACKName( U8 ACK )
+{
+    if( ACK == ACK_OK )
+        return "OK";
+    if( ACK == ACK_WAIT )
+        return "WAIT";
+    if( ACK == ACK_FAULT )
+        return "FAULT";
+
+    return "<disc>";
+}
+
+// how a repeat is shown, like "Previous 6 operations repeated 12 times"
+static std::string GetRepeatStr( const Frame& f )
+{
+    const std::string what( f.mData2 == 1 ? "Previous operation" : "Previous " + int2str( f.mData2 ) + " operations" );
+
+    return what + " repeated " + int2str( f.mData1 ) + ( f.mData1 == 1 ? " time" : " times" );
+}
+
+// how the retries are shown, like "WAIT x 12 (3.50 µs)"
+std::string SWDAnalyzerResults::GetRetriesStr( const SWDOperationFrame& op ) const
+{
+    const double stall_us = ( op.mEndingSampleInclusive - op.mStartingSampleInclusive + 1 ) * 1e6 / mAnalyzer->GetSampleRate();
+
+    std::ostringstream os;
+    os << GetACKName( op.GetACK() ) << " x " << op.GetCount() << " (" << std::fixed << std::setprecision( 2 ) << stall_us << " \xC2\xB5s)";
+
+    return os.str();
+}
+
 void SWDAnalyzerResults::GetBubbleText( const Frame& f, DisplayBase display_base, std::vector<std::string>& results )
 {
     results.clear();
@@ -127,6 +163,57 @@ void SWDAnalyzerResults::GetBubbleText( const Frame& f, DisplayBase display_base
         results.push_back( "Trailing bits" );
         results.push_back( "Trail" );
     }
+    else if( f.mType == SWDFT_Operation )
+    {
+        const SWDOperationFrame& op( ( const SWDOperationFrame& )f );
+
+        const std::string reg_name( op.GetRegisterName() );
+        const std::string ack_name( GetACKName( op.GetACK() ) );
+        const std::string op_str( std::string( op.IsAccessPort() ? "AccessPort" : "DebugPort" ) + ( op.IsRead() ? " Read " : " Write " ) +
+                                  reg_name + " " + ack_name );
+        const std::string short_str( std::string( op.IsAccessPort() ? "AP" : "DP" ) + ( op.IsRead() ? " R " : " W " ) + reg_name );
+
+        if( op.HasData() )
+        {
+            std::string data_str( int2str_sal( op.GetData(), display_base, 32 ) );
+            if( !op.IsDataParityOK() )
+                data_str += " parity NOT OK";
+
+            std::string reg_value( GetRegisterValueDesc( op.GetRegister(), op.GetData(), display_base ) );
+
+            if( !reg_value.empty() )
+                results.push_back( op_str + " " + data_str + " bits " + reg_value );
+            results.push_back( op_str + " " + data_str );
+            results.push_back( short_str + " " + data_str );
+        }
+        else
+            results.push_back( op_str );
+
+        results.push_back( short_str + " " + ack_name );
+        results.push_back( short_str );
+        results.push_back( ack_name );
+    }
+    else if( f.mType == SWDFT_Retries )
+    {
+        const SWDOperationFrame& op( ( const SWDOperationFrame& )f );
+
+        const std::string reg_name( op.GetRegisterName() );
+        const std::string retries_str( GetRetriesStr( op ) );
+        const std::string count_str( GetACKName( op.GetACK() ) + " x " + int2str( op.GetCount() ) );
+
+        results.push_back( std::string( op.IsAccessPort() ? "AccessPort" : "DebugPort" ) + ( op.IsRead() ? " Read " : " Write " ) + reg_name +
+                           " " + retries_str );
+        results.push_back( std::string( op.IsAccessPort() ? "AP" : "DP" ) + ( op.IsRead() ? " R " : " W " ) + reg_name + " " + count_str );
+        results.push_back( retries_str );
+        results.push_back( count_str );
+        results.push_back( GetACKName( op.GetACK() ) );
+    }
+    else if( f.mType == SWDFT_Repeat )
+    {
+        results.push_back( GetRepeatStr( f ) );
+        results.push_back( "Repeat x " + int2str( f.mData1 ) );
+        results.push_back( "x " + int2str( f.mData1 ) );
+    }
     else
     {
         std::string msg;
@@ -191,8 +278,21 @@ void SaveRecord( std::vector<std::string>& rec, std::ofstream& of )
 
 void SWDAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
 {
+    if( export_type_user_id == SWDET_Trace )
+    {
+        std::string error;
+        SWDTrace::WriteChromeTrace( file, error );
+        return;
+    }
+
     std::ofstream of( file, std::ios::out );
 
+    if( export_type_user_id == SWDET_Statistics )
+    {
+        GenerateStatsFile( of );
+        return;
+    }
+
     U64 trigger_sample = mAnalyzer->GetTriggerSample();
     U32 sample_rate = mAnalyzer->GetSampleRate();
 
@@ -246,6 +346,36 @@ void SWDAnalyzerResults::GenerateExportFile( const char* file, DisplayBase displ
 
             SaveRecord( record, of );
         }
+        else if( f.mType == SWDFT_Operation || f.mType == SWDFT_Retries )
+        {
+            SaveRecord( record, of );
+
+            SWDOperationFrame& op( ( SWDOperationFrame& )f );
+            record.push_back( GetSampleTimeStr( f.mStartingSampleInclusive ) );
+            record.push_back( "Operation" );
+            record.push_back( op.IsRead() ? "read" : "write" );
+            record.push_back( op.IsAccessPort() ? "AccessPort" : "DebugPort" );
+            record.push_back( op.GetRegisterName() );
+            record.push_back( int2str_sal( op.GetRequestByte(), display_base, 8 ) );
+            record.push_back( f.mType == SWDFT_Retries ? GetRetriesStr( op ) : GetACKName( op.GetACK() ) );
+
+            if( op.HasData() )
+            {
+                record.push_back( int2str_sal( op.GetData(), display_base, 32 ) );
+                record.push_back( GetRegisterValueDesc( op.GetRegister(), op.GetData(), display_base ) );
+            }
+
+            SaveRecord( record, of );
+        }
+        else if( f.mType == SWDFT_Repeat )
+        {
+            SaveRecord( record, of );
+
+            record.push_back( GetSampleTimeStr( f.mStartingSampleInclusive ) );
+            record.push_back( "Repeat" );
+            record.push_back( GetRepeatStr( f ) );
+            SaveRecord( record, of );
+        }
 
         if( UpdateExportProgressAndCheckForCancel( fcnt, num_frames ) )
             return;
@@ -254,6 +384,34 @@ void SWDAnalyzerResults::GenerateExportFile( const char* file, DisplayBase displ
     UpdateExportProgressAndCheckForCancel( num_frames, num_frames );
 }
 
+void SWDAnalyzerResults::GenerateStatsFile( std::ostream& of )
+{
+    const SWDAnalyzerStats stats = mAnalyzer->GetStats();
+    const SWDParserStats& parser = stats.parser;
+
+    of << "bits sampled\t" << stats.bits_sampled << "\n"
+       << "bits parsed\t" << parser.bits_fed << "\n"
+       << "bits dropped\t" << parser.bits_dropped << "\n"
+       << "operation attempts\t" << parser.operation_attempts << "\n"
+       << "operations\t" << parser.operations << "\n"
+       << "invalid requests\t" << parser.invalid_requests << "\n"
+       << "data parity errors\t" << parser.data_parity_errors << "\n"
+       << "ACK OK\t" << parser.acks[ ACK_OK ] << "\n"
+       << "ACK WAIT\t" << parser.acks[ ACK_WAIT ] << "\n"
+       << "ACK FAULT\t" << parser.acks[ ACK_FAULT ] << "\n"
+       << "ACK invalid\t" << parser.acks[ 0 ] + parser.acks[ 3 ] + parser.acks[ 5 ] + parser.acks[ 6 ] + parser.acks[ 7 ] << "\n"
+       << "line resets\t" << parser.line_resets << "\n"
+       << "buffered bits\t" << parser.buffered_bits << "\n"
+       << "peak buffered bits\t" << parser.peak_buffered_bits << "\n"
+       << "frames\t" << stats.frames << "\n"
+       << "markers\t" << stats.markers << "\n"
+       << "commits\t" << stats.commits << "\n"
+       << "commits per second\t" << stats.commits_per_second << "\n"
+       << "decode lag (samples)\t" << stats.decode_lag << "\n"
+       << "peak decode lag (samples)\t" << stats.peak_decode_lag << "\n"
+       << "resumed from sample\t" << stats.resumed_from << std::endl;
+}
+
 void SWDAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
 {
     ClearTabularText();
@@ -1,10 +1,13 @@
 #ifndef SWD_ANALYZER_RESULTS_H
 #define SWD_ANALYZER_RESULTS_H
 
+#include <iosfwd>
+
 #include <AnalyzerResults.h>
 
 class SWDAnalyzer;
 class SWDAnalyzerSettings;
+struct SWDOperationFrame;
 
 class SWDAnalyzerResults : public AnalyzerResults
 {
@@ -29,6 +32,10 @@ class SWDAnalyzerResults : public AnalyzerResults
 
   protected: // functions
     void GetBubbleText( const Frame& f, DisplayBase display_base, std::vector<std::string>& results );
+    std::string GetRetriesStr( const SWDOperationFrame& op ) const;
+
+    // the analyzer's counters so far, one per line
+    void GenerateStatsFile( std::ostream& of );
 
   protected: // vars
     SWDAnalyzerSettings* mSettings;
@@ -4,7 +4,21 @@
 #include "SWDAnalyzerResults.h"
 #include "SWDTypes.h"
 
-SWDAnalyzerSettings::SWDAnalyzerSettings() : mSWDIO( UNDEFINED_CHANNEL ), mSWCLK( UNDEFINED_CHANNEL )
+// The commits are few enough on bulk traffic with these, and a live capture
+// still shows its results after a few milliseconds at the usual sample rates.
+const U32 DEFAULT_COMMIT_OPERATIONS = 1000;
+const U32 DEFAULT_COMMIT_SAMPLES = 1000000;
+
+SWDAnalyzerSettings::SWDAnalyzerSettings()
+    : mSWDIO( UNDEFINED_CHANNEL ),
+      mSWCLK( UNDEFINED_CHANNEL ),
+      mCommitOperations( DEFAULT_COMMIT_OPERATIONS ),
+      mCommitSamples( DEFAULT_COMMIT_SAMPLES ),
+      mCommitWhenCaughtUp( true ),
+      mMarkerDensity( SWDMD_Full ),
+      mCompactFrames( false ),
+      mRetryCoalescing( SWDRC_None ),
+      mCollapseRepeats( false )
 {
     // init the interface
     mSWDIOInterface.SetTitleAndTooltip( "SWDIO", "SWDIO" );
@@ -13,13 +27,67 @@ SWDAnalyzerSettings::SWDAnalyzerSettings() : mSWDIO( UNDEFINED_CHANNEL ), mSWCLK
     mSWCLKInterface.SetTitleAndTooltip( "SWCLK", "SWCLK" );
     mSWCLKInterface.SetChannel( mSWCLK );
 
+    mCommitOperationsInterface.SetTitleAndTooltip( "Commit every N operations",
+                                                   "Show the decoded results after this many operations, 0 for no limit" );
+    mCommitOperationsInterface.SetMin( 0 );
+    mCommitOperationsInterface.SetMax( 1000000000 );
+    mCommitOperationsInterface.SetInteger( int( mCommitOperations ) );
+
+    mCommitSamplesInterface.SetTitleAndTooltip( "Commit every N samples",
+                                                "Show the decoded results once they span this many samples, 0 for no limit" );
+    mCommitSamplesInterface.SetMin( 0 );
+    mCommitSamplesInterface.SetMax( 2000000000 );
+    mCommitSamplesInterface.SetInteger( int( mCommitSamples ) );
+
+    mCommitWhenCaughtUpInterface.SetTitleAndTooltip( "", "Show the decoded results whenever the decoder has caught up with the capture" );
+    mCommitWhenCaughtUpInterface.SetCheckBoxText( "Commit when caught up" );
+    mCommitWhenCaughtUpInterface.SetValue( mCommitWhenCaughtUp );
+
+    mMarkerDensityInterface.SetTitleAndTooltip( "Bit markers", "Which bits of the operations are marked on SWCLK" );
+    mMarkerDensityInterface.AddNumber( SWDMD_Full, "All bits", "A marker for every bit of every operation" );
+    mMarkerDensityInterface.AddNumber( SWDMD_Turnarounds, "Turnarounds only", "A marker for the turnaround bits only" );
+    mMarkerDensityInterface.AddNumber( SWDMD_Errors, "WAIT and FAULT operations only",
+                                       "A marker for every bit of the operations that didn't get an OK" );
+    mMarkerDensityInterface.AddNumber( SWDMD_None, "None", "No markers, which saves the most memory on long captures" );
+    mMarkerDensityInterface.SetNumber( mMarkerDensity );
+
+    mCompactFramesInterface.SetTitleAndTooltip( "", "A single frame for each operation instead of one for each of its fields" );
+    mCompactFramesInterface.SetCheckBoxText( "One frame per operation" );
+    mCompactFramesInterface.SetValue( mCompactFrames );
+
+    mRetryCoalescingInterface.SetTitleAndTooltip( "Retries", "Which operations repeated with the same request get a single frame" );
+    mRetryCoalescingInterface.AddNumber( SWDRC_None, "A frame for each", "The retried operations get their frames like any other" );
+    mRetryCoalescingInterface.AddNumber( SWDRC_Wait, "One frame for WAITs in a row", "With the number of retries and the time they took" );
+    mRetryCoalescingInterface.AddNumber( SWDRC_WaitAndFault, "One frame for WAITs or FAULTs in a row",
+                                         "With the number of retries and the time they took" );
+    mRetryCoalescingInterface.SetNumber( mRetryCoalescing );
+
+    mCollapseRepeatsInterface.SetTitleAndTooltip( "", "A single frame for the copies of operations that repeat, like the ones of a poll loop" );
+    mCollapseRepeatsInterface.SetCheckBoxText( "Collapse repeated sequences" );
+    mCollapseRepeatsInterface.SetValue( mCollapseRepeats );
+
     // add the interface
     AddInterface( &mSWDIOInterface );
     AddInterface( &mSWCLKInterface );
+    AddInterface( &mCommitOperationsInterface );
+    AddInterface( &mCommitSamplesInterface );
+    AddInterface( &mCommitWhenCaughtUpInterface );
+    AddInterface( &mMarkerDensityInterface );
+    AddInterface( &mCompactFramesInterface );
+    AddInterface( &mRetryCoalescingInterface );
+    AddInterface( &mCollapseRepeatsInterface );
 
     // describe export
-    AddExportOption( 0, "Export as text file" );
-    AddExportExtension( 0, "text", "txt" );
+    AddExportOption( SWDET_Text, "Export as text file" );
+    AddExportExtension( SWDET_Text, "text", "txt" );
+
+    AddExportOption( SWDET_Statistics, "Export decoder statistics" );
+    AddExportExtension( SWDET_Statistics, "text", "txt" );
+
+#ifdef SWD_TRACE
+    AddExportOption( SWDET_Trace, "Export decoder trace" );
+    AddExportExtension( SWDET_Trace, "Chrome trace", "json" );
+#endif
 
     ClearChannels();
 
@@ -54,6 +122,14 @@ bool SWDAnalyzerSettings::SetSettingsFromInterfaces()
         return false;
     }
 
+    mCommitOperations = U32( mCommitOperationsInterface.GetInteger() );
+    mCommitSamples = U32( mCommitSamplesInterface.GetInteger() );
+    mCommitWhenCaughtUp = mCommitWhenCaughtUpInterface.GetValue();
+    mMarkerDensity = SWDMarkerDensity( U32( mMarkerDensityInterface.GetNumber() ) );
+    mCompactFrames = mCompactFramesInterface.GetValue();
+    mRetryCoalescing = SWDRetryCoalescing( U32( mRetryCoalescingInterface.GetNumber() ) );
+    mCollapseRepeats = mCollapseRepeatsInterface.GetValue();
+
     ClearChannels();
 
     AddChannel( mSWDIO, "SWDIO", true );
@@ -66,6 +142,14 @@ void SWDAnalyzerSettings::UpdateInterfacesFromSettings()
 {
     mSWDIOInterface.SetChannel( mSWDIO );
     mSWCLKInterface.SetChannel( mSWCLK );
+
+    mCommitOperationsInterface.SetInteger( int( mCommitOperations ) );
+    mCommitSamplesInterface.SetInteger( int( mCommitSamples ) );
+    mCommitWhenCaughtUpInterface.SetValue( mCommitWhenCaughtUp );
+    mMarkerDensityInterface.SetNumber( mMarkerDensity );
+    mCompactFramesInterface.SetValue( mCompactFrames );
+    mRetryCoalescingInterface.SetNumber( mRetryCoalescing );
+    mCollapseRepeatsInterface.SetValue( mCollapseRepeats );
 }
 
 void SWDAnalyzerSettings::LoadSettings( const char* settings )
@@ -76,6 +160,34 @@ void SWDAnalyzerSettings::LoadSettings( const char* settings )
     text_archive >> mSWDIO;
     text_archive >> mSWCLK;
 
+    // the settings saved before there was a commit policy keep the defaults
+    if( !( text_archive >> mCommitOperations ) || !( text_archive >> mCommitSamples ) || !( text_archive >> mCommitWhenCaughtUp ) )
+    {
+        mCommitOperations = DEFAULT_COMMIT_OPERATIONS;
+        mCommitSamples = DEFAULT_COMMIT_SAMPLES;
+        mCommitWhenCaughtUp = true;
+    }
+
+    // and the ones saved before the marker density setting have all the markers
+    U32 marker_density;
+    if( text_archive >> marker_density && marker_density < SWDMD_Count )
+        mMarkerDensity = SWDMarkerDensity( marker_density );
+    else
+        mMarkerDensity = SWDMD_Full;
+
+    if( !( text_archive >> mCompactFrames ) )
+        mCompactFrames = false;
+
+    // and the ones saved before retry coalescing show every retry
+    U32 retry_coalescing;
+    if( text_archive >> retry_coalescing && retry_coalescing < SWDRC_Count )
+        mRetryCoalescing = SWDRetryCoalescing( retry_coalescing );
+    else
+        mRetryCoalescing = SWDRC_None;
+
+    if( !( text_archive >> mCollapseRepeats ) )
+        mCollapseRepeats = false;
+
     ClearChannels();
 
     AddChannel( mSWDIO, "SWDIO", true );
@@ -90,6 +202,13 @@ const char* SWDAnalyzerSettings::SaveSettings()
 
     text_archive << mSWDIO;
     text_archive << mSWCLK;
+    text_archive << mCommitOperations;
+    text_archive << mCommitSamples;
+    text_archive << mCommitWhenCaughtUp;
+    text_archive << U32( mMarkerDensity );
+    text_archive << mCompactFrames;
+    text_archive << U32( mRetryCoalescing );
+    text_archive << mCollapseRepeats;
 
     return SetReturnString( text_archive.GetString() );
 }
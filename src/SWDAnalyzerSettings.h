@@ -6,6 +6,35 @@
 
 #include "SWDTypes.h"
 
+// the export options, by their user id
+enum SWDExportTypes
+{
+    SWDET_Text,
+    SWDET_Statistics, // the decoder's counters, see SWDAnalyzerStats
+    SWDET_Trace,      // the decoder's timing spans, in builds with SWD_TRACE
+};
+
+// which of the operations' bits get a marker on SWCLK
+enum SWDMarkerDensity
+{
+    SWDMD_Full,        // every bit, with its value or an X for turnarounds
+    SWDMD_Turnarounds, // only the turnarounds
+    SWDMD_Errors,      // every bit of the operations that weren't OK
+    SWDMD_None,
+
+    SWDMD_Count,
+};
+
+// which retried operations in a row get a single frame
+enum SWDRetryCoalescing
+{
+    SWDRC_None,
+    SWDRC_Wait,
+    SWDRC_WaitAndFault,
+
+    SWDRC_Count,
+};
+
 class SWDAnalyzerSettings : public AnalyzerSettings
 {
   public:
@@ -21,9 +50,35 @@ class SWDAnalyzerSettings : public AnalyzerSettings
     Channel mSWDIO;
     Channel mSWCLK;
 
+    // When the decoder commits the results it added: after this many operations
+    // and line resets, once they span this many samples, or when it has decoded
+    // all of the capture there is so far. 0 turns a limit off.
+    U32 mCommitOperations;
+    U32 mCommitSamples;
+    bool mCommitWhenCaughtUp;
+
+    SWDMarkerDensity mMarkerDensity;
+
+    // one SWDOperationFrame per operation instead of a frame for each of its fields
+    bool mCompactFrames;
+
+    SWDRetryCoalescing mRetryCoalescing;
+
+    // one frame for the copies of operations that repeat right after themselves, see SWDRepeatDetector
+    bool mCollapseRepeats;
+
   protected:
     AnalyzerSettingInterfaceChannel mSWDIOInterface;
     AnalyzerSettingInterfaceChannel mSWCLKInterface;
+
+    AnalyzerSettingInterfaceInteger mCommitOperationsInterface;
+    AnalyzerSettingInterfaceInteger mCommitSamplesInterface;
+    AnalyzerSettingInterfaceBool mCommitWhenCaughtUpInterface;
+
+    AnalyzerSettingInterfaceNumberList mMarkerDensityInterface;
+    AnalyzerSettingInterfaceBool mCompactFramesInterface;
+    AnalyzerSettingInterfaceNumberList mRetryCoalescingInterface;
+    AnalyzerSettingInterfaceBool mCollapseRepeatsInterface;
 };
 
 #endif // SWD_ANALYZER_SETTINGS_H
\ No newline at end of file
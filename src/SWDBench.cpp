@@ -0,0 +1,787 @@
+// swd_bench: measures how fast the decoder gets through a few typical streams.
+//
+// Each workload is built in memory by SWDStreamBuilder, the same way every
+// time, and decoded several times, of which the fastest run counts. The
+// results can be written as JSON, and a file written that way can be given
+// as the baseline of a later run, which then fails if a workload got slower
+// than the tolerance allows. The sampling is also timed against sampling the
+// bits one at a time, the way the parser did before SWDBitSampler.
+// Build it with CMAKE_BUILD_TYPE=Release, or the numbers say little.
+// Run it with --help for the usage.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SWDBitSampler.h"
+#include "SWDParser.h"
+#include "SWDStreamBuilder.h"
+#include "SWDTypes.h"
+
+// the number of bits sampled and fed to the parser in one go, as swd_decode does
+const size_t BENCH_BATCH_BITS = 1024;
+
+// ********************************************************************************
+
+// every allocation made by the process, to tell whether parsing makes any
+static std::atomic<U64> gNumAllocations( 0 );
+
+void* operator new( size_t size )
+{
+    ++gNumAllocations;
+
+    void* ptr = malloc( size != 0 ? size : 1 );
+    if( ptr == 0 )
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void operator delete( void* ptr ) noexcept
+{
+    free( ptr );
+}
+
+// ********************************************************************************
+
+// the workloads, which are built with scale times their nominal size
+static void BuildCleanDRWBurst( SWDStreamBuilder& builder, U32 scale )
+{
+    std::mt19937 rng( 1 );
+
+    builder.SetClockPeriod( 4 );
+    builder.LineReset();
+    builder.Operation( false, true, 0x0, ACK_OK, 0x0BB11477 ); // IDCODE
+    builder.Idle( 2 );
+    builder.Operation( false, false, 0x8, ACK_OK, 0 ); // SELECT
+    builder.Idle( 2 );
+    builder.Operation( true, false, 0x0, ACK_OK, 0x23000012 ); // CSW
+    builder.Idle( 2 );
+    builder.Operation( true, false, 0x4, ACK_OK, 0x20000000 ); // TAR
+    builder.Idle( 2 );
+
+    for( U32 ndx = 0; ndx < 20000 * scale; ++ndx )
+    {
+        builder.Operation( true, false, 0xC, ACK_OK, U32( rng() ) ); // DRW
+        builder.Idle( 2 );
+    }
+}
+
+static void BuildNoisyResync( SWDStreamBuilder& builder, U32 scale )
+{
+    std::mt19937 rng( 2 );
+
+    builder.SetClockPeriod( 8 );
+
+    for( U32 ndx = 0; ndx < 10000 * scale; ++ndx )
+    {
+        // garbage between most of the operations, which the parser has to drop
+        if( rng() % 4 != 0 )
+        {
+            const size_t num_bits = 1 + rng() % 48;
+            for( size_t bndx = 0; bndx < num_bits; ++bndx )
+                builder.Bit( rng() & 1 ? BIT_HIGH : BIT_LOW );
+        }
+
+        builder.Operation( true, rng() & 1, U8( ( rng() % 4 ) << 2 ), ACK_OK, U32( rng() ) );
+        builder.Idle( rng() % 4 );
+    }
+}
+
+static void BuildLongIdle( SWDStreamBuilder& builder, U32 scale )
+{
+    std::mt19937 rng( 3 );
+
+    builder.SetClockPeriod( 8 );
+    builder.LineReset();
+
+    for( U32 ndx = 0; ndx < 200 * scale; ++ndx )
+    {
+        builder.Operation( true, true, 0xC, ACK_OK, U32( rng() ) );
+        builder.Idle( 5000 );
+    }
+}
+
+static void BuildWaitStorms( SWDStreamBuilder& builder, U32 scale )
+{
+    std::mt19937 rng( 4 );
+
+    builder.SetClockPeriod( 8 );
+    builder.LineReset();
+
+    for( U32 ndx = 0; ndx < 1000 * scale; ++ndx )
+    {
+        // the target keeps answering WAIT until the read is done
+        const U32 num_waits = 10 + rng() % 40;
+        for( U32 wndx = 0; wndx < num_waits; ++wndx )
+        {
+            builder.Operation( true, true, 0xC, ACK_WAIT, 0 );
+            builder.Idle( 2 );
+        }
+
+        builder.Operation( true, true, 0xC, ACK_OK, U32( rng() ) );
+        builder.Idle( 2 );
+    }
+}
+
+static void BuildLineResetConnects( SWDStreamBuilder& builder, U32 scale )
+{
+    builder.SetClockPeriod( 8 );
+
+    for( U32 ndx = 0; ndx < 3000 * scale; ++ndx )
+    {
+        // line reset, the JTAG to SWD sequence, line reset and reading IDCODE
+        builder.LineReset();
+        builder.Bits( 0xE79E, 16 );
+        builder.LineReset();
+        builder.Operation( false, true, 0x0, ACK_OK, 0x0BB11477 );
+        builder.Idle( 8 );
+    }
+}
+
+// Reads and writes at period samples per SWCLK period, i.e. sampled at period
+// times the SWD clock, which is what batching the SWCLK edges pays off for.
+static void BuildOversampled( SWDStreamBuilder& builder, U32 scale, U32 period )
+{
+    std::mt19937 rng( 6 );
+
+    builder.SetClockPeriod( period );
+    builder.LineReset();
+
+    for( U32 ndx = 0; ndx < 20000 * scale; ++ndx )
+    {
+        builder.Operation( true, rng() % 4 == 0, 0xC, ACK_OK, U32( rng() ) ); // DRW
+        builder.Idle( 2 + rng() % 8 );
+    }
+}
+
+static void BuildOversampled10x( SWDStreamBuilder& builder, U32 scale )
+{
+    BuildOversampled( builder, scale, 10 );
+}
+
+static void BuildOversampled100x( SWDStreamBuilder& builder, U32 scale )
+{
+    BuildOversampled( builder, scale, 100 );
+}
+
+struct SWDBenchWorkload
+{
+    const char* name;
+    void ( *build )( SWDStreamBuilder& builder, U32 scale );
+};
+
+static const SWDBenchWorkload WORKLOADS[] = {
+    { "clean_drw_burst", BuildCleanDRWBurst },
+    { "noisy_resync", BuildNoisyResync },
+    { "long_idle", BuildLongIdle },
+    { "wait_storms", BuildWaitStorms },
+    { "line_reset_connects", BuildLineResetConnects },
+    { "oversampled_10x", BuildOversampled10x },
+    { "oversampled_100x", BuildOversampled100x },
+};
+
+// ********************************************************************************
+
+// counts what the parser finds
+class SWDBenchListener : public SWDParserListener
+{
+  public:
+    SWDBenchListener() : mNumOperations( 0 ), mNumLineResets( 0 )
+    {
+    }
+
+    virtual void OnOperation( SWDOperation& /* tran */ )
+    {
+        ++mNumOperations;
+    }
+    virtual void OnLineReset( SWDLineReset& /* reset */ )
+    {
+        ++mNumLineResets;
+    }
+    virtual void OnDroppedBits( const SWDBitRun& /* bits */ )
+    {
+    }
+
+    U64 mNumOperations;
+    U64 mNumLineResets;
+};
+
+struct SWDBenchResult
+{
+    U64 bits;
+    U64 operations;
+    U64 line_resets;
+
+    // sampling and parsing, like swd_decode
+    double bits_per_s;
+    double ops_per_s;
+
+    // parsing the bits already sampled
+    double parse_ns_per_bit;
+    double ns_per_attempt;
+    double attempts_per_op;
+
+    // made while parsing, in all the runs
+    U64 parse_allocations;
+    double allocs_per_op;
+    U64 peak_buffered_bits;
+
+    // how much faster SWDBitSampler samples the bits than sampling them one at a time
+    double sampling_speedup;
+};
+
+typedef std::chrono::steady_clock SWDBenchClock;
+
+static double SecondsSince( SWDBenchClock::time_point start )
+{
+    return std::chrono::duration<double>( SWDBenchClock::now() - start ).count();
+}
+
+// samples and parses the whole stream, returns the time it took
+static double Decode( SWDStreamBuilder& builder, SWDBenchListener& listener )
+{
+    std::unique_ptr<SWDChannel> swdio( builder.OpenSWDIO() );
+    std::unique_ptr<SWDChannel> swclk( builder.OpenSWCLK() );
+
+    std::vector<SWDBit> bits( BENCH_BATCH_BITS );
+    SWDBitSampler sampler;
+    SWDParser parser;
+    parser.Setup( &listener );
+
+    const SWDBenchClock::time_point start = SWDBenchClock::now();
+
+    sampler.Setup( swdio.get(), swclk.get() );
+    parser.Clear();
+
+    try
+    {
+        for( ;; )
+        {
+            size_t num_bits = sampler.SampleBits( &bits[ 0 ], bits.size() );
+            parser.Feed( &bits[ 0 ], num_bits );
+        }
+    }
+    catch( SWDEndOfCapture& )
+    {
+        // there are no more whole bits in the capture
+    }
+
+    parser.Flush();
+
+    return SecondsSince( start );
+}
+
+// Samples the bits the way the parser did before SWDBitSampler, moving both
+// cursors for each bit, and returns the time it took. It's only kept to tell
+// how much faster SWDBitSampler is.
+static double SampleBitsPerBit( SWDStreamBuilder& builder, std::vector<SWDBit>& bits )
+{
+    std::unique_ptr<SWDChannel> swdio( builder.OpenSWDIO() );
+    std::unique_ptr<SWDChannel> swclk( builder.OpenSWCLK() );
+
+    const SWDBenchClock::time_point start = SWDBenchClock::now();
+
+    size_t num_bits = 0;
+    try
+    {
+        for( ; num_bits < bits.size(); ++num_bits )
+        {
+            SWDBit& bit = bits[ num_bits ];
+
+            bit.low_start = swclk->GetSampleNumber();
+
+            // sample the rising edge 1 sample before the the actual
+            swclk->AdvanceToAbsPosition( swclk->GetSampleOfNextEdge() - 1 );
+            swdio->AdvanceToAbsPosition( swclk->GetSampleNumber() );
+            bit.rising = swclk->GetSampleNumber();
+            bit.state_rising = swdio->GetBitState();
+            swclk->AdvanceToNextEdge();
+            swdio->AdvanceToAbsPosition( swclk->GetSampleNumber() );
+
+            // go to the falling edge
+            swclk->AdvanceToNextEdge();
+            swdio->AdvanceToAbsPosition( swclk->GetSampleNumber() );
+            bit.falling = swclk->GetSampleNumber();
+            bit.state_falling = swdio->GetBitState();
+
+            bit.low_end = swclk->GetSampleOfNextEdge();
+        }
+    }
+    catch( SWDEndOfCapture& )
+    {
+        // the last bit has no rising edge after it
+    }
+
+    return SecondsSince( start );
+}
+
+// samples all the bits with SWDBitSampler, returns the time it took
+static double SampleBits( SWDStreamBuilder& builder, std::vector<SWDBit>& bits )
+{
+    std::unique_ptr<SWDChannel> swdio( builder.OpenSWDIO() );
+    std::unique_ptr<SWDChannel> swclk( builder.OpenSWCLK() );
+
+    const SWDBenchClock::time_point start = SWDBenchClock::now();
+
+    SWDBitSampler sampler;
+    sampler.Setup( swdio.get(), swclk.get() );
+
+    size_t num_bits = 0;
+    try
+    {
+        while( num_bits < bits.size() )
+            num_bits += sampler.SampleBits( &bits[ num_bits ], std::min( BENCH_BATCH_BITS, bits.size() - num_bits ) );
+    }
+    catch( SWDEndOfCapture& )
+    {
+        // the last bit has no rising edge after it
+    }
+
+    const double seconds = SecondsSince( start );
+    bits.resize( num_bits );
+
+    return seconds;
+}
+
+// parses the bits, returns the time it took and adds the allocations it made
+static double Parse( const std::vector<SWDBit>& bits, SWDParser& parser, U64& num_allocations )
+{
+    const U64 allocations_before = gNumAllocations;
+    const SWDBenchClock::time_point start = SWDBenchClock::now();
+
+    parser.Clear();
+    for( size_t ndx = 0; ndx < bits.size(); ndx += BENCH_BATCH_BITS )
+        parser.Feed( &bits[ ndx ], std::min( BENCH_BATCH_BITS, bits.size() - ndx ) );
+    parser.Flush();
+
+    const double seconds = SecondsSince( start );
+    num_allocations += gNumAllocations - allocations_before;
+
+    return seconds;
+}
+
+// the time it takes to read the clock, which timing the attempts adds to each one
+static double GetClockOverheadNs()
+{
+    const int num_reads = 1000000;
+
+    const SWDBenchClock::time_point start = SWDBenchClock::now();
+    for( int ndx = 0; ndx < num_reads; ++ndx )
+        SWDBenchClock::now();
+
+    return SecondsSince( start ) * 1e9 / num_reads;
+}
+
+static SWDBenchResult RunWorkload( const SWDBenchWorkload& workload, U32 scale, int repeat, double clock_overhead_ns )
+{
+    SWDStreamBuilder builder;
+    workload.build( builder, scale );
+
+    SWDBenchResult result = SWDBenchResult();
+    result.bits = builder.GetNumBits();
+
+    // the whole decode, the fastest run counts
+    double best_decode = 0;
+    for( int ndx = 0; ndx < repeat; ++ndx )
+    {
+        SWDBenchListener listener;
+        const double seconds = Decode( builder, listener );
+        if( ndx == 0 || seconds < best_decode )
+            best_decode = seconds;
+
+        result.operations = listener.mNumOperations;
+        result.line_resets = listener.mNumLineResets;
+    }
+
+    // the sampling alone, either way, which leaves the bits for parsing them over and over
+    std::vector<SWDBit> bits;
+    double best_sample = 0;
+    double best_sample_per_bit = 0;
+    for( int ndx = 0; ndx < repeat; ++ndx )
+    {
+        bits.resize( result.bits );
+        const double seconds_per_bit = SampleBitsPerBit( builder, bits );
+        if( ndx == 0 || seconds_per_bit < best_sample_per_bit )
+            best_sample_per_bit = seconds_per_bit;
+
+        bits.resize( result.bits );
+        const double seconds = SampleBits( builder, bits );
+        if( ndx == 0 || seconds < best_sample )
+            best_sample = seconds;
+    }
+
+    SWDBenchListener listener;
+    SWDParser parser;
+    parser.Setup( &listener );
+
+    // the parser is set up by now, so parsing allocates nothing, not even the first time
+    double best_parse = 0;
+    for( int ndx = 0; ndx < repeat; ++ndx )
+    {
+        const double seconds = Parse( bits, parser, result.parse_allocations );
+        if( ndx == 0 || seconds < best_parse )
+            best_parse = seconds;
+    }
+
+    result.peak_buffered_bits = parser.GetStats().peak_buffered_bits;
+
+    // once more, timing the operation attempts
+    parser.SetTimeAttempts( true );
+    Parse( bits, parser, result.parse_allocations );
+
+    const SWDParserStats& stats = parser.GetStats();
+    const double ops = double( result.operations != 0 ? result.operations : 1 );
+
+    result.bits_per_s = result.bits / best_decode;
+    result.ops_per_s = result.operations / best_decode;
+    result.parse_ns_per_bit = best_parse * 1e9 / bits.size();
+    if( stats.operation_attempts != 0 )
+        result.ns_per_attempt = std::max( 0.0, double( stats.operation_attempt_ns ) / stats.operation_attempts - clock_overhead_ns );
+    result.attempts_per_op = stats.operation_attempts / ops;
+    result.sampling_speedup = best_sample_per_bit / best_sample;
+    result.allocs_per_op = result.parse_allocations / ( ops * ( repeat + 1 ) );
+
+    return result;
+}
+
+// ********************************************************************************
+
+typedef std::map<std::string, std::map<std::string, double> > SWDBenchBaseline;
+
+static void WriteJson( std::ostream& os, const std::vector<std::string>& names, const std::vector<SWDBenchResult>& results )
+{
+    os << "{\n  \"workloads\": {\n";
+
+    for( size_t ndx = 0; ndx < results.size(); ++ndx )
+    {
+        const SWDBenchResult& r = results[ ndx ];
+
+        os << "    \"" << names[ ndx ] << "\": {\n"
+           << "      \"bits\": " << r.bits << ",\n"
+           << "      \"operations\": " << r.operations << ",\n"
+           << "      \"line_resets\": " << r.line_resets << ",\n"
+           << "      \"bits_per_s\": " << r.bits_per_s << ",\n"
+           << "      \"ops_per_s\": " << r.ops_per_s << ",\n"
+           << "      \"parse_ns_per_bit\": " << r.parse_ns_per_bit << ",\n"
+           << "      \"ns_per_attempt\": " << r.ns_per_attempt << ",\n"
+           << "      \"attempts_per_op\": " << r.attempts_per_op << ",\n"
+           << "      \"allocs_per_op\": " << r.allocs_per_op << ",\n"
+           << "      \"peak_buffered_bits\": " << r.peak_buffered_bits << ",\n"
+           << "      \"sampling_speedup\": " << r.sampling_speedup << "\n"
+           << "    }" << ( ndx + 1 < results.size() ? "," : "" ) << "\n";
+    }
+
+    os << "  }\n}\n";
+}
+
+// Reads the JSON written by WriteJson. Only the objects, strings and
+// numbers it writes are understood, which is all a baseline needs.
+class SWDBenchJsonReader
+{
+  public:
+    SWDBenchJsonReader( const std::string& text ) : mText( text ), mPos( 0 )
+    {
+    }
+
+    bool Read( SWDBenchBaseline& baseline )
+    {
+        std::string key;
+        if( !Skip( '{' ) || !ReadString( key ) || key != "workloads" || !Skip( ':' ) || !Skip( '{' ) )
+            return false;
+
+        if( Peek() == '}' )
+            return true;
+
+        do
+        {
+            std::string name;
+            if( !ReadString( name ) || !Skip( ':' ) || !Skip( '{' ) )
+                return false;
+
+            do
+            {
+                double value;
+                if( !ReadString( key ) || !Skip( ':' ) || !ReadNumber( value ) )
+                    return false;
+
+                baseline[ name ][ key ] = value;
+            } while( Skip( ',' ) );
+
+            if( !Skip( '}' ) )
+                return false;
+        } while( Skip( ',' ) );
+
+        return Skip( '}' ) && Skip( '}' );
+    }
+
+  private:
+    char Peek()
+    {
+        while( mPos < mText.size() && isspace( ( unsigned char )mText[ mPos ] ) )
+            ++mPos;
+
+        return mPos < mText.size() ? mText[ mPos ] : '\0';
+    }
+
+    bool Skip( char c )
+    {
+        if( Peek() != c )
+            return false;
+
+        ++mPos;
+        return true;
+    }
+
+    bool ReadString( std::string& str )
+    {
+        if( !Skip( '"' ) )
+            return false;
+
+        const size_t end = mText.find( '"', mPos );
+        if( end == std::string::npos )
+            return false;
+
+        str = mText.substr( mPos, end - mPos );
+        mPos = end + 1;
+
+        return true;
+    }
+
+    bool ReadNumber( double& value )
+    {
+        Peek();
+
+        const char* start = mText.c_str() + mPos;
+        char* end;
+        value = strtod( start, &end );
+        mPos += size_t( end - start );
+
+        return end != start;
+    }
+
+    const std::string& mText;
+    size_t mPos;
+};
+
+static bool ReadBaseline( const std::string& path, SWDBenchBaseline& baseline, std::string& error )
+{
+    std::ifstream is( path.c_str() );
+    if( !is )
+    {
+        error = "can't open " + path;
+        return false;
+    }
+
+    std::stringstream text;
+    text << is.rdbuf();
+
+    if( !SWDBenchJsonReader( text.str() ).Read( baseline ) )
+    {
+        error = path + " is not a baseline written by --json";
+        return false;
+    }
+
+    return true;
+}
+
+// Prints the workloads that are slower than the baseline allows, returns their number.
+// Both the whole decode and the parsing alone are checked.
+static int CheckBaseline( const SWDBenchBaseline& baseline, double tolerance, const std::vector<std::string>& names,
+                          const std::vector<SWDBenchResult>& results )
+{
+    int num_regressions = 0;
+
+    for( size_t ndx = 0; ndx < results.size(); ++ndx )
+    {
+        SWDBenchBaseline::const_iterator bi = baseline.find( names[ ndx ] );
+        if( bi == baseline.end() )
+        {
+            std::cerr << names[ ndx ] << ": not in the baseline" << std::endl;
+            continue;
+        }
+
+        const std::map<std::string, double>& base = bi->second;
+        const SWDBenchResult& r = results[ ndx ];
+
+        std::map<std::string, double>::const_iterator vi = base.find( "bits_per_s" );
+        if( vi != base.end() && r.bits_per_s < vi->second * ( 1 - tolerance ) )
+        {
+            std::cerr << names[ ndx ] << ": decoding at " << r.bits_per_s / 1e6 << " Mbit/s, the baseline is " << vi->second / 1e6
+                      << " Mbit/s" << std::endl;
+            ++num_regressions;
+        }
+
+        vi = base.find( "parse_ns_per_bit" );
+        if( vi != base.end() && r.parse_ns_per_bit > vi->second / ( 1 - tolerance ) )
+        {
+            std::cerr << names[ ndx ] << ": parsing at " << r.parse_ns_per_bit << " ns/bit, the baseline is " << vi->second
+                      << " ns/bit" << std::endl;
+            ++num_regressions;
+        }
+    }
+
+    return num_regressions;
+}
+
+// ********************************************************************************
+
+static void PrintUsage()
+{
+    std::cerr << "usage: swd_bench [options]\n"
+                 "\n"
+                 "Decodes generated streams and reports how fast it went.\n"
+                 "\n"
+                 "options:\n"
+                 "  --workload NAME       run this workload only, can be given more than once\n"
+                 "  --list                list the workloads\n"
+                 "  --scale N             make the workloads N times longer, 1 by default\n"
+                 "  --repeat N            decode each workload N times, the fastest run counts; 5 by default\n"
+                 "  --json FILE           write the results to FILE, which can be the baseline of later runs\n"
+                 "  --baseline FILE       fail if a workload is slower than in FILE by more than the tolerance\n"
+                 "  --tolerance PERCENT   10 by default\n"
+                 "  --check-allocations   fail if parsing a workload allocates\n";
+}
+
+int main( int argc, char* argv[] )
+{
+    U32 scale = 1;
+    int repeat = 5;
+    double tolerance = 0.1;
+    bool check_allocations = false;
+    std::string json_file;
+    std::string baseline_file;
+    std::vector<std::string> selected;
+
+    const size_t num_workloads = sizeof( WORKLOADS ) / sizeof( WORKLOADS[ 0 ] );
+
+    for( int ndx = 1; ndx < argc; ++ndx )
+    {
+        const std::string arg = argv[ ndx ];
+        const bool has_value = ndx + 1 < argc;
+
+        if( arg == "--workload" && has_value )
+            selected.push_back( argv[ ++ndx ] );
+        else if( arg == "--scale" && has_value )
+            scale = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--repeat" && has_value )
+            repeat = atoi( argv[ ++ndx ] );
+        else if( arg == "--json" && has_value )
+            json_file = argv[ ++ndx ];
+        else if( arg == "--baseline" && has_value )
+            baseline_file = argv[ ++ndx ];
+        else if( arg == "--tolerance" && has_value )
+            tolerance = strtod( argv[ ++ndx ], 0 ) / 100;
+        else if( arg == "--check-allocations" )
+            check_allocations = true;
+        else if( arg == "--list" )
+        {
+            for( size_t wndx = 0; wndx < num_workloads; ++wndx )
+                std::cout << WORKLOADS[ wndx ].name << "\n";
+            return 0;
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if( scale == 0 || repeat <= 0 || tolerance < 0 || tolerance >= 1 )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<const SWDBenchWorkload*> workloads;
+    for( size_t wndx = 0; wndx < num_workloads; ++wndx )
+    {
+        bool is_selected = selected.empty();
+        for( size_t sndx = 0; sndx < selected.size(); ++sndx )
+            is_selected |= selected[ sndx ] == WORKLOADS[ wndx ].name;
+
+        if( is_selected )
+            workloads.push_back( &WORKLOADS[ wndx ] );
+    }
+
+    if( workloads.size() < selected.size() )
+    {
+        std::cerr << "unknown workload, see --list" << std::endl;
+        return 2;
+    }
+
+    // read the baseline first, so a bad one doesn't waste a run
+    SWDBenchBaseline baseline;
+    if( !baseline_file.empty() )
+    {
+        std::string error;
+        if( !ReadBaseline( baseline_file, baseline, error ) )
+        {
+            std::cerr << error << std::endl;
+            return 2;
+        }
+    }
+
+    const double clock_overhead_ns = GetClockOverheadNs();
+
+    std::vector<std::string> names;
+    std::vector<SWDBenchResult> results;
+
+    printf( "%-20s %10s %8s %9s %9s %8s %11s %9s %10s %11s\n", "workload", "bits", "ops", "Mbit/s", "kop/s", "ns/bit", "ns/attempt",
+            "allocs/op", "peak bits", "vs per-bit" );
+
+    for( size_t wndx = 0; wndx < workloads.size(); ++wndx )
+    {
+        const SWDBenchResult r = RunWorkload( *workloads[ wndx ], scale, repeat, clock_overhead_ns );
+
+        printf( "%-20s %10llu %8llu %9.2f %9.1f %8.2f %11.2f %9.3f %10llu %10.2fx\n", workloads[ wndx ]->name, r.bits, r.operations,
+                r.bits_per_s / 1e6, r.ops_per_s / 1e3, r.parse_ns_per_bit, r.ns_per_attempt, r.allocs_per_op, r.peak_buffered_bits,
+                r.sampling_speedup );
+        fflush( stdout );
+
+        names.push_back( workloads[ wndx ]->name );
+        results.push_back( r );
+    }
+
+    if( !json_file.empty() )
+    {
+        std::ofstream of( json_file.c_str(), std::ios::out );
+        if( !of )
+        {
+            std::cerr << "can't create " << json_file << std::endl;
+            return 1;
+        }
+
+        WriteJson( of, names, results );
+    }
+
+    int ret_val = 0;
+    if( !baseline_file.empty() && CheckBaseline( baseline, tolerance, names, results ) != 0 )
+        ret_val = 1;
+
+    if( check_allocations )
+    {
+        for( size_t ndx = 0; ndx < results.size(); ++ndx )
+        {
+            if( results[ ndx ].parse_allocations != 0 )
+            {
+                std::cerr << names[ ndx ] << ": parsing allocated " << results[ ndx ].parse_allocations << " times" << std::endl;
+                ret_val = 1;
+            }
+        }
+    }
+
+    return ret_val;
+}
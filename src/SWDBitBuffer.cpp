@@ -0,0 +1,152 @@
+#include <cassert>
+
+#include <utility>
+
+#include "SWDBitBuffer.h"
+
+S64 SWDBit::GetMinStartEnd() const
+{
+    S64 s = ( rising - low_start ) / 2;
+    S64 e = ( low_end - falling ) / 2;
+    return s < e ? s : e;
+}
+
+S64 SWDBit::GetStartSample() const
+{
+    return rising - GetMinStartEnd() + 1;
+}
+
+S64 SWDBit::GetEndSample() const
+{
+    return falling + GetMinStartEnd() - 1;
+}
+
+// ********************************************************************************
+
+void SWDBitBlock::Reset( S64 new_base )
+{
+    rising_levels = falling_levels = wide_mask = 0;
+    base = new_base;
+    wide.clear();
+}
+
+void SWDBitBlock::SetBit( size_t slot, const SWDBit& bit )
+{
+    const U64 mask = 1ULL << slot;
+
+    if( bit.state_rising == BIT_HIGH )
+        rising_levels |= mask;
+    if( bit.state_falling == BIT_HIGH )
+        falling_levels |= mask;
+
+    // do the timestamps fit in 32 bits?
+    const S64 max_delta = 0xffffffffLL;
+    if( bit.low_start >= base && bit.low_end - base <= max_delta && bit.low_start <= bit.rising && bit.rising <= bit.falling &&
+        bit.falling <= bit.low_end )
+    {
+        low_start[ slot ] = U32( bit.low_start - base );
+        rising[ slot ] = U32( bit.rising - base );
+        falling[ slot ] = U32( bit.falling - base );
+        low_end[ slot ] = U32( bit.low_end - base );
+    }
+    else
+    {
+        WideTimes wt = { bit.low_start, bit.rising, bit.falling, bit.low_end };
+        wide.push_back( wt );
+        wide_mask |= mask;
+    }
+}
+
+SWDBit SWDBitBlock::GetBit( size_t slot ) const
+{
+    const U64 mask = 1ULL << slot;
+
+    SWDBit bit;
+    bit.state_rising = ( rising_levels & mask ) != 0 ? BIT_HIGH : BIT_LOW;
+    bit.state_falling = ( falling_levels & mask ) != 0 ? BIT_HIGH : BIT_LOW;
+
+    if( ( wide_mask & mask ) == 0 )
+    {
+        bit.low_start = base + low_start[ slot ];
+        bit.rising = base + rising[ slot ];
+        bit.falling = base + falling[ slot ];
+        bit.low_end = base + low_end[ slot ];
+    }
+    else
+    {
+        // the wide entries are stored in slot order
+        const WideTimes& wt = wide[ PopCount64( wide_mask & ( mask - 1 ) ) ];
+        bit.low_start = wt.low_start;
+        bit.rising = wt.rising;
+        bit.falling = wt.falling;
+        bit.low_end = wt.low_end;
+    }
+
+    return bit;
+}
+
+// ********************************************************************************
+
+// Must be a power of two. SWDParser keeps the bits of the operation it's
+// about to pass on and the idle bits after it, up to its lookahead, and buffers
+// up to the lookahead past them, which spans at most 5 blocks, so a parser
+// never makes it grow.
+const size_t BITS_BUFFER_INITIAL_BLOCKS = 8;
+
+SWDBitBuffer::SWDBitBuffer()
+    : mBlocks( BITS_BUFFER_INITIAL_BLOCKS ), mBlockMask( BITS_BUFFER_INITIAL_BLOCKS - 1 ), mKeep( 0 ), mHead( 0 ), mTail( 0 )
+{
+}
+
+U64 SWDBitBuffer::GetLevels( size_t ndx, U64 SWDBitBlock::*levels ) const
+{
+    const size_t size = Size();
+    if( ndx >= size )
+        return 0;
+
+    U64 pos = mHead + ndx;
+    size_t slot = size_t( pos & ( SWDBitBlock::NUM_BITS - 1 ) );
+
+    U64 ret_val = GetBlock( pos ).*levels >> slot;
+    if( slot != 0 && size - ndx > SWDBitBlock::NUM_BITS - slot )
+        ret_val |= GetBlock( pos + SWDBitBlock::NUM_BITS ).*levels << ( SWDBitBlock::NUM_BITS - slot );
+
+    // clear the positions past the end of the buffer
+    if( size - ndx < SWDBitBlock::NUM_BITS )
+        ret_val &= ( 1ULL << ( size - ndx ) ) - 1;
+
+    return ret_val;
+}
+
+void SWDBitBuffer::AddTo( SWDBitRun& run, size_t ndx, size_t num_bits ) const
+{
+    assert( ndx + num_bits <= Size() );
+
+    if( num_bits == 0 )
+        return;
+
+    // only the ends of the run are stored
+    if( run.Empty() )
+        run.first = ( *this )[ ndx ];
+
+    run.last = ( *this )[ ndx + num_bits - 1 ];
+    run.count += num_bits;
+}
+
+void SWDBitBuffer::Grow()
+{
+    // move the blocks in use to their slots in a ring twice the size
+    std::vector<SWDBitBlock> new_blocks( mBlocks.size() * 2 );
+    const size_t new_mask = new_blocks.size() - 1;
+
+    for( U64 bndx = mKeep >> SWDBitBlock::SHIFT; bndx < ( ( mTail + SWDBitBlock::NUM_BITS - 1 ) >> SWDBitBlock::SHIFT ); ++bndx )
+    {
+        SWDBitBlock& src = mBlocks[ size_t( bndx ) & mBlockMask ];
+        SWDBitBlock& dst = new_blocks[ size_t( bndx ) & new_mask ];
+
+        std::swap( dst, src );
+    }
+
+    mBlocks.swap( new_blocks );
+    mBlockMask = new_mask;
+}
@@ -0,0 +1,322 @@
+#ifndef SWD_BIT_BUFFER_H
+#define SWD_BIT_BUFFER_H
+
+#include <vector>
+
+#include <LogicPublicTypes.h>
+#include <AnalyzerResults.h>
+
+inline int PopCount64( U64 val )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_popcountll( val );
+#else
+    // the POPCNT instruction might not be there, see SWDDataPhase.cpp
+    val = val - ( ( val >> 1 ) & 0x5555555555555555ULL );
+    val = ( val & 0x3333333333333333ULL ) + ( ( val >> 2 ) & 0x3333333333333333ULL );
+    val = ( val + ( val >> 4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+    return int( ( val * 0x0101010101010101ULL ) >> 56 );
+#endif
+}
+
+// the number of trailing zero bits, 64 if val is zero
+inline int CountTrailingZeros64( U64 val )
+{
+    return PopCount64( ( val & ( ~val + 1 ) ) - 1 );
+}
+
+// the number of leading zero bits, 64 if val is zero
+inline int CountLeadingZeros64( U64 val )
+{
+    // smear the highest one into all the lower bits
+    val |= val >> 1;
+    val |= val >> 2;
+    val |= val >> 4;
+    val |= val >> 8;
+    val |= val >> 16;
+    val |= val >> 32;
+    return 64 - PopCount64( val );
+}
+
+// this is the basic token of the analyzer
+// objects of this type are buffered in SWDOperation
+struct SWDBit
+{
+    BitState state_rising;
+    BitState state_falling;
+
+    S64 low_start;
+    S64 rising;
+    S64 falling;
+    S64 low_end;
+
+    bool IsHigh( bool is_rising = true ) const
+    {
+        return ( is_rising ? state_rising : state_falling ) == BIT_HIGH;
+    }
+
+    S64 GetMinStartEnd() const;
+    S64 GetStartSample() const;
+    S64 GetEndSample() const;
+
+    Frame MakeFrame();
+};
+
+// A run of consecutive bits stored as a single record, used for the idle
+// bits after an operation and for line resets which can be arbitrarily long.
+// Only the first and the last bit are kept, so the memory used doesn't
+// depend on the length of the run.
+struct SWDBitRun
+{
+    BitState level;
+    U64 count;
+
+    SWDBit first;
+    SWDBit last;
+
+    void Clear( BitState run_level )
+    {
+        level = run_level;
+        count = 0;
+    }
+
+    bool Empty() const
+    {
+        return count == 0;
+    }
+
+    void Add( const SWDBit& bit )
+    {
+        if( count == 0 )
+            first = bit;
+
+        last = bit;
+        ++count;
+    }
+
+    S64 GetStartSample() const
+    {
+        return first.GetStartSample();
+    }
+    S64 GetEndSample() const
+    {
+        return last.GetEndSample();
+    }
+};
+
+// 64 consecutive bits stored as a structure of arrays.
+// The rising and falling edge levels are packed one bit per SWD clock.
+// The timestamps are stored as 32 bit deltas from the block's base sample.
+// The rare bits which don't fit (i.e. after SWCLK was idle for a very long
+// time) have their timestamps stored in full in the wide vector.
+struct SWDBitBlock
+{
+    enum
+    {
+        NUM_BITS = 64,
+        SHIFT = 6,
+    };
+
+    U64 rising_levels;
+    U64 falling_levels;
+
+    // bits with their timestamps in the wide vector
+    U64 wide_mask;
+
+    S64 base;
+
+    U32 low_start[ NUM_BITS ];
+    U32 rising[ NUM_BITS ];
+    U32 falling[ NUM_BITS ];
+    U32 low_end[ NUM_BITS ];
+
+    struct WideTimes
+    {
+        S64 low_start;
+        S64 rising;
+        S64 falling;
+        S64 low_end;
+    };
+
+    std::vector<WideTimes> wide;
+
+    void Reset( S64 new_base );
+    void SetBit( size_t slot, const SWDBit& bit );
+    SWDBit GetBit( size_t slot ) const;
+};
+
+class SWDBitView;
+
+// Circular buffer of bits used by SWDParser to hold the bits that have
+// been read from the channels but not consumed yet.
+// Bits are addressed by their absolute position in the stream, which maps
+// them to a fixed block and slot. Popping from the front, consuming a number
+// of bits and indexing are all O(1). The number of blocks is always a power of
+// two and only grows when a bit is pushed into a full buffer.
+// Consumed bits stay in place until ReleaseConsumed is called, so that views
+// of them handed out to the operations remain valid until then.
+class SWDBitBuffer
+{
+  public:
+    SWDBitBuffer();
+
+    size_t Size() const
+    {
+        return size_t( mTail - mHead );
+    }
+    bool Empty() const
+    {
+        return mTail == mHead;
+    }
+
+    void Clear()
+    {
+        mKeep = mHead = mTail = 0;
+    }
+
+    SWDBit operator[]( size_t ndx ) const
+    {
+        return GetBitAt( mHead + ndx );
+    }
+
+    // the bit at an absolute stream position
+    SWDBit GetBitAt( U64 pos ) const
+    {
+        return GetBlock( pos ).GetBit( size_t( pos & ( SWDBitBlock::NUM_BITS - 1 ) ) );
+    }
+
+    SWDBit Front() const
+    {
+        return ( *this )[ 0 ];
+    }
+    SWDBit Back() const
+    {
+        return ( *this )[ Size() - 1 ];
+    }
+
+    // the levels of up to 64 bits starting at ndx, one bit per SWD clock;
+    // the positions past the end of the buffer are zero
+    U64 GetRisingLevels( size_t ndx ) const
+    {
+        return GetLevels( ndx, &SWDBitBlock::rising_levels );
+    }
+    U64 GetFallingLevels( size_t ndx ) const
+    {
+        return GetLevels( ndx, &SWDBitBlock::falling_levels );
+    }
+
+    void PushBack( const SWDBit& bit )
+    {
+        size_t slot = size_t( mTail & ( SWDBitBlock::NUM_BITS - 1 ) );
+
+        // make room for a new block if we're about to start one
+        if( slot == 0 && ( mTail >> SWDBitBlock::SHIFT ) - ( mKeep >> SWDBitBlock::SHIFT ) > mBlockMask )
+            Grow();
+
+        SWDBitBlock& block = GetBlock( mTail );
+        if( slot == 0 )
+            block.Reset( bit.low_start );
+
+        block.SetBit( slot, bit );
+        ++mTail;
+    }
+
+    void PopFront()
+    {
+        Consume( 1 );
+    }
+
+    // removes num_bits bits from the front of the buffer
+    void Consume( size_t num_bits )
+    {
+        mHead += num_bits;
+    }
+
+    // lets the storage of the consumed bits be reused, which invalidates all views
+    void ReleaseConsumed()
+    {
+        mKeep = mHead;
+    }
+
+    // a view of num_bits bits starting at ndx, valid until ReleaseConsumed or Clear
+    SWDBitView View( size_t ndx, size_t num_bits ) const;
+
+    // adds the bits from ndx to ndx + num_bits to the run
+    void AddTo( SWDBitRun& run, size_t ndx, size_t num_bits ) const;
+
+  private:
+    SWDBitBlock& GetBlock( U64 pos )
+    {
+        return mBlocks[ size_t( pos >> SWDBitBlock::SHIFT ) & mBlockMask ];
+    }
+    const SWDBitBlock& GetBlock( U64 pos ) const
+    {
+        return mBlocks[ size_t( pos >> SWDBitBlock::SHIFT ) & mBlockMask ];
+    }
+
+    U64 GetLevels( size_t ndx, U64 SWDBitBlock::*levels ) const;
+
+    void Grow();
+
+    std::vector<SWDBitBlock> mBlocks;
+    size_t mBlockMask;
+
+    // absolute stream positions of the first bit still stored,
+    // the first bit not consumed and one past the last bit
+    U64 mKeep;
+    U64 mHead;
+    U64 mTail;
+};
+
+// A lightweight view of bits owned by an SWDBitBuffer.
+class SWDBitView
+{
+  public:
+    SWDBitView() : mBuffer( 0 ), mFirst( 0 ), mSize( 0 )
+    {
+    }
+
+    SWDBitView( const SWDBitBuffer* buffer, U64 first, size_t size ) : mBuffer( buffer ), mFirst( first ), mSize( size )
+    {
+    }
+
+    size_t Size() const
+    {
+        return mSize;
+    }
+    bool Empty() const
+    {
+        return mSize == 0;
+    }
+
+    void Clear()
+    {
+        mSize = 0;
+    }
+
+    SWDBit operator[]( size_t ndx ) const
+    {
+        return mBuffer->GetBitAt( mFirst + ndx );
+    }
+
+    SWDBit Front() const
+    {
+        return ( *this )[ 0 ];
+    }
+    SWDBit Back() const
+    {
+        return ( *this )[ mSize - 1 ];
+    }
+
+  private:
+    const SWDBitBuffer* mBuffer;
+    U64 mFirst;
+    size_t mSize;
+};
+
+inline SWDBitView SWDBitBuffer::View( size_t ndx, size_t num_bits ) const
+{
+    return SWDBitView( this, mHead + ndx, num_bits );
+}
+
+#endif // SWD_BIT_BUFFER_H
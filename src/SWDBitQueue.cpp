@@ -0,0 +1,106 @@
+#include "SWDBitQueue.h"
+
+// the number of batches in the queue
+const size_t BIT_QUEUE_BATCHES = 16;
+
+SWDBitQueue::SWDBitQueue() : mBatches( BIT_QUEUE_BATCHES )
+{
+    Reset();
+}
+
+void SWDBitQueue::Reset()
+{
+    mPushed = 0;
+    mPopped = 0;
+
+    mClosed = false;
+    mAborted = false;
+    mError = std::exception_ptr();
+
+    mProducerWaiting = false;
+    mConsumerWaiting = false;
+}
+
+SWDBitBatch& SWDBitQueue::GetFreeBatch()
+{
+    const U64 pushed = mPushed.load();
+
+    if( pushed - mPopped.load() == mBatches.size() || mAborted.load() )
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+
+        mProducerWaiting = true;
+        while( pushed - mPopped.load() == mBatches.size() && !mAborted.load() )
+            mCondition.wait( lock );
+        mProducerWaiting = false;
+
+        if( mAborted.load() )
+            std::rethrow_exception( mError );
+    }
+
+    return mBatches[ size_t( pushed % mBatches.size() ) ];
+}
+
+void SWDBitQueue::Push()
+{
+    ++mPushed;
+    WakeUp( mConsumerWaiting );
+}
+
+void SWDBitQueue::Close()
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    mClosed = true;
+    mCondition.notify_all();
+}
+
+void SWDBitQueue::Abort( std::exception_ptr error )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    mError = error;
+    mAborted = true;
+    mCondition.notify_all();
+}
+
+const SWDBitBatch& SWDBitQueue::GetFullBatch()
+{
+    const U64 popped = mPopped.load();
+
+    if( mPushed.load() == popped )
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+
+        mConsumerWaiting = true;
+        while( mPushed.load() == popped && !mClosed.load() )
+            mCondition.wait( lock );
+        mConsumerWaiting = false;
+
+        // the producer closes the queue only after its last push
+        if( mPushed.load() == popped )
+            throw SWDBitQueueClosed();
+    }
+
+    return mBatches[ size_t( popped % mBatches.size() ) ];
+}
+
+void SWDBitQueue::Pop()
+{
+    // hand the batch back to the producer, which we only wake up
+    // once half the queue is free so that it's not woken for every batch
+    const U64 popped = ++mPopped;
+    if( mPushed.load() - popped <= mBatches.size() / 2 )
+        WakeUp( mProducerWaiting );
+}
+
+void SWDBitQueue::WakeUp( std::atomic<bool>& waiting )
+{
+    // the waiting flag and the counters are sequentially consistent, so either
+    // the other thread sees our update before going to sleep, or we see its flag
+    if( waiting.load() )
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mCondition.notify_all();
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef SWD_BIT_QUEUE_H
+#define SWD_BIT_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDBitBuffer.h"
+
+// the bits sampled in one go, passed from the sampling thread to the decoding thread
+struct SWDBitBatch
+{
+    enum
+    {
+        MAX_BITS = 256,
+    };
+
+    size_t num_bits;
+    SWDBit bits[ MAX_BITS ];
+
+    // the capture had no more SWCLK edges after these bits when they were sampled
+    bool at_capture_head;
+};
+
+// thrown by SWDBitQueue::GetFullBatch when the queue is closed and empty
+struct SWDBitQueueClosed
+{
+};
+
+// Bounded single producer, single consumer queue of bit batches.
+// The batches are preallocated and handed back and forth by two atomic
+// counters, so the common case takes no locks. A thread only takes the mutex
+// to go to sleep when the queue is empty or full, and the other thread only
+// takes it to wake up a sleeper.
+class SWDBitQueue
+{
+  public:
+    SWDBitQueue();
+
+    // must only be called while neither thread is running
+    void Reset();
+
+    // producer side: fill the batch from GetFreeBatch, then Push it
+    // GetFreeBatch rethrows the exception the consumer stopped with, if any
+    SWDBitBatch& GetFreeBatch();
+    void Push();
+
+    // producer side: no more batches will be pushed, the consumer drains the
+    // queue and then gets SWDBitQueueClosed
+    void Close();
+
+    // consumer side: read the batch from GetFullBatch, then Pop it
+    const SWDBitBatch& GetFullBatch();
+    void Pop();
+
+    // consumer side: the consumer stopped with an exception, which is passed to the producer
+    void Abort( std::exception_ptr error );
+
+  private:
+    void WakeUp( std::atomic<bool>& waiting );
+
+    std::vector<SWDBitBatch> mBatches;
+
+    // counts of the batches pushed and popped so far
+    std::atomic<U64> mPushed;
+    std::atomic<U64> mPopped;
+
+    std::atomic<bool> mClosed;
+    std::atomic<bool> mAborted;
+    std::exception_ptr mError;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::atomic<bool> mProducerWaiting;
+    std::atomic<bool> mConsumerWaiting;
+};
+
+#endif // SWD_BIT_QUEUE_H
@@ -0,0 +1,97 @@
+#include "SWDBitSampler.h"
+
+SWDBitSampler::SWDBitSampler()
+    : mSWDIO( 0 ), mSWCLK( 0 ), mLowStart( 0 ), mSWDIOState( BIT_LOW ), mSWDIONextEdge( 0 ), mSWDIONextEdgeKnown( false )
+{
+}
+
+void SWDBitSampler::Setup( SWDChannel* pSWDIO, SWDChannel* pSWCLK )
+{
+    mSWDIO = pSWDIO;
+    mSWCLK = pSWCLK;
+
+    // skip the SWCLK high
+    if( mSWCLK->GetBitState() == BIT_HIGH )
+    {
+        mSWCLK->AdvanceToNextEdge();
+        mSWDIO->AdvanceToAbsPosition( mSWCLK->GetSampleNumber() );
+    }
+
+    mEdges.clear();
+
+    mLowStart = mSWCLK->GetSampleNumber();
+
+    mSWDIOState = mSWDIO->GetBitState();
+    mSWDIONextEdgeKnown = false;
+}
+
+void SWDBitSampler::ReadClockEdge()
+{
+    mSWCLK->AdvanceToNextEdge();
+    mEdges.push_back( mSWCLK->GetSampleNumber() );
+}
+
+size_t SWDBitSampler::SampleBits( SWDBit* bits, size_t max_bits )
+{
+    const size_t max_edges = max_bits * 2 + 1;
+
+    // A bit needs its rising and falling edge, and the next rising edge
+    // which ends the low period. Take as many edges as the capture already
+    // has, but wait for at least the ones the next bit needs.
+    while( mEdges.size() < max_edges && mSWCLK->DoMoreTransitionsExistInCurrentData() )
+        ReadClockEdge();
+    while( mEdges.size() < 3 )
+        ReadClockEdge();
+
+    const size_t num_bits = ( mEdges.size() - 1 ) / 2;
+
+    for( size_t bndx = 0; bndx < num_bits; ++bndx )
+    {
+        SWDBit& bit = bits[ bndx ];
+
+        bit.low_start = mLowStart;
+
+        // sample the rising edge 1 sample before the the actual
+        bit.rising = mEdges[ bndx * 2 ] - 1;
+        bit.state_rising = SampleSWDIO( bit.rising );
+
+        bit.falling = mEdges[ bndx * 2 + 1 ];
+        bit.state_falling = SampleSWDIO( bit.falling );
+
+        bit.low_end = mEdges[ bndx * 2 + 2 ];
+
+        mLowStart = bit.falling;
+    }
+
+    // keep the edges of the bits we haven't sampled
+    mEdges.erase( mEdges.begin(), mEdges.begin() + num_bits * 2 );
+
+    return num_bits;
+}
+
+BitState SWDBitSampler::SampleSWDIO( S64 sample )
+{
+    for( ;; )
+    {
+        if( !mSWDIONextEdgeKnown )
+        {
+            if( !mSWDIO->DoMoreTransitionsExistInCurrentData() )
+            {
+                // nothing to look ahead to, so sample the channel where we need it
+                mSWDIO->AdvanceToAbsPosition( sample );
+                mSWDIOState = mSWDIO->GetBitState();
+                return mSWDIOState;
+            }
+
+            mSWDIONextEdge = mSWDIO->GetSampleOfNextEdge();
+            mSWDIONextEdgeKnown = true;
+        }
+
+        if( mSWDIONextEdge > sample )
+            return mSWDIOState;
+
+        mSWDIO->AdvanceToNextEdge();
+        mSWDIOState = mSWDIOState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+        mSWDIONextEdgeKnown = false;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef SWD_BIT_SAMPLER_H
+#define SWD_BIT_SAMPLER_H
+
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDBitBuffer.h"
+#include "SWDChannel.h"
+
+// Turns the SWCLK and SWDIO channels into bits.
+// SWCLK edges are read in batches into a contiguous array, then SWDIO is
+// sampled at all the positions the batch needs in one forward sweep that
+// only moves the SWDIO cursor from edge to edge. The number of channel calls
+// depends on the number of edges, not on the oversampling ratio.
+// The bits come out in batches, which SWDAnalyzer hands over to the decoding thread.
+// A batch only takes the edges which are already in the capture, so we never
+// wait for more data than reading the bits one at a time would.
+class SWDBitSampler
+{
+  public:
+    SWDBitSampler();
+
+    void Setup( SWDChannel* pSWDIO, SWDChannel* pSWCLK );
+
+    // samples at least one and at most max_bits bits into bits,
+    // returns the number of bits sampled
+    size_t SampleBits( SWDBit* bits, size_t max_bits );
+
+    // the SWCLK falling edge of the last bit sampled
+    S64 GetSampleNumber() const
+    {
+        return mLowStart;
+    }
+
+    // whether the bits sampled so far took all the SWCLK edges the capture has yet
+    bool IsAtCaptureHead()
+    {
+        return !mSWCLK->DoMoreTransitionsExistInCurrentData();
+    }
+
+  private:
+    void ReadClockEdge();
+    BitState SampleSWDIO( S64 sample );
+
+    SWDChannel* mSWDIO;
+    SWDChannel* mSWCLK;
+
+    // SWCLK edges read but not turned into bits yet, starting with a rising edge
+    std::vector<S64> mEdges;
+
+    // the SWCLK falling edge before the next bit
+    S64 mLowStart;
+
+    // SWDIO level at the cursor and the next edge if we've looked it up
+    BitState mSWDIOState;
+    S64 mSWDIONextEdge;
+    bool mSWDIONextEdgeKnown;
+};
+
+#endif // SWD_BIT_SAMPLER_H
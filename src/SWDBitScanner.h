@@ -0,0 +1,97 @@
+#ifndef SWD_BIT_SCANNER_H
+#define SWD_BIT_SCANNER_H
+
+#include <LogicPublicTypes.h>
+
+#include "SWDBitBuffer.h"
+
+// Tests 64 bit offsets of the sampled SWDIO levels at once.
+// The levels are a 128 bit shift register made of two words, lo holding the
+// bits at the offsets being tested and hi holding the lookahead bits.
+// Bit n of a returned mask is set if the offset n passes the test.
+struct SWDBitScanner
+{
+    // number of ones a line reset needs
+    enum
+    {
+        LINE_RESET_BITS = 50,
+    };
+
+    struct Levels
+    {
+        U64 lo;
+        U64 hi;
+
+        Levels ShiftDown( unsigned cnt ) const
+        {
+            Levels ret_val;
+            ret_val.lo = cnt == 0 ? lo : ( lo >> cnt ) | ( hi << ( 64 - cnt ) );
+            ret_val.hi = cnt == 0 ? hi : hi >> cnt;
+            return ret_val;
+        }
+
+        Levels operator&( const Levels& other ) const
+        {
+            Levels ret_val = { lo & other.lo, hi & other.hi };
+            return ret_val;
+        }
+    };
+
+    // the offsets with correct start, stop and park bits and correct request parity
+    static U64 FindRequests( U64 lo, U64 hi )
+    {
+        const Levels lv = { lo, hi };
+
+        U64 start = lv.lo;
+        U64 stop = ~lv.ShiftDown( 6 ).lo;
+        U64 park = lv.ShiftDown( 7 ).lo;
+
+        // APnDP, RnW, A[2:3] and the parity bit must have an even number of ones
+        U64 parity = lv.ShiftDown( 1 ).lo ^ lv.ShiftDown( 2 ).lo ^ lv.ShiftDown( 3 ).lo ^ lv.ShiftDown( 4 ).lo ^ lv.ShiftDown( 5 ).lo;
+
+        return start & stop & park & ~parity;
+    }
+
+    // the offsets followed by at least LINE_RESET_BITS ones
+    static U64 FindLineResets( U64 lo, U64 hi )
+    {
+        const Levels r1 = { lo, hi };
+
+        // runs of 2, 4, 8, 16, 32, 48 and finally 50 ones
+        Levels r2 = r1 & r1.ShiftDown( 1 );
+        Levels r4 = r2 & r2.ShiftDown( 2 );
+        Levels r8 = r4 & r4.ShiftDown( 4 );
+        Levels r16 = r8 & r8.ShiftDown( 8 );
+        Levels r32 = r16 & r16.ShiftDown( 16 );
+        Levels r48 = r32 & r16.ShiftDown( 32 );
+
+        return ( r48 & r2.ShiftDown( 48 ) ).lo;
+    }
+
+    // the offsets from which all bits up to bit num_bits are ones
+    static U64 FindOpenRuns( U64 lo, U64 hi, size_t num_bits )
+    {
+        U64 lo_zeros = ~lo & ( num_bits >= 64 ? ~0ULL : ( 1ULL << num_bits ) - 1 );
+        U64 hi_zeros = num_bits <= 64 ? 0 : ~hi & ( num_bits >= 128 ? ~0ULL : ( 1ULL << ( num_bits - 64 ) ) - 1 );
+
+        if( hi_zeros != 0 )
+            return 0;
+        if( lo_zeros == 0 )
+            return ~0ULL;
+
+        // everything above the last zero
+        return MaskFrom( 64 - CountLeadingZeros64( lo_zeros ) );
+    }
+
+    // the offsets at or past first_offset
+    static U64 MaskFrom( S64 first_offset )
+    {
+        if( first_offset <= 0 )
+            return ~0ULL;
+        if( first_offset >= 64 )
+            return 0;
+        return ~0ULL << first_offset;
+    }
+};
+
+#endif // SWD_BIT_SCANNER_H
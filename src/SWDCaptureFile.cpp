@@ -0,0 +1,764 @@
+#include <algorithm>
+#include <cstring>
+
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SWDCaptureFile.h"
+
+SWDMappedFile::SWDMappedFile()
+    : mData( 0 ), mSize( 0 )
+#ifdef _WIN32
+      ,
+      mFile( INVALID_HANDLE_VALUE ), mMapping( 0 )
+#endif
+{
+}
+
+SWDMappedFile::~SWDMappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool SWDMappedFile::Open( const std::string& path, std::string& error )
+{
+    Close();
+
+    mFile = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+    if( mFile == INVALID_HANDLE_VALUE )
+    {
+        error = "can't open " + path;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( mFile, &size ) )
+    {
+        error = "can't get the size of " + path;
+        Close();
+        return false;
+    }
+
+    mSize = size_t( size.QuadPart );
+    if( mSize == 0 )
+    {
+        mData = "";
+        return true;
+    }
+
+    mMapping = CreateFileMappingA( mFile, 0, PAGE_READONLY, 0, 0, 0 );
+    if( mMapping != 0 )
+        mData = ( const char* )MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 );
+
+    if( mData == 0 )
+    {
+        error = "can't map " + path;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void SWDMappedFile::Close()
+{
+    if( mData != 0 && mSize != 0 )
+        UnmapViewOfFile( mData );
+    if( mMapping != 0 )
+        CloseHandle( mMapping );
+    if( mFile != INVALID_HANDLE_VALUE )
+        CloseHandle( mFile );
+
+    mData = 0;
+    mSize = 0;
+    mMapping = 0;
+    mFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool SWDMappedFile::Open( const std::string& path, std::string& error )
+{
+    Close();
+
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+    {
+        error = "can't open " + path;
+        return false;
+    }
+
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) )
+    {
+        error = path + " is not a regular file";
+        close( fd );
+        return false;
+    }
+
+    mSize = size_t( st.st_size );
+    if( mSize == 0 )
+    {
+        mData = "";
+        close( fd );
+        return true;
+    }
+
+    void* data = mmap( 0, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if( data == MAP_FAILED )
+    {
+        error = "can't map " + path;
+        mSize = 0;
+        return false;
+    }
+
+    // we read the captures front to back
+    madvise( data, mSize, MADV_SEQUENTIAL );
+
+    mData = ( const char* )data;
+    return true;
+}
+
+void SWDMappedFile::Close()
+{
+    if( mData != 0 && mSize != 0 )
+        munmap( ( void* )mData, mSize );
+
+    mData = 0;
+    mSize = 0;
+}
+
+#endif
+
+// ********************************************************************************
+
+SWDCaptureChannel::SWDCaptureChannel() : mSample( 0 ), mBitState( BIT_LOW ), mNextEdge( 0 ), mHasNextEdge( false )
+{
+}
+
+void SWDCaptureChannel::Start( BitState initial_state )
+{
+    mSample = 0;
+    mBitState = initial_state;
+    mNextEdge = 0;
+
+    ReadNextEdge();
+}
+
+void SWDCaptureChannel::ReadNextEdge()
+{
+    const U64 last_edge = mNextEdge;
+
+    mHasNextEdge = ReadEdge( mNextEdge );
+
+    // Transitions closer together than a sample, and those before the
+    // start of the capture, are moved so that there's only one per sample.
+    if( mHasNextEdge && mNextEdge <= last_edge )
+        mNextEdge = last_edge + 1;
+}
+
+U64 SWDCaptureChannel::GetSampleNumber()
+{
+    return mSample;
+}
+
+BitState SWDCaptureChannel::GetBitState()
+{
+    return mBitState;
+}
+
+void SWDCaptureChannel::AdvanceToNextEdge()
+{
+    if( !mHasNextEdge )
+        throw SWDEndOfCapture();
+
+    mSample = mNextEdge;
+    mBitState = mBitState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+
+    ReadNextEdge();
+}
+
+void SWDCaptureChannel::AdvanceToAbsPosition( U64 sample )
+{
+    // the transitions after the one we've read ahead might be skipped in one go
+    if( mHasNextEdge && mNextEdge <= sample && ( SkipEdges( sample ) & 1 ) != 0 )
+        mBitState = mBitState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+
+    while( mHasNextEdge && mNextEdge <= sample )
+    {
+        mBitState = mBitState == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+        ReadNextEdge();
+    }
+
+    if( sample > mSample )
+        mSample = sample;
+}
+
+U64 SWDCaptureChannel::SkipEdges( U64 /* sample */ )
+{
+    return 0;
+}
+
+U64 SWDCaptureChannel::GetSampleOfNextEdge()
+{
+    if( !mHasNextEdge )
+        throw SWDEndOfCapture();
+
+    return mNextEdge;
+}
+
+bool SWDCaptureChannel::DoMoreTransitionsExistInCurrentData()
+{
+    return mHasNextEdge;
+}
+
+// ********************************************************************************
+
+SWDMemoryChannel::SWDMemoryChannel() : mEdges( 0 ), mNumEdges( 0 ), mEdgeIndex( 0 )
+{
+}
+
+void SWDMemoryChannel::Open( BitState initial_state, const U64* edges, U64 num_edges )
+{
+    mEdges = edges;
+    mNumEdges = num_edges;
+    mEdgeIndex = 0;
+
+    Start( initial_state );
+}
+
+bool SWDMemoryChannel::ReadEdge( U64& sample )
+{
+    if( mEdgeIndex == mNumEdges )
+        return false;
+
+    sample = mEdges[ mEdgeIndex++ ];
+
+    return true;
+}
+
+U64 SWDMemoryChannel::SkipEdges( U64 sample )
+{
+    const U64 end = U64( std::upper_bound( mEdges + mEdgeIndex, mEdges + mNumEdges, sample ) - mEdges );
+
+    const U64 skipped = end - mEdgeIndex;
+    mEdgeIndex = end;
+
+    return skipped;
+}
+
+// ********************************************************************************
+
+const char EDGE_LIST_MAGIC[ 8 ] = { 'S', 'W', 'D', 'E', 'D', 'G', 'E', 'S' };
+const U32 EDGE_LIST_VERSION = 1;
+const size_t EDGE_LIST_HEADER_SIZE = 32;
+const size_t EDGE_LIST_NUM_EDGES_OFFSET = 24;
+
+// reads a value from a possibly unaligned position in a mapped file
+template <typename T>
+T ReadValue( const char* pos )
+{
+    T ret_val;
+    memcpy( &ret_val, pos, sizeof( T ) );
+    return ret_val;
+}
+
+SWDEdgeListChannel::SWDEdgeListChannel() : mEdges( 0 ), mNumEdges( 0 ), mEdgeIndex( 0 ), mSampleRate( 0 )
+{
+}
+
+bool SWDEdgeListChannel::IsEdgeList( const SWDMappedFile& file )
+{
+    return file.GetSize() >= sizeof( EDGE_LIST_MAGIC ) && memcmp( file.GetData(), EDGE_LIST_MAGIC, sizeof( EDGE_LIST_MAGIC ) ) == 0;
+}
+
+bool SWDEdgeListChannel::Open( const SWDMappedFile& file, std::string& error )
+{
+    const char* data = file.GetData();
+
+    if( !IsEdgeList( file ) || file.GetSize() < EDGE_LIST_HEADER_SIZE )
+    {
+        error = "not an edge list file";
+        return false;
+    }
+
+    if( ReadValue<U32>( data + 8 ) != EDGE_LIST_VERSION )
+    {
+        error = "unsupported edge list version";
+        return false;
+    }
+
+    const U64 sample_rate = ReadValue<U64>( data + 16 );
+    mNumEdges = ReadValue<U64>( data + 24 );
+
+    if( sample_rate == 0 || sample_rate > 0xffffffffULL )
+    {
+        error = "bad sample rate in the edge list";
+        return false;
+    }
+
+    if( mNumEdges > ( file.GetSize() - EDGE_LIST_HEADER_SIZE ) / sizeof( U64 ) )
+    {
+        error = "the edge list is truncated";
+        return false;
+    }
+
+    mSampleRate = U32( sample_rate );
+    mEdges = data + EDGE_LIST_HEADER_SIZE;
+    mEdgeIndex = 0;
+
+    Start( ReadValue<U32>( data + 12 ) != 0 ? BIT_HIGH : BIT_LOW );
+
+    return true;
+}
+
+U64 SWDEdgeListChannel::GetEdge( U64 ndx ) const
+{
+    return ReadValue<U64>( mEdges + ndx * sizeof( U64 ) );
+}
+
+bool SWDEdgeListChannel::ReadEdge( U64& sample )
+{
+    if( mEdgeIndex == mNumEdges )
+        return false;
+
+    sample = GetEdge( mEdgeIndex );
+    ++mEdgeIndex;
+
+    return true;
+}
+
+U64 SWDEdgeListChannel::SkipEdges( U64 sample )
+{
+    // the edges are sorted, so find the first one after sample by bisection
+    U64 lo = mEdgeIndex;
+    U64 hi = mNumEdges;
+    while( lo < hi )
+    {
+        const U64 mid = lo + ( hi - lo ) / 2;
+        if( GetEdge( mid ) <= sample )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    const U64 skipped = lo - mEdgeIndex;
+    mEdgeIndex = lo;
+
+    return skipped;
+}
+
+bool SWDEdgeListChannel::Write( const std::string& path, BitState initial_state, U64 sample_rate, const U64* edges, U64 num_edges,
+                                std::string& error )
+{
+    SWDEdgeListWriter writer;
+
+    return writer.Open( path, initial_state, sample_rate, error ) && writer.Write( edges, num_edges, error ) && writer.Close( error );
+}
+
+// ********************************************************************************
+
+SWDEdgeListWriter::SWDEdgeListWriter() : mNumEdges( 0 )
+{
+}
+
+SWDEdgeListWriter::~SWDEdgeListWriter()
+{
+    std::string error;
+    Close( error );
+}
+
+bool SWDEdgeListWriter::Open( const std::string& path, BitState initial_state, U64 sample_rate, std::string& error )
+{
+    mFile.open( path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+    if( !mFile )
+    {
+        error = "can't create " + path;
+        return false;
+    }
+
+    mPath = path;
+    mNumEdges = 0;
+
+    const U32 version = EDGE_LIST_VERSION;
+    const U32 initial = initial_state == BIT_HIGH ? 1 : 0;
+
+    // the edge count is patched in by Close
+    mFile.write( EDGE_LIST_MAGIC, sizeof( EDGE_LIST_MAGIC ) );
+    mFile.write( ( const char* )&version, sizeof( version ) );
+    mFile.write( ( const char* )&initial, sizeof( initial ) );
+    mFile.write( ( const char* )&sample_rate, sizeof( sample_rate ) );
+    mFile.write( ( const char* )&mNumEdges, sizeof( mNumEdges ) );
+
+    return Check( error );
+}
+
+bool SWDEdgeListWriter::Write( const U64* edges, U64 num_edges, std::string& error )
+{
+    mFile.write( ( const char* )edges, std::streamsize( num_edges * sizeof( U64 ) ) );
+    mNumEdges += num_edges;
+
+    return Check( error );
+}
+
+bool SWDEdgeListWriter::Close( std::string& error )
+{
+    if( !mFile.is_open() )
+        return true;
+
+    mFile.seekp( std::streamoff( EDGE_LIST_NUM_EDGES_OFFSET ) );
+    mFile.write( ( const char* )&mNumEdges, sizeof( mNumEdges ) );
+    mFile.close();
+
+    return Check( error );
+}
+
+bool SWDEdgeListWriter::Check( std::string& error )
+{
+    if( !mFile.fail() )
+        return true;
+
+    error = "can't write " + mPath;
+    return false;
+}
+
+// ********************************************************************************
+
+const char SALEAE_MAGIC[ 8 ] = { '<', 'S', 'A', 'L', 'E', 'A', 'E', '>' };
+const size_t SALEAE_DIGITAL_HEADER_SIZE = 44;
+
+SWDSaleaeBinaryChannel::SWDSaleaeBinaryChannel() : mTimes( 0 ), mNumTimes( 0 ), mTimeIndex( 0 ), mBeginTime( 0 ), mSampleRate( 0 )
+{
+}
+
+bool SWDSaleaeBinaryChannel::IsSaleaeBinary( const SWDMappedFile& file )
+{
+    return file.GetSize() >= sizeof( SALEAE_MAGIC ) && memcmp( file.GetData(), SALEAE_MAGIC, sizeof( SALEAE_MAGIC ) ) == 0;
+}
+
+bool SWDSaleaeBinaryChannel::Open( const SWDMappedFile& file, U32 sample_rate, std::string& error )
+{
+    const char* data = file.GetData();
+
+    if( !IsSaleaeBinary( file ) || file.GetSize() < SALEAE_DIGITAL_HEADER_SIZE )
+    {
+        error = "not a Saleae binary export";
+        return false;
+    }
+
+    const S32 version = ReadValue<S32>( data + 8 );
+    const S32 type = ReadValue<S32>( data + 12 );
+    if( version != 0 && version != 1 )
+    {
+        error = "unsupported Saleae binary export version";
+        return false;
+    }
+    if( type != 0 )
+    {
+        error = "not a digital channel export";
+        return false;
+    }
+
+    if( sample_rate == 0 )
+    {
+        error = "Saleae binary exports need the sample rate";
+        return false;
+    }
+
+    const U32 initial_state = ReadValue<U32>( data + 16 );
+    mBeginTime = ReadValue<double>( data + 20 );
+    mNumTimes = ReadValue<U64>( data + 36 );
+
+    if( mNumTimes > ( file.GetSize() - SALEAE_DIGITAL_HEADER_SIZE ) / sizeof( double ) )
+    {
+        error = "the Saleae binary export is truncated";
+        return false;
+    }
+
+    mTimes = data + SALEAE_DIGITAL_HEADER_SIZE;
+    mTimeIndex = 0;
+    mSampleRate = sample_rate;
+
+    Start( initial_state != 0 ? BIT_HIGH : BIT_LOW );
+
+    return true;
+}
+
+U64 SWDSaleaeBinaryChannel::GetEdge( U64 ndx ) const
+{
+    const double time = ReadValue<double>( mTimes + ndx * sizeof( double ) );
+
+    const double sample_time = ( time - mBeginTime ) * mSampleRate;
+    return sample_time > 0 ? U64( sample_time + 0.5 ) : 0;
+}
+
+bool SWDSaleaeBinaryChannel::ReadEdge( U64& sample )
+{
+    if( mTimeIndex == mNumTimes )
+        return false;
+
+    sample = GetEdge( mTimeIndex );
+    ++mTimeIndex;
+
+    return true;
+}
+
+U64 SWDSaleaeBinaryChannel::SkipEdges( U64 sample )
+{
+    // The times are sorted, so find the first transition after sample by bisection.
+    // This lands where reading them one by one does, unless transitions closer than
+    // a sample were moved apart by SWDCaptureChannel.
+    U64 lo = mTimeIndex;
+    U64 hi = mNumTimes;
+    while( lo < hi )
+    {
+        const U64 mid = lo + ( hi - lo ) / 2;
+        if( GetEdge( mid ) <= sample )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    const U64 skipped = lo - mTimeIndex;
+    mTimeIndex = lo;
+
+    return skipped;
+}
+
+// ********************************************************************************
+
+// skips white space and returns the next token, false at the end of the text
+static bool NextVcdToken( const char*& pos, const char* end, const char*& token, size_t& len )
+{
+    while( pos < end && ( *pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n' ) )
+        ++pos;
+
+    if( pos == end )
+        return false;
+
+    token = pos;
+    while( pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n' )
+        ++pos;
+
+    len = size_t( pos - token );
+    return true;
+}
+
+static bool IsVcdToken( const char* token, size_t len, const char* str )
+{
+    return strlen( str ) == len && memcmp( token, str, len ) == 0;
+}
+
+// skips the tokens up to and including $end
+static void SkipVcdToEnd( const char*& pos, const char* end )
+{
+    const char* token;
+    size_t len;
+    while( NextVcdToken( pos, end, token, len ) && !IsVcdToken( token, len, "$end" ) )
+        ;
+}
+
+static U64 ParseVcdNumber( const char* str, size_t len )
+{
+    U64 ret_val = 0;
+    for( size_t ndx = 0; ndx < len && str[ ndx ] >= '0' && str[ ndx ] <= '9'; ++ndx )
+        ret_val = ret_val * 10 + U64( str[ ndx ] - '0' );
+    return ret_val;
+}
+
+SWDVcdChannel::SWDVcdChannel()
+    : mPos( 0 ), mEnd( 0 ), mTime( 0 ), mFirstTime( 0 ), mHasFirstTime( false ), mLevel( BIT_LOW ), mTimescale( 1e-9 ), mSamplesPerUnit( 1 )
+{
+}
+
+bool SWDVcdChannel::IsVcd( const SWDMappedFile& file )
+{
+    // VCD files start with a declaration keyword
+    const char* pos = file.GetData();
+    const char* token;
+    size_t len;
+    return NextVcdToken( pos, file.GetData() + file.GetSize(), token, len ) && token[ 0 ] == '$';
+}
+
+bool SWDVcdChannel::Open( const SWDMappedFile& file, const std::string& signal, U32 sample_rate, std::string& error )
+{
+    mPos = file.GetData();
+    mEnd = file.GetData() + file.GetSize();
+    mId.clear();
+
+    // the declarations
+    const char* token;
+    size_t len;
+    bool definitions_ended = false;
+    while( !definitions_ended && NextVcdToken( mPos, mEnd, token, len ) )
+    {
+        if( IsVcdToken( token, len, "$timescale" ) )
+        {
+            // the number and the unit can be in the same token or not
+            std::string timescale;
+            while( NextVcdToken( mPos, mEnd, token, len ) && !IsVcdToken( token, len, "$end" ) )
+                timescale.append( token, len );
+
+            size_t unit_pos = timescale.find_first_not_of( "0123456789" );
+            double number = unit_pos == 0 ? 1 : double( ParseVcdNumber( timescale.c_str(), unit_pos ) );
+            std::string unit = unit_pos == std::string::npos ? "s" : timescale.substr( unit_pos );
+
+            if( unit == "s" )
+                mTimescale = number;
+            else if( unit == "ms" )
+                mTimescale = number * 1e-3;
+            else if( unit == "us" )
+                mTimescale = number * 1e-6;
+            else if( unit == "ns" )
+                mTimescale = number * 1e-9;
+            else if( unit == "ps" )
+                mTimescale = number * 1e-12;
+            else if( unit == "fs" )
+                mTimescale = number * 1e-15;
+            else
+            {
+                error = "unknown VCD timescale " + timescale;
+                return false;
+            }
+        }
+        else if( IsVcdToken( token, len, "$var" ) )
+        {
+            // $var type size id reference [range] $end
+            std::string fields[ 4 ];
+            size_t num_fields = 0;
+            while( NextVcdToken( mPos, mEnd, token, len ) && !IsVcdToken( token, len, "$end" ) )
+            {
+                if( num_fields < 4 )
+                    fields[ num_fields ].assign( token, len );
+                ++num_fields;
+            }
+
+            if( num_fields >= 4 && fields[ 1 ] == "1" && fields[ 3 ] == signal )
+                mId = fields[ 2 ];
+        }
+        else if( IsVcdToken( token, len, "$enddefinitions" ) )
+        {
+            SkipVcdToEnd( mPos, mEnd );
+            definitions_ended = true;
+        }
+        else if( token[ 0 ] == '$' )
+        {
+            SkipVcdToEnd( mPos, mEnd );
+        }
+        else
+        {
+            error = "bad VCD declarations";
+            return false;
+        }
+    }
+
+    if( !definitions_ended )
+    {
+        error = "no $enddefinitions in the VCD file";
+        return false;
+    }
+
+    if( mId.empty() )
+    {
+        error = "no single bit signal named " + signal + " in the VCD file";
+        return false;
+    }
+
+    mSamplesPerUnit = sample_rate == 0 ? 1 : mTimescale * sample_rate;
+
+    // the initial level is the last value at the first time, which is not an edge
+    const char* changes = mPos;
+    BitState initial_state = BIT_LOW;
+    BitState value;
+    while( NextChange( value ) && mTime == mFirstTime )
+        initial_state = value;
+
+    mPos = changes;
+    mTime = 0;
+    mHasFirstTime = false;
+    mLevel = initial_state;
+
+    Start( initial_state );
+
+    return true;
+}
+
+U32 SWDVcdChannel::GetTimescaleRate() const
+{
+    const double rate = 1 / mTimescale;
+    return rate >= 1 && rate <= 4294967295.0 ? U32( rate + 0.5 ) : 0;
+}
+
+bool SWDVcdChannel::NextChange( BitState& value )
+{
+    const char* token;
+    size_t len;
+    while( NextVcdToken( mPos, mEnd, token, len ) )
+    {
+        const char c = token[ 0 ];
+
+        if( c == '#' )
+        {
+            mTime = ParseVcdNumber( token + 1, len - 1 );
+            if( !mHasFirstTime )
+            {
+                mFirstTime = mTime;
+                mHasFirstTime = true;
+            }
+        }
+        else if( c == '$' )
+        {
+            // $dumpvars and the like only wrap value changes, but comments need skipping
+            if( IsVcdToken( token, len, "$comment" ) )
+                SkipVcdToEnd( mPos, mEnd );
+        }
+        else if( c == 'b' || c == 'B' || c == 'r' || c == 'R' )
+        {
+            // vector or real value, skip its id
+            NextVcdToken( mPos, mEnd, token, len );
+        }
+        else if( len - 1 == mId.size() && memcmp( token + 1, mId.data(), mId.size() ) == 0 )
+        {
+            // x and z read as low
+            value = c == '1' ? BIT_HIGH : BIT_LOW;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool SWDVcdChannel::ReadEdge( U64& sample )
+{
+    BitState value;
+    while( NextChange( value ) )
+    {
+        // the changes at the first time make up the initial level
+        if( value == mLevel || mTime == mFirstTime )
+        {
+            mLevel = value;
+            continue;
+        }
+
+        mLevel = value;
+
+        const double sample_time = double( mTime - mFirstTime ) * mSamplesPerUnit;
+        sample = U64( sample_time + 0.5 );
+
+        return true;
+    }
+
+    return false;
+}
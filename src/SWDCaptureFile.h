@@ -0,0 +1,252 @@
+#ifndef SWD_CAPTURE_FILE_H
+#define SWD_CAPTURE_FILE_H
+
+#include <fstream>
+#include <string>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDChannel.h"
+
+// A read-only memory mapping of a whole file.
+class SWDMappedFile
+{
+  public:
+    SWDMappedFile();
+    ~SWDMappedFile();
+
+    // returns false and sets error if the file can't be mapped
+    bool Open( const std::string& path, std::string& error );
+    void Close();
+
+    const char* GetData() const
+    {
+        return mData;
+    }
+    size_t GetSize() const
+    {
+        return mSize;
+    }
+
+  private:
+    // not copyable
+    SWDMappedFile( const SWDMappedFile& );
+    SWDMappedFile& operator=( const SWDMappedFile& );
+
+    const char* mData;
+    size_t mSize;
+
+#ifdef _WIN32
+    void* mFile;
+    void* mMapping;
+#endif
+};
+
+// SWDChannel over the transitions stored in a capture file.
+// The subclasses read the transitions one at a time straight from the
+// mapped file, so no copy of them is ever made. They throw SWDEndOfCapture
+// when asked for an edge after the last one.
+class SWDCaptureChannel : public SWDChannel
+{
+  public:
+    SWDCaptureChannel();
+
+    virtual U64 GetSampleNumber();
+    virtual BitState GetBitState();
+
+    virtual void AdvanceToNextEdge();
+    virtual void AdvanceToAbsPosition( U64 sample );
+
+    virtual U64 GetSampleOfNextEdge();
+    virtual bool DoMoreTransitionsExistInCurrentData();
+
+  protected:
+    // called by the subclasses once they're ready to read the edges
+    void Start( BitState initial_state );
+
+    // reads the sample number of the next transition, returns false at the end of the capture
+    virtual bool ReadEdge( U64& sample ) = 0;
+
+    // Skips the transitions up to and including sample without reading them,
+    // for the formats which can find them faster than ReadEdge, and returns
+    // how many were skipped. The default skips none.
+    virtual U64 SkipEdges( U64 sample );
+
+  private:
+    void ReadNextEdge();
+
+    U64 mSample;
+    BitState mBitState;
+
+    U64 mNextEdge;
+    bool mHasNextEdge;
+};
+
+// The raw edge list format, one file per channel, little endian:
+//   char magic[8]      "SWDEDGES"
+//   U32 version        1
+//   U32 initial_state  0 or 1
+//   U64 sample_rate    in Hz
+//   U64 num_edges
+//   U64 edges[]        sample numbers of the transitions, ascending
+class SWDEdgeListChannel : public SWDCaptureChannel
+{
+  public:
+    SWDEdgeListChannel();
+
+    static bool IsEdgeList( const SWDMappedFile& file );
+
+    bool Open( const SWDMappedFile& file, std::string& error );
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    // the number of transitions, and the sample of the one at ndx
+    U64 GetNumEdges() const
+    {
+        return mNumEdges;
+    }
+    U64 GetEdge( U64 ndx ) const;
+
+    // writes a file in this format
+    static bool Write( const std::string& path, BitState initial_state, U64 sample_rate, const U64* edges, U64 num_edges,
+                       std::string& error );
+
+  protected:
+    virtual bool ReadEdge( U64& sample );
+    virtual U64 SkipEdges( U64 sample );
+
+  private:
+    const char* mEdges;
+    U64 mNumEdges;
+    U64 mEdgeIndex;
+
+    U32 mSampleRate;
+};
+
+// Writes an edge list file a block of transitions at a time,
+// for captures too big to keep in memory.
+class SWDEdgeListWriter
+{
+  public:
+    SWDEdgeListWriter();
+    ~SWDEdgeListWriter();
+
+    bool Open( const std::string& path, BitState initial_state, U64 sample_rate, std::string& error );
+
+    // appends transitions after the ones written before
+    bool Write( const U64* edges, U64 num_edges, std::string& error );
+
+    // completes the header, the file is incomplete until then
+    bool Close( std::string& error );
+
+    U64 GetNumEdges() const
+    {
+        return mNumEdges;
+    }
+
+  private:
+    // not copyable
+    SWDEdgeListWriter( const SWDEdgeListWriter& );
+    SWDEdgeListWriter& operator=( const SWDEdgeListWriter& );
+
+    bool Check( std::string& error );
+
+    std::ofstream mFile;
+    std::string mPath;
+    U64 mNumEdges;
+};
+
+// Transitions kept in memory, e.g. the ones built by SWDStreamBuilder.
+// The edges aren't copied, so they must outlive the channel.
+class SWDMemoryChannel : public SWDCaptureChannel
+{
+  public:
+    SWDMemoryChannel();
+
+    void Open( BitState initial_state, const U64* edges, U64 num_edges );
+
+  protected:
+    virtual bool ReadEdge( U64& sample );
+    virtual U64 SkipEdges( U64 sample );
+
+  private:
+    const U64* mEdges;
+    U64 mNumEdges;
+    U64 mEdgeIndex;
+};
+
+// A digital channel exported by Logic 2 in its binary format, version 0 or 1.
+// The transitions are stored as times in seconds, which are turned into
+// sample numbers at the given sample rate.
+class SWDSaleaeBinaryChannel : public SWDCaptureChannel
+{
+  public:
+    SWDSaleaeBinaryChannel();
+
+    static bool IsSaleaeBinary( const SWDMappedFile& file );
+
+    bool Open( const SWDMappedFile& file, U32 sample_rate, std::string& error );
+
+    // the number of transitions, and the sample of the one at ndx
+    U64 GetNumEdges() const
+    {
+        return mNumTimes;
+    }
+    U64 GetEdge( U64 ndx ) const;
+
+  protected:
+    virtual bool ReadEdge( U64& sample );
+    virtual U64 SkipEdges( U64 sample );
+
+  private:
+    const char* mTimes;
+    U64 mNumTimes;
+    U64 mTimeIndex;
+
+    double mBeginTime;
+    double mSampleRate;
+};
+
+// A single bit signal from a VCD file. The value changes are scanned
+// straight from the mapped text, each channel with its own scanner.
+// VCD time is turned into sample numbers at the given sample rate,
+// or one sample per time unit if the sample rate is 0.
+class SWDVcdChannel : public SWDCaptureChannel
+{
+  public:
+    SWDVcdChannel();
+
+    static bool IsVcd( const SWDMappedFile& file );
+
+    // signal is the reference name of the variable as declared by $var
+    bool Open( const SWDMappedFile& file, const std::string& signal, U32 sample_rate, std::string& error );
+
+    // the sample rate matching the file's timescale
+    U32 GetTimescaleRate() const;
+
+  protected:
+    virtual bool ReadEdge( U64& sample );
+
+  private:
+    // scans to the next value change of our signal, returns false at the end of the file
+    bool NextChange( BitState& value );
+
+    const char* mPos;
+    const char* mEnd;
+
+    std::string mId;
+    U64 mTime;
+    U64 mFirstTime;
+    bool mHasFirstTime;
+
+    BitState mLevel;
+
+    // seconds per time unit, and samples per time unit
+    double mTimescale;
+    double mSamplesPerUnit;
+};
+
+#endif // SWD_CAPTURE_FILE_H
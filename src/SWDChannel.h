@@ -0,0 +1,51 @@
+#ifndef SWD_CHANNEL_H
+#define SWD_CHANNEL_H
+
+#include <LogicPublicTypes.h>
+
+// The channel operations SWDBitSampler needs, with the same meaning as
+// in the SDK's AnalyzerChannelData. They're implemented on top of
+// AnalyzerChannelData inside Logic, and on top of capture files by swd_decode.
+class SWDChannel
+{
+  public:
+    virtual ~SWDChannel()
+    {
+    }
+
+    virtual U64 GetSampleNumber() = 0;
+    virtual BitState GetBitState() = 0;
+
+    virtual void AdvanceToNextEdge() = 0;
+    virtual void AdvanceToAbsPosition( U64 sample ) = 0;
+
+    virtual U64 GetSampleOfNextEdge() = 0;
+    virtual bool DoMoreTransitionsExistInCurrentData() = 0;
+};
+
+// thrown by channels that wait for an edge after the end of the capture,
+// which only happens outside Logic, where captures end
+struct SWDEndOfCapture
+{
+};
+
+// Opens cursors on the two channels of a capture, each independent of the
+// others, so that parts of the capture can be decoded in parallel.
+class SWDChannelSource
+{
+  public:
+    virtual ~SWDChannelSource()
+    {
+    }
+
+    // new cursors at the start of the capture, which the caller deletes
+    virtual SWDChannel* OpenSWDIO() = 0;
+    virtual SWDChannel* OpenSWCLK() = 0;
+
+    // The transitions on SWCLK, by index, which the capture is cut into parts
+    // of about the same number of bits with, however long SWCLK idles.
+    virtual U64 GetNumSWCLKEdges() = 0;
+    virtual U64 GetSWCLKEdge( U64 ndx ) = 0;
+};
+
+#endif // SWD_CHANNEL_H
@@ -0,0 +1,500 @@
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "SWDBitSampler.h"
+#include "SWDBitScanner.h"
+#include "SWDChunkedDecoder.h"
+#include "SWDTrace.h"
+
+// about how many bits go into a chunk, which is what a chunk holds on to until it's stitched
+const U64 CHUNK_BITS = 1 << 18;
+
+// a bit is a whole SWCLK period
+const U64 CHUNK_SWCLK_EDGES = 2 * CHUNK_BITS;
+
+// how many bits after a chunk's nominal start we look for a line reset or an idle gap
+const size_t CHUNK_CUT_SEARCH_BITS = 4096;
+
+// SWCLK staying low this many times longer than it was high is an idle gap
+const S64 IDLE_GAP_RATIO = 16;
+
+// how many chunks per thread can be decoded ahead of the stitching
+const size_t CHUNKS_AHEAD_PER_THREAD = 2;
+
+// the bits sampled and fed to a chunk's parser in one go
+const size_t CHUNK_BATCH_BITS = 1024;
+
+// A part of the capture with its own sampler and parser, and what the
+// parser found in it, kept until the chunk is stitched.
+struct SWDDecodeChunk : public SWDParserListener
+{
+    enum EventType
+    {
+        ET_OPERATION,
+        ET_LINE_RESET,
+        ET_DROPPED_BITS,
+    };
+
+    struct Event
+    {
+        EventType type;
+
+        // the SWCLK falling edges of the event's first and last bit,
+        // which are the same for two parsers only if they found the same thing
+        S64 first;
+        S64 last;
+
+        // the operation's bits are kept in event_bits
+        SWDOperation operation;
+
+        // the line reset's or the dropped bits
+        SWDBitRun bits;
+    };
+
+    SWDDecodeChunk() : start( -1 ), end( -1 ), at_end( false ), skip( 0 )
+    {
+    }
+
+    virtual void OnOperation( SWDOperation& tran )
+    {
+        Event e;
+        e.type = ET_OPERATION;
+        e.operation = tran;
+
+        // copy the bits, since the parser's view of them is about to go away
+        const size_t first_bit = event_bits.Size();
+        for( size_t ndx = 0; ndx < tran.bits.Size(); ++ndx )
+            event_bits.PushBack( tran.bits[ ndx ] );
+        e.operation.bits = event_bits.View( first_bit, tran.bits.Size() );
+
+        e.first = tran.bits.Front().falling;
+        e.last = tran.trailing.Empty() ? tran.bits.Back().falling : tran.trailing.last.falling;
+
+        events.push_back( e );
+    }
+
+    virtual void OnLineReset( SWDLineReset& reset )
+    {
+        AddRun( ET_LINE_RESET, reset.bits );
+    }
+
+    virtual void OnDroppedBits( const SWDBitRun& bits )
+    {
+        AddRun( ET_DROPPED_BITS, bits );
+    }
+
+    void AddRun( EventType type, const SWDBitRun& bits )
+    {
+        Event e;
+        e.type = type;
+        e.operation.Clear();
+        e.bits = bits;
+        e.first = bits.first.falling;
+        e.last = bits.last.falling;
+
+        events.push_back( e );
+    }
+
+    // The SWCLK falling edges of the bit before the chunk and of its last bit,
+    // start is -1 for the first chunk and end is -1 for the last one.
+    S64 start;
+    S64 end;
+
+    std::unique_ptr<SWDChannel> swdio;
+    std::unique_ptr<SWDChannel> swclk;
+    SWDBitSampler sampler;
+    SWDParser parser;
+
+    // the bits sampled past the end, which haven't been fed to the parser yet
+    std::vector<SWDBit> pending;
+
+    // the parser was fed the rest of the capture and flushed
+    bool at_end;
+
+    std::vector<Event> events;
+    SWDBitBuffer event_bits;
+
+    // the events at the front which an earlier chunk passed on
+    size_t skip;
+
+    std::exception_ptr error;
+};
+
+// the events are the same, and so is the state of the parsers which passed them on
+static bool IsSameEvent( const SWDDecodeChunk::Event& e1, const SWDDecodeChunk::Event& e2 )
+{
+    return e1.type == e2.type && e1.first == e2.first && e1.last == e2.last;
+}
+
+// Stops the decoding threads and waits for them when Decode exits.
+class SWDChunkThreadsJoiner
+{
+  public:
+    SWDChunkThreadsJoiner( std::mutex& mutex, std::condition_variable& condition, bool& stop, std::vector<std::thread>& threads )
+        : mMutex( mutex ), mCondition( condition ), mStop( stop ), mThreads( threads )
+    {
+    }
+
+    ~SWDChunkThreadsJoiner()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+            mStop = true;
+            mCondition.notify_all();
+        }
+
+        for( size_t ndx = 0; ndx < mThreads.size(); ++ndx )
+            mThreads[ ndx ].join();
+    }
+
+  private:
+    std::mutex& mMutex;
+    std::condition_variable& mCondition;
+    bool& mStop;
+    std::vector<std::thread>& mThreads;
+};
+
+SWDChunkedDecoder::SWDChunkedDecoder()
+    : mSource( 0 ), mListener( 0 ), mNumThreads( 1 ), mSelectRegister( 0 ), mNextChunk( 0 ), mWaitingFor( 0 ), mStop( false )
+{
+}
+
+SWDChunkedDecoder::~SWDChunkedDecoder()
+{
+}
+
+void SWDChunkedDecoder::Setup( SWDChannelSource* pSource, SWDParserListener* pListener, size_t num_threads )
+{
+    mSource = pSource;
+    mListener = pListener;
+
+    mNumThreads = num_threads != 0 ? num_threads : std::max( std::thread::hardware_concurrency(), 1U );
+}
+
+void SWDChunkedDecoder::Decode()
+{
+    FindChunks();
+
+    mSelectRegister = 0;
+    mNextChunk = 0;
+    mWaitingFor = 0;
+    mStop = false;
+
+    std::vector<std::thread> threads;
+    SWDChunkThreadsJoiner joiner( mMutex, mCondition, mStop, threads );
+
+    for( size_t ndx = 0; ndx < mNumThreads; ++ndx )
+        threads.push_back( std::thread( [this]() { DecoderThread(); } ) );
+
+    size_t ndx = 0;
+    while( ndx < mChunks.size() )
+        ndx = StitchChunk( ndx );
+}
+
+void SWDChunkedDecoder::FindChunks()
+{
+    // The chunks nominally start every CHUNK_SWCLK_EDGES edges, so an idle gap
+    // of any length is a single bit of one chunk rather than empty chunks.
+    const U64 num_edges = mSource->GetNumSWCLKEdges();
+    const U64 num_chunks = num_edges > 0 ? ( num_edges - 1 ) / CHUNK_SWCLK_EDGES + 1 : 1;
+
+    mChunks.clear();
+    mChunks.resize( size_t( num_chunks ) );
+
+    // the first chunk starts at the start of the capture
+    mCuts.assign( 1, -1 );
+}
+
+S64 SWDChunkedDecoder::FindCut( U64 sample )
+{
+    std::unique_ptr<SWDChannel> swdio( mSource->OpenSWDIO() );
+    std::unique_ptr<SWDChannel> swclk( mSource->OpenSWCLK() );
+
+    SWDBitSampler sampler;
+    std::vector<SWDBit> bits( CHUNK_CUT_SEARCH_BITS );
+    size_t num_bits = 0;
+    try
+    {
+        swdio->AdvanceToAbsPosition( sample );
+        swclk->AdvanceToAbsPosition( sample );
+
+        sampler.Setup( swdio.get(), swclk.get() );
+        while( num_bits < bits.size() )
+            num_bits += sampler.SampleBits( &bits[ num_bits ], bits.size() - num_bits );
+    }
+    catch( SWDEndOfCapture& )
+    {
+    }
+
+    if( num_bits == 0 )
+        return -1;
+
+    // the first bit's low_start is where we started sampling, but the edges after it are real
+    size_t high_bits = 0;
+    for( size_t ndx = 0; ndx < num_bits; ++ndx )
+    {
+        const SWDBit& bit = bits[ ndx ];
+
+        // cut between a line reset and the bit that ends it
+        if( !bit.IsHigh() && high_bits >= SWDBitScanner::LINE_RESET_BITS )
+            return bits[ ndx - 1 ].falling;
+
+        high_bits = bit.IsHigh() ? high_bits + 1 : 0;
+
+        // or where SWCLK idles
+        if( bit.low_end - bit.falling > IDLE_GAP_RATIO * ( bit.falling - bit.rising ) )
+            return bit.falling;
+    }
+
+    return bits[ 0 ].falling;
+}
+
+S64 SWDChunkedDecoder::GetCut( size_t ndx )
+{
+    // the chunks are taken in order, so this finds a cut or two at a time
+    std::lock_guard<std::mutex> lock( mCutsMutex );
+
+    while( mCuts.size() <= ndx )
+        mCuts.push_back( FindCut( mSource->GetSWCLKEdge( mCuts.size() * CHUNK_SWCLK_EDGES ) ) );
+
+    return mCuts[ ndx ];
+}
+
+void SWDChunkedDecoder::DecoderThread()
+{
+    SWDTrace::SetThreadName( "chunk decoder" );
+
+    const size_t max_ahead = mNumThreads * CHUNKS_AHEAD_PER_THREAD;
+
+    for( ;; )
+    {
+        size_t ndx;
+        {
+            std::unique_lock<std::mutex> lock( mMutex );
+            while( !mStop && mNextChunk < mChunks.size() && mNextChunk >= mWaitingFor + max_ahead )
+                mCondition.wait( lock );
+
+            if( mStop || mNextChunk == mChunks.size() )
+                return;
+
+            ndx = mNextChunk++;
+        }
+
+        std::unique_ptr<SWDDecodeChunk> chunk( new SWDDecodeChunk() );
+        try
+        {
+            DecodeChunk( *chunk, ndx );
+        }
+        catch( ... )
+        {
+            chunk->error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock( mMutex );
+        mChunks[ ndx ] = std::move( chunk );
+        mCondition.notify_all();
+    }
+}
+
+void SWDChunkedDecoder::DecodeChunk( SWDDecodeChunk& chunk, size_t ndx )
+{
+    const bool is_first = ndx == 0;
+    const bool is_last = ndx + 1 == mChunks.size();
+
+    if( !is_first )
+    {
+        chunk.start = GetCut( ndx );
+
+        // nothing left to decode
+        if( chunk.start < 0 )
+            return;
+    }
+
+    if( !is_last )
+        chunk.end = GetCut( ndx + 1 );
+
+    // nothing to decode either, an earlier chunk decodes past us
+    if( chunk.end >= 0 && chunk.start >= chunk.end )
+        return;
+
+    chunk.swdio.reset( mSource->OpenSWDIO() );
+    chunk.swclk.reset( mSource->OpenSWCLK() );
+
+    chunk.parser.Setup( &chunk );
+    chunk.parser.Clear();
+
+    std::vector<SWDBit> bits( CHUNK_BATCH_BITS );
+    try
+    {
+        // start right after the falling edge, as the sampler does after the bit before
+        if( !is_first )
+        {
+            chunk.swdio->AdvanceToAbsPosition( U64( chunk.start ) );
+            chunk.swclk->AdvanceToAbsPosition( U64( chunk.start ) );
+        }
+
+        chunk.sampler.Setup( chunk.swdio.get(), chunk.swclk.get() );
+
+        for( ;; )
+        {
+            const size_t num_bits = chunk.sampler.SampleBits( &bits[ 0 ], bits.size() );
+
+            size_t num_fed = num_bits;
+            if( chunk.end >= 0 )
+            {
+                while( num_fed > 0 && bits[ num_fed - 1 ].falling > chunk.end )
+                    --num_fed;
+            }
+
+            chunk.parser.Feed( &bits[ 0 ], num_fed );
+
+            if( num_fed < num_bits )
+            {
+                chunk.pending.assign( bits.begin() + num_fed, bits.begin() + num_bits );
+                return;
+            }
+
+            if( num_fed > 0 && bits[ num_fed - 1 ].falling == chunk.end )
+                return;
+        }
+    }
+    catch( SWDEndOfCapture& )
+    {
+        chunk.parser.Flush();
+        chunk.at_end = true;
+    }
+}
+
+SWDDecodeChunk& SWDChunkedDecoder::WaitForChunk( size_t ndx )
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    mWaitingFor = std::max( mWaitingFor, ndx );
+    mCondition.notify_all();
+
+    // a chunk is only added once it's decoded
+    while( !mChunks[ ndx ] )
+        mCondition.wait( lock );
+
+    SWDDecodeChunk& chunk = *mChunks[ ndx ];
+
+    if( chunk.error )
+        std::rethrow_exception( chunk.error );
+
+    return chunk;
+}
+
+size_t SWDChunkedDecoder::StitchChunk( size_t ndx )
+{
+    SWDDecodeChunk& chunk = WaitForChunk( ndx );
+
+    // Find the first event this chunk's parser has in common with a following chunk's.
+    // The events before skip were passed on by an earlier chunk, which agreed with
+    // us on the last of them, so we can't agree with anyone on the ones before it.
+    const size_t first_check = chunk.skip > 0 ? chunk.skip - 1 : 0;
+    size_t next = ndx + 1;
+    size_t checked = first_check;
+    size_t next_pos = 0;
+    while( next < mChunks.size() )
+    {
+        SWDDecodeChunk& next_chunk = WaitForChunk( next );
+
+        bool found = false;
+        for( ; checked < chunk.events.size() && !found; ++checked )
+        {
+            const SWDDecodeChunk::Event& e = chunk.events[ checked ];
+            while( next_pos < next_chunk.events.size() && next_chunk.events[ next_pos ].first < e.first )
+                ++next_pos;
+
+            found = next_pos < next_chunk.events.size() && IsSameEvent( e, next_chunk.events[ next_pos ] );
+        }
+
+        if( found )
+        {
+            // everything up to the common event is ours, and the rest is the next chunk's
+            Replay( chunk, chunk.skip, checked );
+            next_chunk.skip = next_pos + 1;
+            break;
+        }
+
+        // We've decoded past everything the next chunk found without agreeing
+        // with it, so we take its place and compare with the one after it.
+        if( chunk.at_end || next_chunk.events.empty() || ( !chunk.events.empty() && chunk.events.back().first > next_chunk.events.back().first ) )
+        {
+            ++next;
+            checked = first_check;
+            next_pos = 0;
+            continue;
+        }
+
+        FeedMore( chunk );
+    }
+
+    // the last chunk to be stitched has the rest of the capture
+    if( next == mChunks.size() )
+    {
+        while( !chunk.at_end )
+            FeedMore( chunk );
+
+        Replay( chunk, chunk.skip, chunk.events.size() );
+    }
+
+    // the chunks we've passed on aren't needed any more, nor the ones we took the place of
+    for( size_t cndx = ndx; cndx < next; ++cndx )
+        mChunks[ cndx ].reset();
+
+    return next;
+}
+
+void SWDChunkedDecoder::FeedMore( SWDDecodeChunk& chunk )
+{
+    try
+    {
+        if( !chunk.pending.empty() )
+        {
+            chunk.parser.Feed( &chunk.pending[ 0 ], chunk.pending.size() );
+            chunk.pending.clear();
+            return;
+        }
+
+        std::vector<SWDBit> bits( CHUNK_BATCH_BITS );
+        const size_t num_bits = chunk.sampler.SampleBits( &bits[ 0 ], bits.size() );
+        chunk.parser.Feed( &bits[ 0 ], num_bits );
+    }
+    catch( SWDEndOfCapture& )
+    {
+        chunk.parser.Flush();
+        chunk.at_end = true;
+    }
+}
+
+void SWDChunkedDecoder::Replay( SWDDecodeChunk& chunk, size_t first, size_t last )
+{
+    for( size_t ndx = first; ndx < last; ++ndx )
+    {
+        SWDDecodeChunk::Event& e = chunk.events[ ndx ];
+
+        if( e.type == SWDDecodeChunk::ET_OPERATION )
+        {
+            // the chunk's parser didn't know the SELECT value when the chunk started,
+            // so resolve the register again, and track SELECT writes as SWDParser does
+            SWDOperation& tran = e.operation;
+            tran.SetRegister( mSelectRegister );
+            if( tran.reg == SWDR_DP_SELECT && !tran.RnW && tran.ACK == ACK_OK )
+                mSelectRegister = tran.data;
+
+            mListener->OnOperation( tran );
+        }
+        else if( e.type == SWDDecodeChunk::ET_LINE_RESET )
+        {
+            SWDLineReset reset;
+            reset.bits = e.bits;
+            mListener->OnLineReset( reset );
+        }
+        else
+        {
+            mListener->OnDroppedBits( e.bits );
+        }
+    }
+}
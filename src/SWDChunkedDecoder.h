@@ -0,0 +1,88 @@
+#ifndef SWD_CHUNKED_DECODER_H
+#define SWD_CHUNKED_DECODER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDChannel.h"
+#include "SWDParser.h"
+
+struct SWDDecodeChunk;
+
+// Decodes a whole capture on several threads.
+// The capture is cut into chunks of about the same number of SWCLK edges,
+// preferably right after line resets or where SWCLK idles, and each chunk is
+// decoded from its start by its own sampler and parser, which don't know what
+// came before. A chunk is only made once a thread gets to it, so just the
+// ones decoded ahead of the stitching exist at a time.
+// The chunks are stitched in order: each one carries on decoding past its end
+// until its parser passes on something that the next chunk's parser passed on
+// as well, at which point both parsers are in the same state and the next
+// chunk's decode takes over.
+// The registers which depend on the DP SELECT value are resolved again while
+// stitching, so the listener gets exactly what SWDParser gives when it's fed
+// the capture from the start.
+class SWDChunkedDecoder
+{
+  public:
+    SWDChunkedDecoder();
+    ~SWDChunkedDecoder();
+
+    // num_threads is the number of decoding threads, 0 for one per core
+    void Setup( SWDChannelSource* pSource, SWDParserListener* pListener, size_t num_threads );
+
+    // decodes the capture and passes everything found in it to the listener, in stream order
+    void Decode();
+
+  private:
+    void FindChunks();
+
+    // the SWCLK falling edge to cut the capture at, on or after sample, or -1 if there's none
+    S64 FindCut( U64 sample );
+
+    // the cut at the start of chunk ndx, which is found once for it and the chunk before it
+    S64 GetCut( size_t ndx );
+
+    void DecoderThread();
+    void DecodeChunk( SWDDecodeChunk& chunk, size_t ndx );
+
+    SWDDecodeChunk& WaitForChunk( size_t ndx );
+
+    // passes on the events of the chunk up to where a following chunk takes over,
+    // and returns the index of that chunk
+    size_t StitchChunk( size_t ndx );
+
+    // feeds the chunk's parser more bits from past its end
+    void FeedMore( SWDDecodeChunk& chunk );
+
+    void Replay( SWDDecodeChunk& chunk, size_t first, size_t last );
+
+    SWDChannelSource* mSource;
+    SWDParserListener* mListener;
+    size_t mNumThreads;
+
+    // the chunks decoded and not stitched yet, the others are null
+    std::vector<std::unique_ptr<SWDDecodeChunk> > mChunks;
+
+    // the cuts found so far, in chunk order
+    std::vector<S64> mCuts;
+    std::mutex mCutsMutex;
+
+    // the SELECT value of the stitched stream so far
+    U32 mSelectRegister;
+
+    // the next chunk to decode, and the chunk being waited for by the stitching,
+    // which the decoding threads don't get too far ahead of
+    size_t mNextChunk;
+    size_t mWaitingFor;
+    bool mStop;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+#endif // SWD_CHUNKED_DECODER_H
@@ -0,0 +1,90 @@
+#include "SWDDataPhase.h"
+
+#if( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define SWD_DATA_PHASE_X86_GCC
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define SWD_DATA_PHASE_X86_MSVC
+#endif
+
+// The data bits and the parity are adjacent in the packed levels, so the
+// data phase is a shift and a single population count; no bit gathering needed.
+
+SWDDataPhase DecodeDataPhaseScalar( U64 levels )
+{
+    SWDDataPhase ret_val;
+    ret_val.data = U32( levels );
+    ret_val.data_parity = U8( ( levels >> 32 ) & 1 );
+
+    // fold the data word onto itself to get its parity
+    U32 parity = ret_val.data;
+    parity ^= parity >> 16;
+    parity ^= parity >> 8;
+    parity ^= parity >> 4;
+    parity ^= parity >> 2;
+    parity ^= parity >> 1;
+
+    ret_val.data_parity_ok = ret_val.data_parity == ( parity & 1 );
+
+    return ret_val;
+}
+
+#if defined( SWD_DATA_PHASE_X86_GCC )
+
+__attribute__( ( target( "popcnt" ) ) ) static SWDDataPhase DecodeDataPhasePopcnt( U64 levels )
+{
+    // the data and the parity bit together must have an even number of ones
+    SWDDataPhase ret_val;
+    ret_val.data = U32( levels );
+    ret_val.data_parity = U8( ( levels >> 32 ) & 1 );
+    ret_val.data_parity_ok = ( __builtin_popcountll( levels & 0x1ffffffffULL ) & 1 ) == 0;
+
+    return ret_val;
+}
+
+static bool HasPopcnt()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "popcnt" ) != 0;
+}
+
+#elif defined( SWD_DATA_PHASE_X86_MSVC )
+
+static SWDDataPhase DecodeDataPhasePopcnt( U64 levels )
+{
+    SWDDataPhase ret_val;
+    ret_val.data = U32( levels );
+    ret_val.data_parity = U8( ( levels >> 32 ) & 1 );
+    ret_val.data_parity_ok = ( ( __popcnt( ret_val.data ) + ret_val.data_parity ) & 1 ) == 0;
+
+    return ret_val;
+}
+
+static bool HasPopcnt()
+{
+    int cpu_info[ 4 ];
+    __cpuid( cpu_info, 1 );
+    return ( cpu_info[ 2 ] & ( 1 << 23 ) ) != 0;
+}
+
+#endif
+
+typedef SWDDataPhase ( *DataPhaseDecoder )( U64 levels );
+
+static DataPhaseDecoder SelectDataPhaseDecoder()
+{
+#if defined( SWD_DATA_PHASE_X86_GCC ) || defined( SWD_DATA_PHASE_X86_MSVC )
+    if( HasPopcnt() )
+        return DecodeDataPhasePopcnt;
+#endif
+
+    return DecodeDataPhaseScalar;
+}
+
+// picked once when the program starts, so a call doesn't check whether it was
+static const DataPhaseDecoder gDataPhaseDecoder = SelectDataPhaseDecoder();
+
+SWDDataPhase DecodeDataPhase( U64 levels )
+{
+    return gDataPhaseDecoder( levels );
+}
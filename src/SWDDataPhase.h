@@ -0,0 +1,20 @@
+#ifndef SWD_DATA_PHASE_H
+#define SWD_DATA_PHASE_H
+
+#include <LogicPublicTypes.h>
+
+// the decoded data phase of an operation
+struct SWDDataPhase
+{
+    U32 data;
+    U8 data_parity;
+    bool data_parity_ok;
+};
+
+// Decodes the 32 data bits and the parity bit from the packed SWDIO levels,
+// bit 0 of levels being the LSB of the data. Both functions give the same results;
+// DecodeDataPhase picks the fastest implementation the CPU supports at runtime.
+SWDDataPhase DecodeDataPhase( U64 levels );
+SWDDataPhase DecodeDataPhaseScalar( U64 levels );
+
+#endif // SWD_DATA_PHASE_H
@@ -0,0 +1,509 @@
+// swd_decode: decodes SWD captures exported from Logic, without Logic.
+//
+// Writes the same records as the analyzer's export, one capture at a time.
+// Run it without arguments for the usage.
+
+#include <cstdlib>
+#include <cstring>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include <AnalyzerHelpers.h>
+
+#include "SWDBitSampler.h"
+#include "SWDCaptureFile.h"
+#include "SWDChunkedDecoder.h"
+#include "SWDParser.h"
+#include "SWDTrace.h"
+#include "SWDTypes.h"
+#include "SWDUtils.h"
+
+// the number of bits sampled and fed to the parser in one go
+const size_t DECODE_BATCH_BITS = 1024;
+
+// the same fields as SWDAnalyzerResults::GenerateExportFile
+const size_t EXPORT_RECORD_FIELDS = 9;
+
+struct SWDDecodeOptions
+{
+    U32 sample_rate;
+    DisplayBase display_base;
+
+    std::string swdio_signal;
+    std::string swclk_signal;
+
+    int swdio_channel;
+    int swclk_channel;
+
+    std::string output_dir;
+    std::string trace_file;
+
+    // the number of decoding threads, 0 for one per core
+    size_t jobs;
+};
+
+// Writes the decoded operations and line resets as the analyzer exports them.
+class SWDExportWriter : public SWDParserListener
+{
+  public:
+    SWDExportWriter( std::ostream& os, U32 sample_rate, DisplayBase display_base )
+        : mOs( os ), mSampleRate( sample_rate ), mDisplayBase( display_base ), mNumOperations( 0 ), mNumLineResets( 0 ), mNumDroppedBits( 0 )
+    {
+    }
+
+    void WriteHeader()
+    {
+        mOs << "Time\tType\tR/W\tAP/DP\tRegister\tRequest byte\tACK\tWData\tWData details\n";
+    }
+
+    virtual void OnOperation( SWDOperation& tran )
+    {
+        std::vector<std::string> record;
+
+        record.push_back( GetSampleTimeStr( tran.bits[ 0 ].GetStartSample() ) );
+        record.push_back( "Operation" );
+        record.push_back( tran.IsRead() ? "read" : "write" );
+        record.push_back( tran.APnDP ? "AccessPort" : "DebugPort" );
+        record.push_back( GetRegisterName( tran.reg ) );
+        record.push_back( int2str_sal( tran.request_byte, mDisplayBase, 8 ) );
+
+        if( tran.ACK == ACK_OK )
+            record.push_back( "OK" );
+        else if( tran.ACK == ACK_WAIT )
+            record.push_back( "WAIT" );
+        else if( tran.ACK == ACK_FAULT )
+            record.push_back( "FAULT" );
+        else
+            record.push_back( "<disc>" );
+
+        if( tran.bits.Size() >= TRAN_READ_LENGTH )
+        {
+            record.push_back( int2str_sal( tran.data, mDisplayBase, 32 ) );
+            record.push_back( GetRegisterValueDesc( tran.reg, tran.data, mDisplayBase ) );
+        }
+
+        WriteRecord( record );
+        ++mNumOperations;
+    }
+
+    virtual void OnLineReset( SWDLineReset& reset )
+    {
+        std::vector<std::string> record;
+
+        record.push_back( GetSampleTimeStr( reset.bits.GetStartSample() ) );
+        record.push_back( "Line reset" );
+
+        WriteRecord( record );
+        ++mNumLineResets;
+    }
+
+    virtual void OnDroppedBits( const SWDBitRun& bits )
+    {
+        mNumDroppedBits += bits.count;
+    }
+
+    U64 GetNumOperations() const
+    {
+        return mNumOperations;
+    }
+    U64 GetNumLineResets() const
+    {
+        return mNumLineResets;
+    }
+    U64 GetNumDroppedBits() const
+    {
+        return mNumDroppedBits;
+    }
+
+  private:
+    std::string GetSampleTimeStr( S64 sample ) const
+    {
+        char time_str[ 128 ];
+        AnalyzerHelpers::GetTimeString( sample, 0, mSampleRate, time_str, sizeof( time_str ) );
+
+        // remove trailing zeros
+        size_t l = strlen( time_str );
+        if( l > 7 )
+            time_str[ l - 7 ] = '\0';
+
+        return time_str;
+    }
+
+    void WriteRecord( std::vector<std::string>& record )
+    {
+        while( record.size() < EXPORT_RECORD_FIELDS )
+            record.push_back( "" );
+
+        for( size_t ndx = 0; ndx < record.size(); ++ndx )
+        {
+            if( ndx != 0 )
+                mOs << "\t";
+
+            mOs << record[ ndx ];
+        }
+
+        mOs << '\n';
+    }
+
+    std::ostream& mOs;
+    U32 mSampleRate;
+    DisplayBase mDisplayBase;
+
+    U64 mNumOperations;
+    U64 mNumLineResets;
+    U64 mNumDroppedBits;
+};
+
+// the mapped files and the channels of one capture
+class SWDCapture : public SWDChannelSource
+{
+  public:
+    SWDCapture() : mSampleRate( 0 )
+    {
+        mChannels[ 0 ] = mChannels[ 1 ] = 0;
+    }
+
+    // capture is a VCD file, a directory with a Logic 2 binary export,
+    // or a pair of SWDIO and SWCLK files separated by a comma
+    bool Open( const std::string& capture, const SWDDecodeOptions& options, std::string& error )
+    {
+        struct stat st;
+        const size_t comma = capture.find( ',' );
+
+        if( comma != std::string::npos )
+            return OpenChannelFile( 0, capture.substr( 0, comma ), options, error ) &&
+                   OpenChannelFile( 1, capture.substr( comma + 1 ), options, error );
+
+        if( stat( capture.c_str(), &st ) == 0 && ( st.st_mode & S_IFMT ) == S_IFDIR )
+            return OpenChannelFile( 0, capture + "/digital_" + int2str( options.swdio_channel ) + ".bin", options, error ) &&
+                   OpenChannelFile( 1, capture + "/digital_" + int2str( options.swclk_channel ) + ".bin", options, error );
+
+        if( !mFiles[ 0 ].Open( capture, error ) )
+            return false;
+
+        if( !SWDVcdChannel::IsVcd( mFiles[ 0 ] ) )
+        {
+            error = capture + " is not a VCD file";
+            return false;
+        }
+
+        if( !mVcd[ 0 ].Open( mFiles[ 0 ], options.swdio_signal, options.sample_rate, error ) ||
+            !mVcd[ 1 ].Open( mFiles[ 0 ], options.swclk_signal, options.sample_rate, error ) )
+            return false;
+
+        mSampleRate = options.sample_rate != 0 ? options.sample_rate : mVcd[ 0 ].GetTimescaleRate();
+        if( mSampleRate == 0 )
+        {
+            error = "the VCD timescale doesn't fit a sample rate, use --sample-rate";
+            return false;
+        }
+
+        mChannels[ 0 ] = &mVcd[ 0 ];
+        mChannels[ 1 ] = &mVcd[ 1 ];
+        return true;
+    }
+
+    SWDChannel* GetSWDIO()
+    {
+        return mChannels[ 0 ];
+    }
+    SWDChannel* GetSWCLK()
+    {
+        return mChannels[ 1 ];
+    }
+
+    U32 GetSampleRate() const
+    {
+        return mSampleRate;
+    }
+
+    // VCD files can only be read from the start, the other formats can be entered anywhere
+    bool CanDecodeInParallel() const
+    {
+        return mChannels[ 0 ] != &mVcd[ 0 ];
+    }
+
+    virtual SWDChannel* OpenSWDIO()
+    {
+        return OpenCursor( 0 );
+    }
+    virtual SWDChannel* OpenSWCLK()
+    {
+        return OpenCursor( 1 );
+    }
+
+    virtual U64 GetNumSWCLKEdges()
+    {
+        return mChannels[ 1 ] == &mEdgeLists[ 1 ] ? mEdgeLists[ 1 ].GetNumEdges() : mSaleae[ 1 ].GetNumEdges();
+    }
+    virtual U64 GetSWCLKEdge( U64 ndx )
+    {
+        return mChannels[ 1 ] == &mEdgeLists[ 1 ] ? mEdgeLists[ 1 ].GetEdge( ndx ) : mSaleae[ 1 ].GetEdge( ndx );
+    }
+
+  private:
+    // another channel on a file we've opened already, so it can't fail
+    SWDChannel* OpenCursor( int ndx )
+    {
+        std::string error;
+
+        if( mChannels[ ndx ] == &mEdgeLists[ ndx ] )
+        {
+            SWDEdgeListChannel* channel = new SWDEdgeListChannel();
+            channel->Open( mFiles[ ndx ], error );
+            return channel;
+        }
+
+        SWDSaleaeBinaryChannel* channel = new SWDSaleaeBinaryChannel();
+        channel->Open( mFiles[ ndx ], mSampleRate, error );
+        return channel;
+    }
+
+    bool OpenChannelFile( int ndx, const std::string& path, const SWDDecodeOptions& options, std::string& error )
+    {
+        SWDMappedFile& file = mFiles[ ndx ];
+        if( !file.Open( path, error ) )
+            return false;
+
+        if( SWDEdgeListChannel::IsEdgeList( file ) )
+        {
+            if( !mEdgeLists[ ndx ].Open( file, error ) )
+                return false;
+
+            if( mSampleRate == 0 )
+                mSampleRate = options.sample_rate != 0 ? options.sample_rate : mEdgeLists[ ndx ].GetSampleRate();
+            mChannels[ ndx ] = &mEdgeLists[ ndx ];
+        }
+        else if( SWDSaleaeBinaryChannel::IsSaleaeBinary( file ) )
+        {
+            if( !mSaleae[ ndx ].Open( file, options.sample_rate, error ) )
+                return false;
+
+            mSampleRate = options.sample_rate;
+            mChannels[ ndx ] = &mSaleae[ ndx ];
+        }
+        else
+        {
+            error = path + " is neither an edge list nor a Saleae binary export";
+            return false;
+        }
+
+        return true;
+    }
+
+    SWDMappedFile mFiles[ 2 ];
+
+    SWDEdgeListChannel mEdgeLists[ 2 ];
+    SWDSaleaeBinaryChannel mSaleae[ 2 ];
+    SWDVcdChannel mVcd[ 2 ];
+
+    SWDChannel* mChannels[ 2 ];
+    U32 mSampleRate;
+};
+
+static void PrintUsage()
+{
+    std::cerr << "usage: swd_decode [options] capture...\n"
+                 "\n"
+                 "A capture is one of:\n"
+                 "  file.vcd              a VCD file with both signals\n"
+                 "  directory             a Logic 2 binary export, with digital_N.bin files\n"
+                 "  swdio_file,swclk_file Logic 2 binary exports or raw edge lists of the two channels\n"
+                 "\n"
+                 "options:\n"
+                 "  --sample-rate HZ      sample rate of the capture; needed for Logic 2 binary exports,\n"
+                 "                        VCD files default to one sample per time unit\n"
+                 "  --swdio-signal NAME   VCD signal names, SWDIO and SWCLK by default\n"
+                 "  --swclk-signal NAME\n"
+                 "  --swdio-channel N     Logic 2 export channel numbers, 0 and 1 by default\n"
+                 "  --swclk-channel N\n"
+                 "  --base hex|dec|bin    number format, hex by default\n"
+                 "  --output-dir DIR      write each capture to DIR/<capture name>.txt instead of stdout\n"
+                 "  --jobs N              decode on N threads, 0 for one per core, 1 by default;\n"
+                 "                        VCD files are always decoded on one thread\n"
+                 "  --trace FILE          write the decoder's timing spans to FILE as a Chrome trace,\n"
+                 "                        in builds configured with SWD_TRACE=ON\n";
+}
+
+// the file name of the capture without the directory and the extension
+static std::string GetCaptureName( const std::string& capture )
+{
+    std::string name = capture.substr( 0, capture.find( ',' ) );
+
+    while( !name.empty() && ( name[ name.size() - 1 ] == '/' || name[ name.size() - 1 ] == '\\' ) )
+        name.erase( name.size() - 1 );
+
+    const size_t slash = name.find_last_of( "/\\" );
+    if( slash != std::string::npos )
+        name = name.substr( slash + 1 );
+
+    const size_t dot = name.find_last_of( '.' );
+    if( dot != std::string::npos && dot != 0 )
+        name = name.substr( 0, dot );
+
+    return name;
+}
+
+static void DecodeCapture( const std::string& capture, SWDCapture& cap, const SWDDecodeOptions& options, std::ostream& os )
+{
+    SWDExportWriter writer( os, cap.GetSampleRate(), options.display_base );
+    writer.WriteHeader();
+
+    if( options.jobs != 1 && cap.CanDecodeInParallel() )
+    {
+        SWDChunkedDecoder decoder;
+        decoder.Setup( &cap, &writer, options.jobs );
+        decoder.Decode();
+    }
+    else
+    {
+        SWDBitSampler sampler;
+        sampler.Setup( cap.GetSWDIO(), cap.GetSWCLK() );
+
+        SWDParser parser;
+        parser.Setup( &writer );
+        parser.Clear();
+
+        std::vector<SWDBit> bits( DECODE_BATCH_BITS );
+        try
+        {
+            for( ;; )
+            {
+                size_t num_bits;
+                {
+                    SWD_TRACE_SPAN( "SampleBits" );
+                    num_bits = sampler.SampleBits( &bits[ 0 ], bits.size() );
+                }
+                parser.Feed( &bits[ 0 ], num_bits );
+            }
+        }
+        catch( SWDEndOfCapture& )
+        {
+            // there are no more whole bits in the capture
+        }
+
+        parser.Flush();
+    }
+
+    std::cerr << capture << ": " << writer.GetNumOperations() << " operations, " << writer.GetNumLineResets() << " line resets, "
+              << writer.GetNumDroppedBits() << " dropped bits" << std::endl;
+}
+
+int main( int argc, char* argv[] )
+{
+    SWDDecodeOptions options;
+    options.sample_rate = 0;
+    options.display_base = Hexadecimal;
+    options.swdio_signal = "SWDIO";
+    options.swclk_signal = "SWCLK";
+    options.swdio_channel = 0;
+    options.swclk_channel = 1;
+    options.jobs = 1;
+
+    std::vector<std::string> captures;
+
+    for( int ndx = 1; ndx < argc; ++ndx )
+    {
+        const std::string arg = argv[ ndx ];
+        const bool has_value = ndx + 1 < argc;
+
+        if( arg == "--sample-rate" && has_value )
+            options.sample_rate = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--swdio-signal" && has_value )
+            options.swdio_signal = argv[ ++ndx ];
+        else if( arg == "--swclk-signal" && has_value )
+            options.swclk_signal = argv[ ++ndx ];
+        else if( arg == "--swdio-channel" && has_value )
+            options.swdio_channel = atoi( argv[ ++ndx ] );
+        else if( arg == "--swclk-channel" && has_value )
+            options.swclk_channel = atoi( argv[ ++ndx ] );
+        else if( arg == "--output-dir" && has_value )
+            options.output_dir = argv[ ++ndx ];
+        else if( arg == "--trace" && has_value )
+            options.trace_file = argv[ ++ndx ];
+        else if( arg == "--jobs" && has_value )
+            options.jobs = size_t( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--base" && has_value )
+        {
+            const std::string base = argv[ ++ndx ];
+            if( base == "hex" )
+                options.display_base = Hexadecimal;
+            else if( base == "dec" )
+                options.display_base = Decimal;
+            else if( base == "bin" )
+                options.display_base = Binary;
+            else
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( arg.size() > 1 && arg[ 0 ] == '-' )
+        {
+            PrintUsage();
+            return 2;
+        }
+        else
+            captures.push_back( arg );
+    }
+
+    if( captures.empty() )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if( !options.trace_file.empty() && !SWDTrace::IsBuiltIn() )
+    {
+        std::cerr << "--trace needs a build configured with SWD_TRACE=ON" << std::endl;
+        return 2;
+    }
+
+    SWDTrace::SetThreadName( "main" );
+
+    int ret_val = 0;
+    for( size_t ndx = 0; ndx < captures.size(); ++ndx )
+    {
+        const std::string& capture = captures[ ndx ];
+        std::string error;
+
+        SWDCapture cap;
+        if( !cap.Open( capture, options, error ) )
+        {
+            std::cerr << capture << ": " << error << std::endl;
+            ret_val = 1;
+            continue;
+        }
+
+        if( options.output_dir.empty() )
+        {
+            DecodeCapture( capture, cap, options, std::cout );
+            continue;
+        }
+
+        const std::string path = options.output_dir + "/" + GetCaptureName( capture ) + ".txt";
+        std::ofstream of( path.c_str(), std::ios::out );
+        if( !of )
+        {
+            std::cerr << capture << ": can't create " << path << std::endl;
+            ret_val = 1;
+            continue;
+        }
+
+        DecodeCapture( capture, cap, options, of );
+    }
+
+    std::string error;
+    if( !options.trace_file.empty() && !SWDTrace::WriteChromeTrace( options.trace_file, error ) )
+    {
+        std::cerr << error << std::endl;
+        ret_val = 1;
+    }
+
+    return ret_val;
+}
@@ -0,0 +1,169 @@
+#include <sstream>
+
+#include "SWDDecodeEvents.h"
+#include "SWDUtils.h"
+
+bool SWDDecodeEvent::operator==( const SWDDecodeEvent& other ) const
+{
+    return type == other.type && first_bit == other.first_bit && num_bits == other.num_bits && start_sample == other.start_sample &&
+           end_sample == other.end_sample && request_byte == other.request_byte && ACK == other.ACK && data == other.data &&
+           data_parity == other.data_parity && reg == other.reg;
+}
+
+std::string SWDDecodeEvent::ToString() const
+{
+    std::ostringstream os;
+
+    if( type == DE_OPERATION )
+        os << "operation";
+    else if( type == DE_LINE_RESET )
+        os << "line reset";
+    else
+        os << "dropped";
+
+    os << " bits " << first_bit << "+" << num_bits << " samples " << start_sample << ".." << end_sample;
+
+    if( type == DE_OPERATION )
+        os << std::hex << " request 0x" << int( request_byte ) << " ACK " << int( ACK ) << " data 0x" << data << std::dec << " parity "
+           << int( data_parity ) << " " << GetRegisterName( reg );
+
+    return os.str();
+}
+
+// ********************************************************************************
+
+SWDDecodeEventSource::SWDDecodeEventSource() : mSink( 0 )
+{
+    Clear();
+}
+
+void SWDDecodeEventSource::Setup( SWDDecodeEventSink* pSink )
+{
+    mSink = pSink;
+}
+
+void SWDDecodeEventSource::Clear()
+{
+    mNextBit = 0;
+    mDropped = SWDDecodeEvent();
+    mDropped.type = SWDDecodeEvent::DE_DROPPED;
+}
+
+void SWDDecodeEventSource::OnOperation( SWDOperation& tran )
+{
+    SWDDecodeEvent event = SWDDecodeEvent();
+    event.type = SWDDecodeEvent::DE_OPERATION;
+    event.num_bits = tran.bits.Size() + tran.trailing.count;
+    event.start_sample = tran.bits.Front().GetStartSample();
+    event.end_sample = tran.trailing.Empty() ? tran.bits.Back().GetEndSample() : tran.trailing.GetEndSample();
+    event.request_byte = tran.request_byte;
+    event.ACK = tran.ACK;
+    event.data = tran.data;
+    event.data_parity = tran.data_parity;
+    event.reg = tran.reg;
+
+    AddEvent( event );
+}
+
+void SWDDecodeEventSource::OnLineReset( SWDLineReset& reset )
+{
+    SWDDecodeEvent event = SWDDecodeEvent();
+    event.type = SWDDecodeEvent::DE_LINE_RESET;
+    event.num_bits = reset.bits.count;
+    event.start_sample = reset.bits.GetStartSample();
+    event.end_sample = reset.bits.GetEndSample();
+
+    AddEvent( event );
+}
+
+void SWDDecodeEventSource::OnDroppedBits( const SWDBitRun& bits )
+{
+    SWDDecodeEvent event = SWDDecodeEvent();
+    event.type = SWDDecodeEvent::DE_DROPPED;
+    event.num_bits = bits.count;
+    event.start_sample = bits.GetStartSample();
+    event.end_sample = bits.GetEndSample();
+
+    AddEvent( event );
+}
+
+void SWDDecodeEventSource::AddEvent( const SWDDecodeEvent& event )
+{
+    if( event.type == SWDDecodeEvent::DE_DROPPED )
+    {
+        if( mDropped.num_bits == 0 )
+        {
+            mDropped.first_bit = mNextBit;
+            mDropped.start_sample = event.start_sample;
+        }
+
+        mDropped.num_bits += event.num_bits;
+        mDropped.end_sample = event.end_sample;
+        mNextBit += event.num_bits;
+        return;
+    }
+
+    Finish();
+
+    SWDDecodeEvent positioned = event;
+    positioned.first_bit = mNextBit;
+    mNextBit += event.num_bits;
+
+    mSink->OnEvent( positioned );
+}
+
+void SWDDecodeEventSource::Finish()
+{
+    if( mDropped.num_bits == 0 )
+        return;
+
+    mSink->OnEvent( mDropped );
+    mDropped.num_bits = 0;
+}
+
+// ********************************************************************************
+
+const U64 FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const U64 FNV_PRIME = 0x100000001b3ULL;
+
+void SWDDecodeEventHash::Clear()
+{
+    mNumBits = 0;
+    mNumOperations = 0;
+    mNumLineResets = 0;
+    mNumDroppedBits = 0;
+
+    mHash = FNV_OFFSET_BASIS;
+}
+
+void SWDDecodeEventHash::Add( U64 value, size_t num_bytes )
+{
+    // little endian, so the hash doesn't depend on the host
+    for( size_t ndx = 0; ndx < num_bytes; ++ndx )
+    {
+        mHash ^= ( value >> ( ndx * 8 ) ) & 0xff;
+        mHash *= FNV_PRIME;
+    }
+}
+
+void SWDDecodeEventHash::OnEvent( const SWDDecodeEvent& event )
+{
+    mNumBits += event.num_bits;
+    if( event.type == SWDDecodeEvent::DE_OPERATION )
+        ++mNumOperations;
+    else if( event.type == SWDDecodeEvent::DE_LINE_RESET )
+        ++mNumLineResets;
+    else
+        mNumDroppedBits += event.num_bits;
+
+    Add( event.type, 1 );
+    Add( event.first_bit, 8 );
+    Add( event.num_bits, 8 );
+    Add( U64( event.start_sample ), 8 );
+    Add( U64( event.end_sample ), 8 );
+    Add( event.request_byte, 1 );
+    Add( event.ACK, 1 );
+    Add( event.data, 4 );
+    Add( event.data_parity, 1 );
+    Add( event.reg, 1 );
+}
@@ -0,0 +1,121 @@
+#ifndef SWD_DECODE_EVENTS_H
+#define SWD_DECODE_EVENTS_H
+
+#include <string>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDParser.h"
+#include "SWDTypes.h"
+
+// One thing a decoder found in the stream, with everything the analyzer's
+// frames and markers are made of, so that two decoders can be compared
+// event by event, or by a hash of all their events.
+struct SWDDecodeEvent
+{
+    enum Type
+    {
+        DE_OPERATION,
+        DE_LINE_RESET,
+        DE_DROPPED,
+    };
+
+    Type type;
+
+    // the bits of the event, including the idle bits after an operation
+    U64 first_bit;
+    U64 num_bits;
+
+    S64 start_sample;
+    S64 end_sample;
+
+    // operations only, zero otherwise
+    U8 request_byte;
+    U8 ACK;
+    U32 data;
+    U8 data_parity;
+    SWDRegisters reg;
+
+    bool operator==( const SWDDecodeEvent& other ) const;
+    bool operator!=( const SWDDecodeEvent& other ) const
+    {
+        return !( *this == other );
+    }
+
+    // a one line description, for reporting a divergence
+    std::string ToString() const;
+};
+
+class SWDDecodeEventSink
+{
+  public:
+    virtual ~SWDDecodeEventSink()
+    {
+    }
+
+    virtual void OnEvent( const SWDDecodeEvent& event ) = 0;
+};
+
+// Turns what SWDParser passes on into SWDDecodeEvents for a sink.
+// The dropped bits in a row are one event, however the decoder split them up,
+// since that's a detail of the decoder and doesn't show in the results.
+class SWDDecodeEventSource : public SWDParserListener
+{
+  public:
+    SWDDecodeEventSource();
+
+    void Setup( SWDDecodeEventSink* pSink );
+
+    // starts over with a new stream
+    void Clear();
+
+    virtual void OnOperation( SWDOperation& tran );
+    virtual void OnLineReset( SWDLineReset& reset );
+    virtual void OnDroppedBits( const SWDBitRun& bits );
+
+    // for decoders which aren't SWDParserListeners, first_bit is set here
+    void AddEvent( const SWDDecodeEvent& event );
+
+    // passes on the dropped bits at the end of the stream
+    void Finish();
+
+  private:
+    SWDDecodeEventSink* mSink;
+
+    // the position of the next event's first bit
+    U64 mNextBit;
+
+    SWDDecodeEvent mDropped;
+};
+
+// Counts the events and hashes them with FNV-1a, which is all a golden
+// corpus needs to store of a decode.
+class SWDDecodeEventHash : public SWDDecodeEventSink
+{
+  public:
+    SWDDecodeEventHash()
+    {
+        Clear();
+    }
+
+    void Clear();
+
+    virtual void OnEvent( const SWDDecodeEvent& event );
+
+    U64 GetHash() const
+    {
+        return mHash;
+    }
+
+    U64 mNumBits;
+    U64 mNumOperations;
+    U64 mNumLineResets;
+    U64 mNumDroppedBits;
+
+  private:
+    void Add( U64 value, size_t num_bytes );
+
+    U64 mHash;
+};
+
+#endif // SWD_DECODE_EVENTS_H
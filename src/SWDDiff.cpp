@@ -0,0 +1,918 @@
+// swd_diff: checks the fast decoders against the reference decoder.
+//
+// Each stream is decoded by SWDReferenceParser, which decodes the way the
+// analyzer always has, by SWDParser fed in batches of random sizes, and by
+// SWDChunkedDecoder, and the events of the fast ones are compared with the
+// reference's, reporting the first divergence. Then each decoder is timed on
+// its own, so a speedup is always measured next to the check that it didn't
+// change what's decoded.
+// The streams are random bits, adversarial streams made of near misses, capture
+// files, and the entries of a golden corpus file, which stores the counts and
+// the hash of the reference's events for each entry, so changes to what the
+// reference decodes show as well. The bits of a stream are kept in memory.
+// The data phase decoder picked for the CPU is checked against the scalar one
+// on its own.
+// Build it with CMAKE_BUILD_TYPE=Release for the timings. Run it without
+// arguments for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SWDBitSampler.h"
+#include "SWDCaptureFile.h"
+#include "SWDChunkedDecoder.h"
+#include "SWDDataPhase.h"
+#include "SWDDecodeEvents.h"
+#include "SWDParser.h"
+#include "SWDReferenceParser.h"
+#include "SWDScenarioGenerator.h"
+#include "SWDStreamBuilder.h"
+#include "SWDTypes.h"
+
+// SWDParser is fed batches of up to this many bits while checking it,
+// and exactly this many while timing it, as swd_decode does
+const size_t DIFF_BATCH_BITS = 1024;
+
+// the events before a divergence that are printed with it
+const size_t DIFF_CONTEXT_EVENTS = 3;
+
+struct SWDDiffOptions
+{
+    U32 seed;
+    size_t jobs;
+    int repeat;
+};
+
+typedef std::chrono::steady_clock SWDDiffClock;
+
+static double SecondsSince( SWDDiffClock::time_point start )
+{
+    return std::chrono::duration<double>( SWDDiffClock::now() - start ).count();
+}
+
+// ********************************************************************************
+
+// the streams made up from random bits
+
+static void AddRandomBits( SWDStreamBuilder& builder, std::mt19937& rng, size_t num_bits )
+{
+    for( size_t ndx = 0; ndx < num_bits; ++ndx )
+        builder.Bit( rng() & 1 ? BIT_HIGH : BIT_LOW );
+}
+
+static void BuildRandom( SWDStreamBuilder& builder, U32 seed, U64 num_bits )
+{
+    std::mt19937 rng( seed );
+
+    builder.SetClockPeriod( 4 );
+    while( builder.GetNumBits() < num_bits )
+        AddRandomBits( builder, rng, 1024 );
+}
+
+// An operation without the turnaround at the end, so the next one can follow
+// right after it, with any ACK and maybe the wrong data parity.
+static void MakeOperationBits( std::mt19937& rng, bool APnDP, bool RnW, U8 addr, U32 data, std::vector<BitState>& levels )
+{
+    static const U8 ACKS[] = { ACK_OK, ACK_OK, ACK_OK, ACK_OK, ACK_WAIT, ACK_FAULT, 0, 3, 5, 6, 7 };
+    const U8 ack = ACKS[ rng() % sizeof( ACKS ) ];
+
+    levels.clear();
+    const U8 request = SWDStreamBuilder::MakeRequest( APnDP, RnW, addr );
+    for( size_t ndx = 0; ndx < 8; ++ndx )
+        levels.push_back( ( request >> ndx ) & 1 ? BIT_HIGH : BIT_LOW );
+
+    levels.push_back( BIT_HIGH );
+    for( size_t ndx = 0; ndx < 3; ++ndx )
+        levels.push_back( ( ack >> ndx ) & 1 ? BIT_HIGH : BIT_LOW );
+
+    // the data phase, sometimes even when the ACK isn't OK
+    if( ack != ACK_OK && rng() % 4 != 0 )
+        return;
+
+    U32 parity = rng() % 8 == 0 ? 1 : 0;
+    for( U32 bits = data; bits != 0; bits &= bits - 1 )
+        parity ^= 1;
+
+    if( !RnW )
+        levels.push_back( BIT_LOW );
+
+    for( size_t ndx = 0; ndx < 32; ++ndx )
+        levels.push_back( ( data >> ndx ) & 1 ? BIT_HIGH : BIT_LOW );
+    levels.push_back( parity ? BIT_HIGH : BIT_LOW );
+}
+
+// the data of an operation, which often looks like the bits around it
+static U32 AdversarialData( std::mt19937& rng )
+{
+    switch( rng() % 4 )
+    {
+    case 0:
+        // valid requests, which the data of an operation isn't
+        return 0xA5A5A5A5 ^ ( rng() % 2 == 0 ? 0 : 0x80008000 );
+    case 1:
+        return rng() % 2 == 0 ? 0 : 0xFFFFFFFF;
+    default:
+        return U32( rng() );
+    }
+}
+
+// Near misses of every kind: operations with every ACK and both data parities,
+// operations cut short, high runs around the length of a line reset, SELECT
+// writes moving the AP bank and CTRLSEL, data made of valid requests, glitches,
+// and pauses long enough to need the wide timestamps.
+static void BuildAdversarial( SWDStreamBuilder& builder, U32 seed, U64 num_bits )
+{
+    std::mt19937 rng( seed );
+    std::vector<BitState> levels;
+
+    while( builder.GetNumBits() < num_bits )
+    {
+        builder.SetClockPeriod( 4 + rng() % 9 );
+
+        const U32 choice = rng() % 10;
+        switch( choice )
+        {
+        case 0:
+            AddRandomBits( builder, rng, 1 + rng() % 64 );
+            break;
+        case 1:
+        case 2:
+        case 3:
+        {
+            MakeOperationBits( rng, rng() % 2 == 0, rng() % 2 == 0, U8( ( rng() % 4 ) << 2 ), AdversarialData( rng ), levels );
+
+            // sometimes only the first bits of it, followed by whatever comes next
+            const size_t num_levels = choice == 3 ? 1 + rng() % ( levels.size() - 1 ) : levels.size();
+            for( size_t ndx = 0; ndx < num_levels; ++ndx )
+                builder.Bit( levels[ ndx ] );
+            break;
+        }
+        case 4:
+            // around the 50 high bits of a line reset
+            for( U32 ndx = 44 + rng() % 12; ndx > 0; --ndx )
+                builder.Bit( BIT_HIGH );
+            break;
+        case 5:
+            if( rng() % 2 == 0 )
+                builder.Idle( 100 + rng() % 5000 );
+            else
+                builder.LineReset( 50 + rng() % 5000 );
+            break;
+        case 6:
+        {
+            // SELECT, with any AP bank and CTRLSEL
+            U32 select = ( rng() % 16 ) << 4;
+            if( rng() % 4 == 0 )
+                select |= 1;
+
+            MakeOperationBits( rng, false, false, 0x8, select, levels );
+            for( size_t ndx = 0; ndx < levels.size(); ++ndx )
+                builder.Bit( levels[ ndx ] );
+            break;
+        }
+        case 7:
+            builder.Glitch( rng() % 2 == 0, 1 + rng() % 2 );
+            break;
+        case 8:
+            // past 32 bits worth of samples now and then
+            builder.Pause( rng() % 64 == 0 ? ( 1ULL << 32 ) + rng() : rng() % 100000 );
+            break;
+        default:
+            builder.Idle( rng() % 4 );
+            break;
+        }
+    }
+}
+
+// OK operations followed by idle runs of every length up to past twice the bits
+// SWDParser buffers ahead, so the high bit that ends a run comes at every offset
+// of the buffered bits, or only in a later batch. Some runs end with a line reset.
+static void BuildTrailing( SWDStreamBuilder& builder, U32 seed, U64 num_bits )
+{
+    std::mt19937 rng( seed );
+
+    builder.SetClockPeriod( 4 );
+    for( U64 idle = 0; builder.GetNumBits() < num_bits; idle = ( idle + 1 ) % 300 )
+    {
+        builder.Operation( rng() % 2 == 0, rng() % 2 == 0, U8( ( rng() % 4 ) << 2 ), ACK_OK, AdversarialData( rng ) );
+        builder.Idle( idle );
+
+        if( rng() % 8 == 0 )
+            builder.LineReset( 50 + rng() % 16 );
+    }
+}
+
+// the same scenarios as swd_generate with the same options
+struct SWDGenerateParams
+{
+    U32 min_period;
+    U32 max_period;
+    U32 jitter;
+
+    std::string mix;
+    std::vector<SWDScenarioGenerator::Scenario> script;
+};
+
+static void BuildGenerated( SWDStreamBuilder& builder, U32 seed, U64 num_bits, const SWDGenerateParams& params )
+{
+    SWDScenarioGenerator generator;
+    if( !params.mix.empty() )
+        generator.SetMix( params.mix );
+
+    builder.SetJitter( params.jitter, seed );
+    generator.Setup( &builder, seed );
+    generator.SetClockPeriodRange( params.min_period, params.max_period );
+
+    // a script runs once, or as many times as it takes to get the bits
+    size_t script_ndx = 0;
+    for( ;; )
+    {
+        if( params.script.empty() )
+        {
+            if( builder.GetNumBits() >= num_bits )
+                break;
+
+            generator.Generate( generator.PickScenario() );
+        }
+        else
+        {
+            if( script_ndx == params.script.size() )
+            {
+                if( builder.GetNumBits() >= num_bits )
+                    break;
+
+                script_ndx = 0;
+            }
+
+            generator.Generate( params.script[ script_ndx++ ] );
+        }
+    }
+
+    builder.Idle( 8 );
+}
+
+// ********************************************************************************
+
+// the SWDIO and SWCLK edge list files of a capture
+class SWDEdgeListCapture : public SWDChannelSource
+{
+  public:
+    bool Open( const std::string& swdio_path, const std::string& swclk_path, std::string& error )
+    {
+        return mFiles[ 0 ].Open( swdio_path, error ) && mFiles[ 1 ].Open( swclk_path, error ) && mSWDIO.Open( mFiles[ 0 ], error ) &&
+               mSWCLK.Open( mFiles[ 1 ], error );
+    }
+
+    virtual SWDChannel* OpenSWDIO()
+    {
+        return OpenChannel( mFiles[ 0 ] );
+    }
+    virtual SWDChannel* OpenSWCLK()
+    {
+        return OpenChannel( mFiles[ 1 ] );
+    }
+
+    virtual U64 GetNumSWCLKEdges()
+    {
+        return mSWCLK.GetNumEdges();
+    }
+    virtual U64 GetSWCLKEdge( U64 ndx )
+    {
+        return mSWCLK.GetEdge( ndx );
+    }
+
+  private:
+    static SWDChannel* OpenChannel( const SWDMappedFile& file )
+    {
+        // the file was opened once already, so this can't fail
+        std::string error;
+        SWDEdgeListChannel* channel = new SWDEdgeListChannel();
+        channel->Open( file, error );
+        return channel;
+    }
+
+    SWDMappedFile mFiles[ 2 ];
+    SWDEdgeListChannel mSWDIO;
+    SWDEdgeListChannel mSWCLK;
+};
+
+// ********************************************************************************
+
+class SWDEventRecorder : public SWDDecodeEventSink
+{
+  public:
+    virtual void OnEvent( const SWDDecodeEvent& event )
+    {
+        mEvents.push_back( event );
+    }
+
+    std::vector<SWDDecodeEvent> mEvents;
+};
+
+// compares the events with the reference's as they come
+class SWDEventChecker : public SWDDecodeEventSink
+{
+  public:
+    SWDEventChecker( const std::vector<SWDDecodeEvent>& expected ) : mExpected( expected ), mNumEvents( 0 ), mDiverged( false )
+    {
+    }
+
+    virtual void OnEvent( const SWDDecodeEvent& event )
+    {
+        if( !mDiverged && ( mNumEvents == mExpected.size() || event != mExpected[ mNumEvents ] ) )
+        {
+            mDiverged = true;
+            mDivergence = mNumEvents;
+            mEvent = event;
+        }
+
+        ++mNumEvents;
+    }
+
+    // reports the first divergence, returns false if there is one
+    bool Check( const std::string& decoder )
+    {
+        if( !mDiverged && mNumEvents < mExpected.size() )
+        {
+            mDiverged = true;
+            mDivergence = mNumEvents;
+        }
+
+        if( !mDiverged )
+            return true;
+
+        std::cerr << "  " << decoder << " diverges from the reference at event " << mDivergence << ":\n";
+
+        for( size_t ndx = mDivergence - std::min( mDivergence, DIFF_CONTEXT_EVENTS ); ndx < mDivergence; ++ndx )
+            std::cerr << "    both:      " << mExpected[ ndx ].ToString() << "\n";
+
+        std::cerr << "    reference: " << ( mDivergence < mExpected.size() ? mExpected[ mDivergence ].ToString() : "nothing" ) << "\n"
+                  << "    " << std::left << std::setw( 11 ) << ( decoder + ":" ) << std::right
+                  << ( mDivergence < mNumEvents ? mEvent.ToString() : "nothing" ) << std::endl;
+
+        return false;
+    }
+
+  private:
+    const std::vector<SWDDecodeEvent>& mExpected;
+    size_t mNumEvents;
+
+    bool mDiverged;
+    size_t mDivergence;
+    SWDDecodeEvent mEvent;
+};
+
+// ********************************************************************************
+
+// the decoders, which all pass on their events through an SWDDecodeEventSource
+
+static void DecodeReference( const std::vector<SWDBit>& bits, SWDDecodeEventSink& sink )
+{
+    SWDDecodeEventSource events;
+    events.Setup( &sink );
+
+    SWDReferenceParser reference;
+    reference.Decode( bits.empty() ? 0 : &bits[ 0 ], bits.size(), events );
+}
+
+// batches of random sizes if batch_rng is given, to catch decodes depending on where Feed stops
+static void DecodeParser( const std::vector<SWDBit>& bits, SWDDecodeEventSink& sink, std::mt19937* batch_rng )
+{
+    SWDDecodeEventSource events;
+    events.Setup( &sink );
+
+    SWDParser parser;
+    parser.Setup( &events );
+    parser.Clear();
+
+    for( size_t ndx = 0; ndx < bits.size(); )
+    {
+        size_t num_bits = batch_rng == 0 ? DIFF_BATCH_BITS : 1 + ( *batch_rng )() % DIFF_BATCH_BITS;
+        num_bits = std::min( num_bits, bits.size() - ndx );
+
+        parser.Feed( &bits[ ndx ], num_bits );
+        ndx += num_bits;
+    }
+
+    parser.Flush();
+    events.Finish();
+}
+
+// samples the channels as well
+static void DecodeChunked( SWDChannelSource& source, size_t jobs, SWDDecodeEventSink& sink )
+{
+    SWDDecodeEventSource events;
+    events.Setup( &sink );
+
+    SWDChunkedDecoder decoder;
+    decoder.Setup( &source, &events, jobs );
+    decoder.Decode();
+
+    events.Finish();
+}
+
+static void SampleAllBits( SWDChannelSource& source, std::vector<SWDBit>& bits )
+{
+    std::unique_ptr<SWDChannel> swdio( source.OpenSWDIO() );
+    std::unique_ptr<SWDChannel> swclk( source.OpenSWCLK() );
+
+    SWDBitSampler sampler;
+    sampler.Setup( swdio.get(), swclk.get() );
+
+    size_t num_bits = 0;
+    try
+    {
+        for( ;; )
+        {
+            bits.resize( num_bits + DIFF_BATCH_BITS );
+            num_bits += sampler.SampleBits( &bits[ num_bits ], DIFF_BATCH_BITS );
+        }
+    }
+    catch( SWDEndOfCapture& )
+    {
+        // there are no more whole bits in the capture
+    }
+
+    bits.resize( num_bits );
+}
+
+// ********************************************************************************
+
+// Checks the decoders on the stream and times them.
+// Returns false if a fast decoder diverges from the reference.
+static bool DiffStream( const std::string& name, SWDChannelSource& source, const SWDDiffOptions& options, SWDDecodeEventHash& hash )
+{
+    std::vector<SWDBit> bits;
+    SampleAllBits( source, bits );
+
+    SWDEventRecorder reference;
+    DecodeReference( bits, reference );
+
+    hash.Clear();
+    for( size_t ndx = 0; ndx < reference.mEvents.size(); ++ndx )
+        hash.OnEvent( reference.mEvents[ ndx ] );
+
+    std::cerr << name << ": " << bits.size() << " bits, " << reference.mEvents.size() << " events (" << hash.mNumOperations
+              << " operations, " << hash.mNumLineResets << " line resets, " << hash.mNumDroppedBits << " dropped bits), hash " << std::hex
+              << std::setfill( '0' ) << std::setw( 16 ) << hash.GetHash() << std::dec << std::setfill( ' ' ) << std::endl;
+
+    bool ok = true;
+
+    std::mt19937 batch_rng( options.seed );
+    SWDEventChecker parser_checker( reference.mEvents );
+    DecodeParser( bits, parser_checker, &batch_rng );
+    ok = parser_checker.Check( "parser" ) && ok;
+
+    SWDEventChecker chunked_checker( reference.mEvents );
+    DecodeChunked( source, options.jobs, chunked_checker );
+    ok = chunked_checker.Check( "chunked" ) && ok;
+
+    if( options.repeat <= 0 || bits.empty() )
+        return ok;
+
+    // the fastest of the runs counts, with nothing but hashing behind the decoders
+    double best[ 3 ] = { 0, 0, 0 };
+    for( int ndx = 0; ndx < options.repeat; ++ndx )
+    {
+        SWDDecodeEventHash sink;
+        double seconds[ 3 ];
+
+        SWDDiffClock::time_point start = SWDDiffClock::now();
+        DecodeReference( bits, sink );
+        seconds[ 0 ] = SecondsSince( start );
+
+        start = SWDDiffClock::now();
+        DecodeParser( bits, sink, 0 );
+        seconds[ 1 ] = SecondsSince( start );
+
+        start = SWDDiffClock::now();
+        DecodeChunked( source, options.jobs, sink );
+        seconds[ 2 ] = SecondsSince( start );
+
+        for( int dndx = 0; dndx < 3; ++dndx )
+            if( ndx == 0 || seconds[ dndx ] < best[ dndx ] )
+                best[ dndx ] = seconds[ dndx ];
+    }
+
+    static const char* DECODERS[ 3 ] = { "reference", "parser", "chunked, sampling too" };
+    for( int dndx = 0; dndx < 3; ++dndx )
+        std::cerr << "  " << std::left << std::setw( 22 ) << DECODERS[ dndx ] << std::right << std::fixed << std::setprecision( 1 )
+                  << std::setw( 9 ) << bits.size() / best[ dndx ] / 1e6 << " Mbit/s" << std::setw( 8 ) << best[ 0 ] / best[ dndx ] << "x\n";
+    std::cerr << std::defaultfloat << std::setprecision( 6 );
+
+    return ok;
+}
+
+// ********************************************************************************
+
+// One line of a corpus file: the name of the entry, what its stream is and
+// what the reference decodes of it, all as key=value:
+//   random=N or adversarial=N     N random or adversarial bits
+//   trailing=N                    N bits of operations followed by idle runs of every length
+//   generate=N                    about N bits of swd_generate's scenarios, with its
+//                                 period=MIN[:MAX], jitter=N, mix=... and script=... options
+//   capture=SWDIO,SWCLK           edge list files, relative to the corpus file
+//   seed=N                        the seed of the made up streams, 1 by default
+//   expect=BITS/OPERATIONS/LINE_RESETS/DROPPED_BITS/HASH
+// Everything after a # is a comment.
+struct SWDCorpusEntry
+{
+    std::string name;
+
+    std::string kind;
+    U64 num_bits;
+    U32 seed;
+    SWDGenerateParams params;
+
+    std::string swdio_path;
+    std::string swclk_path;
+
+    std::string expect;
+};
+
+static bool ParseCorpusEntry( const std::string& line, const std::string& dir, SWDCorpusEntry& entry, std::string& error )
+{
+    std::istringstream is( line.substr( 0, line.find( '#' ) ) );
+    if( !( is >> entry.name ) )
+        return false;
+
+    entry.num_bits = 0;
+    entry.seed = 1;
+    entry.params.min_period = entry.params.max_period = 8;
+    entry.params.jitter = 0;
+
+    std::string item;
+    while( is >> item )
+    {
+        const size_t eq = item.find( '=' );
+        const std::string key = item.substr( 0, eq );
+        const std::string value = eq == std::string::npos ? "" : item.substr( eq + 1 );
+
+        bool valid = true;
+        if( key == "random" || key == "adversarial" || key == "trailing" || key == "generate" )
+        {
+            entry.kind = key;
+            valid = SWDScenarioGenerator::ParseCount( value, entry.num_bits );
+        }
+        else if( key == "capture" )
+        {
+            const size_t comma = value.find( ',' );
+            entry.kind = key;
+            entry.swdio_path = dir + value.substr( 0, comma );
+            entry.swclk_path = comma == std::string::npos ? "" : dir + value.substr( comma + 1 );
+        }
+        else if( key == "seed" )
+            entry.seed = U32( strtoul( value.c_str(), 0, 10 ) );
+        else if( key == "period" )
+        {
+            char* end = 0;
+            entry.params.min_period = U32( strtoul( value.c_str(), &end, 10 ) );
+            entry.params.max_period = *end == ':' ? U32( strtoul( end + 1, 0, 10 ) ) : entry.params.min_period;
+        }
+        else if( key == "jitter" )
+            entry.params.jitter = U32( strtoul( value.c_str(), 0, 10 ) );
+        else if( key == "mix" )
+        {
+            SWDScenarioGenerator generator;
+            entry.params.mix = value;
+            valid = generator.SetMix( value );
+        }
+        else if( key == "script" )
+            valid = SWDScenarioGenerator::ParseScript( value, entry.params.script );
+        else if( key == "expect" )
+            entry.expect = value;
+        else
+            valid = false;
+
+        if( !valid )
+        {
+            error = "bad " + item;
+            return false;
+        }
+    }
+
+    if( entry.kind.empty() )
+    {
+        error = "no stream";
+        return false;
+    }
+
+    return true;
+}
+
+static std::string FormatExpect( const SWDDecodeEventHash& hash )
+{
+    std::ostringstream os;
+    os << hash.mNumBits << "/" << hash.mNumOperations << "/" << hash.mNumLineResets << "/" << hash.mNumDroppedBits << "/" << std::hex
+       << std::setfill( '0' ) << std::setw( 16 ) << hash.GetHash();
+    return os.str();
+}
+
+static bool DiffEntry( const SWDCorpusEntry& entry, const SWDDiffOptions& options, SWDDecodeEventHash& hash, std::string& error )
+{
+    if( entry.kind == "capture" )
+    {
+        SWDEdgeListCapture capture;
+        if( !capture.Open( entry.swdio_path, entry.swclk_path, error ) )
+            return false;
+
+        return DiffStream( entry.name, capture, options, hash );
+    }
+
+    SWDStreamBuilder builder;
+    if( entry.kind == "random" )
+        BuildRandom( builder, entry.seed, entry.num_bits );
+    else if( entry.kind == "adversarial" )
+        BuildAdversarial( builder, entry.seed, entry.num_bits );
+    else if( entry.kind == "trailing" )
+        BuildTrailing( builder, entry.seed, entry.num_bits );
+    else
+        BuildGenerated( builder, entry.seed, entry.num_bits, entry.params );
+
+    return DiffStream( entry.name, builder, options, hash );
+}
+
+// Checks all the entries, and the reference's events against the expected ones.
+// With update the expected events are written back to the file instead.
+static int DiffCorpus( const std::string& path, bool update, const SWDDiffOptions& options )
+{
+    std::ifstream is( path.c_str() );
+    if( !is )
+    {
+        std::cerr << "can't open " << path << std::endl;
+        return 1;
+    }
+
+    const size_t slash = path.find_last_of( "/\\" );
+    const std::string dir = slash == std::string::npos ? "" : path.substr( 0, slash + 1 );
+
+    int ret_val = 0;
+    std::vector<std::string> lines;
+    std::string line;
+    for( size_t line_num = 1; std::getline( is, line ); ++line_num )
+    {
+        lines.push_back( line );
+
+        std::string error;
+        SWDCorpusEntry entry;
+        if( !ParseCorpusEntry( line, dir, entry, error ) )
+        {
+            if( !error.empty() )
+            {
+                std::cerr << path << ":" << line_num << ": " << error << std::endl;
+                ret_val = 1;
+            }
+            continue;
+        }
+
+        SWDDecodeEventHash hash;
+        if( !DiffEntry( entry, options, hash, error ) )
+        {
+            if( !error.empty() )
+                std::cerr << entry.name << ": " << error << std::endl;
+            ret_val = 1;
+            continue;
+        }
+
+        const std::string expect = FormatExpect( hash );
+        if( update )
+        {
+            const size_t pos = line.find( "expect=" );
+            if( pos == std::string::npos )
+                lines.back() = line + " expect=" + expect;
+            else
+            {
+                const size_t end = std::min( line.find_first_of( " \t#", pos ), line.size() );
+                lines.back() = line.substr( 0, pos ) + "expect=" + expect + line.substr( end );
+            }
+        }
+        else if( entry.expect != expect )
+        {
+            std::cerr << "  the reference decodes " << expect << ", the corpus expects " << ( entry.expect.empty() ? "nothing" : entry.expect )
+                      << std::endl;
+            ret_val = 1;
+        }
+    }
+
+    if( update )
+    {
+        is.close();
+        std::ofstream os( path.c_str(), std::ios::out );
+        for( size_t ndx = 0; ndx < lines.size(); ++ndx )
+            os << lines[ ndx ] << "\n";
+
+        if( !os )
+        {
+            std::cerr << "can't write " << path << std::endl;
+            return 1;
+        }
+    }
+
+    return ret_val;
+}
+
+// ********************************************************************************
+
+// DecodeDataPhase against DecodeDataPhaseScalar
+
+static bool IsSameDataPhase( U64 levels )
+{
+    const SWDDataPhase fast = DecodeDataPhase( levels );
+    const SWDDataPhase scalar = DecodeDataPhaseScalar( levels );
+    if( fast.data == scalar.data && fast.data_parity == scalar.data_parity && fast.data_parity_ok == scalar.data_parity_ok )
+        return true;
+
+    std::cerr << "data phase: levels 0x" << std::hex << std::setw( 16 ) << std::setfill( '0' ) << levels << std::dec << std::setfill( ' ' )
+              << " decode to data 0x" << std::hex << fast.data << std::dec << ", parity " << int( fast.data_parity ) << ( fast.data_parity_ok ? " ok" : " bad" )
+              << " instead of data 0x" << std::hex << scalar.data << std::dec << ", parity " << int( scalar.data_parity )
+              << ( scalar.data_parity_ok ? " ok" : " bad" ) << std::endl;
+    return false;
+}
+
+// Checks that both data phase decoders give the same results for data which
+// makes the parity flip at every bit, both parity bits, and every ACK in the
+// 3 bits after the parity bit, as the ACK of the next operation would be,
+// then for num_random random levels. Returns false at the first difference.
+static bool DiffDataPhase( U32 seed, U64 num_random )
+{
+    std::vector<U32> data;
+    data.push_back( 0 );
+    data.push_back( 0xffffffff );
+    data.push_back( 0x55555555 );
+    data.push_back( 0xaaaaaaaa );
+    for( U32 bit = 0; bit < 32; ++bit )
+    {
+        data.push_back( U32( 1 ) << bit );
+        data.push_back( ~( U32( 1 ) << bit ) );
+        data.push_back( 0xffffffff >> bit );
+    }
+
+    // the bits after the ACK low and high
+    const U64 rest[] = { 0, ~U64( 0 ) << 36 };
+
+    U64 num_checked = 0;
+    for( size_t ndx = 0; ndx < data.size(); ++ndx )
+    {
+        for( U64 parity = 0; parity < 2; ++parity )
+        {
+            for( U64 ack = 0; ack < 8; ++ack )
+            {
+                for( size_t ri = 0; ri < sizeof( rest ) / sizeof( rest[ 0 ] ); ++ri )
+                {
+                    if( !IsSameDataPhase( data[ ndx ] | parity << 32 | ack << 33 | rest[ ri ] ) )
+                        return false;
+
+                    ++num_checked;
+                }
+            }
+        }
+    }
+
+    std::mt19937_64 rng( seed );
+    for( U64 ndx = 0; ndx < num_random; ++ndx )
+    {
+        if( !IsSameDataPhase( rng() ) )
+            return false;
+    }
+
+    std::cout << "data phase: " << num_checked << " edge patterns and " << num_random << " random levels decode the same" << std::endl;
+    return true;
+}
+
+static void PrintUsage()
+{
+    std::cerr << "usage: swd_diff [options] [swdio_file,swclk_file...]\n"
+                 "\n"
+                 "Decodes each stream with the reference decoder, SWDParser and SWDChunkedDecoder,\n"
+                 "reports where the fast ones first decode something else and times them all.\n"
+                 "The capture files are raw edge lists, as written by swd_generate.\n"
+                 "\n"
+                 "options:\n"
+                 "  --random N            a stream of N random bits, with an optional k, M or G suffix\n"
+                 "  --adversarial N       a stream of N bits of near misses\n"
+                 "  --corpus FILE         the entries of a corpus file, and the results they expect\n"
+                 "  --data-phase N        check DecodeDataPhase against DecodeDataPhaseScalar on its\n"
+                 "                        edge patterns and N random levels\n"
+                 "  --update              write what the reference decodes back to the corpus file\n"
+                 "  --seed N              seed of the random and adversarial streams, 1 by default\n"
+                 "  --jobs N              SWDChunkedDecoder threads, 0 for one per core, 0 by default\n"
+                 "  --repeat N            time each decoder N times, the fastest run counts;\n"
+                 "                        3 by default, 0 to only check them\n";
+}
+
+int main( int argc, char* argv[] )
+{
+    SWDDiffOptions options;
+    options.seed = 1;
+    options.jobs = 0;
+    options.repeat = 3;
+
+    U64 num_random_bits = 0;
+    U64 num_adversarial_bits = 0;
+    U64 num_data_phase_levels = 0;
+    bool check_data_phase = false;
+    std::string corpus_file;
+    bool update = false;
+    std::vector<std::string> captures;
+
+    for( int ndx = 1; ndx < argc; ++ndx )
+    {
+        const std::string arg = argv[ ndx ];
+        const bool has_value = ndx + 1 < argc;
+
+        if( arg == "--seed" && has_value )
+            options.seed = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--jobs" && has_value )
+            options.jobs = size_t( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--repeat" && has_value )
+            options.repeat = atoi( argv[ ++ndx ] );
+        else if( arg == "--corpus" && has_value )
+            corpus_file = argv[ ++ndx ];
+        else if( arg == "--update" )
+            update = true;
+        else if( arg == "--data-phase" && has_value )
+        {
+            check_data_phase = true;
+            if( !SWDScenarioGenerator::ParseCount( argv[ ++ndx ], num_data_phase_levels ) )
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( ( arg == "--random" || arg == "--adversarial" ) && has_value )
+        {
+            if( !SWDScenarioGenerator::ParseCount( argv[ ++ndx ], arg == "--random" ? num_random_bits : num_adversarial_bits ) )
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( arg.size() > 1 && arg[ 0 ] == '-' )
+        {
+            PrintUsage();
+            return 2;
+        }
+        else
+            captures.push_back( arg );
+    }
+
+    if( num_random_bits == 0 && num_adversarial_bits == 0 && corpus_file.empty() && captures.empty() && !check_data_phase )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    int ret_val = 0;
+    SWDDecodeEventHash hash;
+
+    if( check_data_phase && !DiffDataPhase( options.seed, num_data_phase_levels ) )
+        ret_val = 1;
+
+    if( num_random_bits != 0 )
+    {
+        SWDStreamBuilder builder;
+        BuildRandom( builder, options.seed, num_random_bits );
+        if( !DiffStream( "random", builder, options, hash ) )
+            ret_val = 1;
+    }
+
+    if( num_adversarial_bits != 0 )
+    {
+        SWDStreamBuilder builder;
+        BuildAdversarial( builder, options.seed, num_adversarial_bits );
+        if( !DiffStream( "adversarial", builder, options, hash ) )
+            ret_val = 1;
+    }
+
+    for( size_t ndx = 0; ndx < captures.size(); ++ndx )
+    {
+        const std::string& capture = captures[ ndx ];
+        const size_t comma = capture.find( ',' );
+
+        std::string error;
+        SWDEdgeListCapture cap;
+        if( comma == std::string::npos || !cap.Open( capture.substr( 0, comma ), capture.substr( comma + 1 ), error ) )
+        {
+            std::cerr << capture << ": " << ( error.empty() ? "not a pair of edge list files" : error ) << std::endl;
+            ret_val = 1;
+            continue;
+        }
+
+        if( !DiffStream( capture, cap, options, hash ) )
+            ret_val = 1;
+    }
+
+    if( !corpus_file.empty() && DiffCorpus( corpus_file, update, options ) != 0 )
+        ret_val = 1;
+
+    return ret_val;
+}
@@ -0,0 +1,219 @@
+// swd_generate: writes large made up SWD captures for the offline tools.
+//
+// The stream is built out of scenarios by SWDScenarioGenerator, either picked
+// at random by weight or in the order given by a script, and written as a pair
+// of raw edge list files, which swd_decode reads as prefix.swdio.edges,prefix.swclk.edges.
+// The transitions are written out as they're built, so the captures can be
+// much bigger than memory. The same seed and options give the same capture.
+// Run it without arguments for the usage.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SWDCaptureFile.h"
+#include "SWDScenarioGenerator.h"
+#include "SWDStreamBuilder.h"
+
+// the builder's transitions are written out once there are this many
+const size_t GENERATE_FLUSH_EDGES = 1 << 20;
+
+struct SWDGenerateOptions
+{
+    U32 seed;
+    U64 num_bits;
+    U32 sample_rate;
+    U32 min_period;
+    U32 max_period;
+    U32 jitter;
+
+    std::vector<SWDScenarioGenerator::Scenario> script;
+    std::string output_prefix;
+};
+
+static bool Flush( SWDStreamBuilder& builder, SWDEdgeListWriter& swdio, SWDEdgeListWriter& swclk, std::string& error )
+{
+    const std::vector<U64>& swdio_edges = builder.GetSWDIOEdges();
+    const std::vector<U64>& swclk_edges = builder.GetSWCLKEdges();
+
+    if( !swdio.Write( swdio_edges.empty() ? 0 : &swdio_edges[ 0 ], swdio_edges.size(), error ) ||
+        !swclk.Write( swclk_edges.empty() ? 0 : &swclk_edges[ 0 ], swclk_edges.size(), error ) )
+        return false;
+
+    builder.ClearEdges();
+    return true;
+}
+
+static void PrintUsage()
+{
+    std::cerr << "usage: swd_generate [options] output_prefix\n"
+                 "\n"
+                 "Writes output_prefix.swdio.edges and output_prefix.swclk.edges.\n"
+                 "\n"
+                 "options:\n"
+                 "  --seed N              seed of the random choices, 1 by default\n"
+                 "  --bits N              stop after about N bits, with an optional k, M or G suffix;\n"
+                 "                        1M by default, or the script once if there's one\n"
+                 "  --sample-rate HZ      sample rate written to the files, 100000000 by default\n"
+                 "  --period MIN[:MAX]    SWCLK period in samples, picked for each scenario, 8 by default\n"
+                 "  --jitter N            move the SWCLK edges by up to N samples\n"
+                 "  --mix NAME=W,...      the scenarios picked at random and their weights, all 1 by default\n"
+                 "  --script NAME[*N],... the scenarios in this order instead, repeated to reach --bits\n"
+                 "  --list                list the scenarios\n";
+}
+
+int main( int argc, char* argv[] )
+{
+    SWDGenerateOptions options;
+    options.seed = 1;
+    options.num_bits = 0;
+    options.sample_rate = 100000000;
+    options.min_period = 8;
+    options.max_period = 8;
+    options.jitter = 0;
+
+    SWDScenarioGenerator generator;
+
+    for( int ndx = 1; ndx < argc; ++ndx )
+    {
+        const std::string arg = argv[ ndx ];
+        const bool has_value = ndx + 1 < argc;
+
+        if( arg == "--seed" && has_value )
+            options.seed = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--sample-rate" && has_value )
+            options.sample_rate = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--jitter" && has_value )
+            options.jitter = U32( strtoul( argv[ ++ndx ], 0, 10 ) );
+        else if( arg == "--bits" && has_value )
+        {
+            if( !SWDScenarioGenerator::ParseCount( argv[ ++ndx ], options.num_bits ) )
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else if( arg == "--period" && has_value )
+        {
+            char* end = 0;
+            options.min_period = U32( strtoul( argv[ ++ndx ], &end, 10 ) );
+            options.max_period = *end == ':' ? U32( strtoul( end + 1, 0, 10 ) ) : options.min_period;
+        }
+        else if( arg == "--mix" && has_value )
+        {
+            if( !generator.SetMix( argv[ ++ndx ] ) )
+            {
+                std::cerr << "unknown scenario in " << argv[ ndx ] << std::endl;
+                return 2;
+            }
+        }
+        else if( arg == "--script" && has_value )
+        {
+            if( !SWDScenarioGenerator::ParseScript( argv[ ++ndx ], options.script ) )
+            {
+                std::cerr << "unknown scenario in " << argv[ ndx ] << std::endl;
+                return 2;
+            }
+        }
+        else if( arg == "--list" )
+        {
+            for( size_t sndx = 0; sndx < SWDScenarioGenerator::NUM_SCENARIOS; ++sndx )
+                std::cout << SWDScenarioGenerator::GetScenarioName( SWDScenarioGenerator::Scenario( sndx ) ) << std::endl;
+            return 0;
+        }
+        else if( arg.size() > 1 && arg[ 0 ] == '-' )
+        {
+            PrintUsage();
+            return 2;
+        }
+        else
+            options.output_prefix = arg;
+    }
+
+    if( options.output_prefix.empty() || options.sample_rate == 0 || options.min_period < 2 )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if( options.num_bits == 0 && options.script.empty() )
+        options.num_bits = 1000000;
+
+    SWDStreamBuilder builder;
+    builder.SetJitter( options.jitter, options.seed );
+
+    generator.Setup( &builder, options.seed );
+    generator.SetClockPeriodRange( options.min_period, options.max_period );
+
+    std::string error;
+    SWDEdgeListWriter swdio;
+    SWDEdgeListWriter swclk;
+    if( !swdio.Open( options.output_prefix + ".swdio.edges", BIT_LOW, options.sample_rate, error ) ||
+        !swclk.Open( options.output_prefix + ".swclk.edges", BIT_LOW, options.sample_rate, error ) )
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // a script runs once, or as many times as it takes to get the bits
+    size_t script_ndx = 0;
+    for( ;; )
+    {
+        if( options.script.empty() )
+        {
+            if( builder.GetNumBits() >= options.num_bits )
+                break;
+
+            generator.Generate( generator.PickScenario() );
+        }
+        else
+        {
+            if( script_ndx == options.script.size() )
+            {
+                if( builder.GetNumBits() >= options.num_bits )
+                    break;
+
+                script_ndx = 0;
+            }
+
+            generator.Generate( options.script[ script_ndx++ ] );
+        }
+
+        if( builder.GetSWCLKEdges().size() >= GENERATE_FLUSH_EDGES && !Flush( builder, swdio, swclk, error ) )
+        {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    // a few idle bits at the end, so the last operation is complete
+    builder.Idle( 8 );
+
+    if( !Flush( builder, swdio, swclk, error ) || !swdio.Close( error ) || !swclk.Close( error ) )
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    for( size_t ndx = 0; ndx < SWDScenarioGenerator::NUM_SCENARIOS; ++ndx )
+    {
+        const SWDScenarioGenerator::Scenario scenario = SWDScenarioGenerator::Scenario( ndx );
+        if( generator.GetNumGenerated( scenario ) != 0 )
+            std::cerr << SWDScenarioGenerator::GetScenarioName( scenario ) << ": " << generator.GetNumGenerated( scenario ) << "\n";
+    }
+
+    std::cerr << "operations: " << generator.GetNumOperations() << " (" << generator.GetNumWaits() << " WAIT, " << generator.GetNumFaults()
+              << " FAULT)\n"
+              << "bits: " << builder.GetNumBits() << "\n"
+              << "samples: " << builder.GetSampleNumber() << "\n"
+              << "edges: " << swdio.GetNumEdges() << " SWDIO, " << swclk.GetNumEdges() << " SWCLK\n"
+              << "written in " << seconds << " s" << std::endl;
+
+    return 0;
+}
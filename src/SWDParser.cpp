@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <chrono>
+
+#include "SWDBitScanner.h"
+#include "SWDDataPhase.h"
+#include "SWDParser.h"
+#include "SWDTrace.h"
+
+// The request decode tables are generated at compile time.
+
+template <unsigned... N>
+struct SWDIndexList
+{
+};
+
+template <unsigned C, unsigned... N>
+struct SWDMakeIndexList : SWDMakeIndexList<C - 1, C - 1, N...>
+{
+};
+
+template <unsigned... N>
+struct SWDMakeIndexList<0, N...>
+{
+    typedef SWDIndexList<N...> type;
+};
+
+constexpr bool IsValidRequest( unsigned rb )
+{
+    // constant bits (start, stop & park) and parity over APnDP, RnW, A[2..3]
+    return ( rb & 0xC1 ) == 0x81 && ( ( rb >> 5 ) & 1 ) == ( ( ( rb >> 1 ) ^ ( rb >> 2 ) ^ ( rb >> 3 ) ^ ( rb >> 4 ) ) & 1 );
+}
+
+constexpr SWDRegisters MakeDPRegister( unsigned rb, bool ctrlsel )
+{
+    return ( rb & 0x02 ) != 0                ? SWDR_undefined
+           : ( ( rb & 0x18 ) >> 1 ) == 0x0 ? ( ( rb & 0x04 ) != 0 ? SWDR_DP_IDCODE : SWDR_DP_ABORT )
+           : ( ( rb & 0x18 ) >> 1 ) == 0x4 ? ( ctrlsel ? SWDR_DP_WCR : SWDR_DP_CTRL_STAT )
+           : ( ( rb & 0x18 ) >> 1 ) == 0x8 ? ( ( rb & 0x04 ) != 0 ? SWDR_DP_RESEND : SWDR_DP_SELECT )
+                                             : ( ( rb & 0x04 ) != 0 ? SWDR_DP_RDBUFF : SWDR_DP_ROUTESEL );
+}
+
+constexpr SWDRequestInfo MakeRequestInfo( unsigned rb )
+{
+    return SWDRequestInfo{ IsValidRequest( rb ),
+                           ( rb & 0x02 ) != 0,
+                           ( rb & 0x04 ) != 0,
+                           U8( ( rb & 0x18 ) >> 1 ),
+                           U8( ( rb & 0x20 ) != 0 ? 1 : 0 ),
+                           MakeDPRegister( rb, false ),
+                           MakeDPRegister( rb, true ) };
+}
+
+// apreg is APBANKSEL | A[2..3]
+constexpr SWDRegisters MakeAPRegister( unsigned apreg )
+{
+    return apreg == 0x00   ? SWDR_AP_CSW
+           : apreg == 0x04 ? SWDR_AP_TAR
+           : apreg == 0x0C ? SWDR_AP_DRW
+           : apreg == 0x10 ? SWDR_AP_BD0
+           : apreg == 0x14 ? SWDR_AP_BD1
+           : apreg == 0x18 ? SWDR_AP_BD2
+           : apreg == 0x1C ? SWDR_AP_BD3
+           : apreg == 0xF4 ? SWDR_AP_CFG
+           : apreg == 0xF8 ? SWDR_AP_BASE
+           : apreg == 0xFC ? SWDR_AP_IDR
+                           : SWDR_AP_RAZ_WI;
+}
+
+struct SWDRequestTable
+{
+    SWDRequestInfo entries[ 256 ];
+};
+
+struct SWDAPRegisterTable
+{
+    SWDRegisters entries[ 64 ]; // indexed by apreg / 4
+};
+
+template <unsigned... N>
+constexpr SWDRequestTable MakeRequestTable( SWDIndexList<N...> )
+{
+    return SWDRequestTable{ { MakeRequestInfo( N )... } };
+}
+
+template <unsigned... N>
+constexpr SWDAPRegisterTable MakeAPRegisterTable( SWDIndexList<N...> )
+{
+    return SWDAPRegisterTable{ { MakeAPRegister( N << 2 )... } };
+}
+
+constexpr SWDRequestTable REQUEST_TABLE = MakeRequestTable( SWDMakeIndexList<256>::type() );
+constexpr SWDAPRegisterTable AP_REGISTER_TABLE = MakeAPRegisterTable( SWDMakeIndexList<64>::type() );
+
+static_assert( REQUEST_TABLE.entries[ 0xA5 ].valid && REQUEST_TABLE.entries[ 0xA5 ].dp_reg == SWDR_DP_IDCODE, "bad request table" );
+static_assert( !REQUEST_TABLE.entries[ 0xA7 ].valid && !REQUEST_TABLE.entries[ 0x85 ].valid, "bad request table" );
+static_assert( AP_REGISTER_TABLE.entries[ 0xFC >> 2 ] == SWDR_AP_IDR, "bad AP register table" );
+
+const SWDRequestInfo& GetRequestInfo( U8 request_byte )
+{
+    return REQUEST_TABLE.entries[ request_byte ];
+}
+
+SWDRegisters GetAPRegister( U32 select_reg, U8 addr )
+{
+    return AP_REGISTER_TABLE.entries[ ( ( select_reg & 0xf0 ) | addr ) >> 2 ];
+}
+
+// ********************************************************************************
+
+void SWDOperation::Clear()
+{
+    RnW = false;
+    APnDP = false;
+    data_parity_ok = false;
+
+    addr = 0;
+    parity_read = 0;
+    request_byte = 0;
+    ACK = 0;
+    data = 0;
+    data_parity = 0;
+    reg = SWDR_undefined;
+
+    bits.Clear();
+    trailing.Clear( BIT_LOW );
+}
+
+void SWDOperation::SetRegister( U32 select_reg )
+{
+    // AccessPort or DebugPort?
+    if( APnDP )
+        reg = GetAPRegister( select_reg, addr );
+    else if( ( select_reg & 1 ) != 0 )
+        reg = GetRequestInfo( request_byte ).dp_reg_ctrlsel;
+    else
+        reg = GetRequestInfo( request_byte ).dp_reg;
+}
+
+// ********************************************************************************
+
+// the FNV-1a prime, which mixes whole values rather than bytes here since the
+// fingerprint is only compared within one run of the program
+const U64 FINGERPRINT_PRIME = 0x100000001b3ULL;
+
+U64 SWDParserCheckpoint::AddToFingerprint( U64 fingerprint, const SWDBit& bit )
+{
+    fingerprint = ( fingerprint ^ ( U64( bit.rising ) << 1 | ( bit.state_rising == BIT_HIGH ) ) ) * FINGERPRINT_PRIME;
+    return ( fingerprint ^ ( U64( bit.falling ) << 1 | ( bit.state_falling == BIT_HIGH ) ) ) * FINGERPRINT_PRIME;
+}
+
+// ********************************************************************************
+
+SWDParser::SWDParser() : mListener( 0 ), mSelectRegister( 0 ), mState( PS_SEARCH ), mTimeAttempts( false )
+{
+    Clear();
+}
+
+void SWDParser::Setup( SWDParserListener* pListener )
+{
+    mListener = pListener;
+}
+
+void SWDParser::Clear()
+{
+    mBitsBuffer.Clear();
+    mSelectRegister = 0;
+    mState = PS_SEARCH;
+
+    mStats = SWDParserStats();
+    mCheckpoint = SWDParserCheckpoint();
+}
+
+void SWDParser::Resume( const SWDParserCheckpoint& checkpoint )
+{
+    Clear();
+
+    mSelectRegister = checkpoint.select_register;
+    mCheckpoint = checkpoint;
+}
+
+// the number of bits we buffer ahead of the decode, enough to decide
+// about all the offsets SWDBitScanner looks at
+const size_t PARSER_LOOKAHEAD_BITS = 128;
+
+void SWDParser::Feed( const SWDBit* bits, size_t num_bits )
+{
+    SWD_TRACE_SPAN( "Feed" );
+
+    mStats.bits_fed += num_bits;
+
+    size_t ndx = 0;
+    for( ;; )
+    {
+        // decode as far as the buffered bits go
+        while( Step() )
+            ;
+
+        if( ndx == num_bits )
+            break;
+
+        // the bits of a run don't need to be buffered
+        if( ( mState == PS_OPERATION_IDLE || mState == PS_LINE_RESET ) && mBitsBuffer.Empty() )
+        {
+            ndx += ExtendRun( bits + ndx, num_bits - ndx );
+            if( ndx == num_bits )
+                break;
+        }
+
+        // buffer at least one more bit, since the buffered ones weren't enough
+        size_t cnt = mBitsBuffer.Size() < PARSER_LOOKAHEAD_BITS ? PARSER_LOOKAHEAD_BITS - mBitsBuffer.Size() : 1;
+        cnt = std::min( cnt, num_bits - ndx );
+        while( cnt-- > 0 )
+            mBitsBuffer.PushBack( bits[ ndx++ ] );
+
+        mStats.peak_buffered_bits = std::max( mStats.peak_buffered_bits, mBitsBuffer.Size() );
+    }
+
+    mStats.buffered_bits = mBitsBuffer.Size();
+}
+
+void SWDParser::Flush()
+{
+    while( Step() )
+        ;
+
+    if( mState == PS_OPERATION_IDLE )
+        PassOperation();
+    else if( mState == PS_LINE_RESET )
+        PassLineReset();
+
+    if( mState != PS_DROPPING )
+        mDropped.Clear( BIT_LOW );
+
+    mBitsBuffer.AddTo( mDropped, 0, mBitsBuffer.Size() );
+    if( !mDropped.Empty() )
+    {
+        mStats.bits_dropped += mDropped.count;
+        mListener->OnDroppedBits( mDropped );
+    }
+
+    mBitsBuffer.Clear();
+    mState = PS_SEARCH;
+    mStats.buffered_bits = 0;
+}
+
+bool SWDParser::Step()
+{
+    switch( mState )
+    {
+    case PS_SEARCH:
+        return StepSearch();
+    case PS_DROPPING:
+        return StepDropping();
+    default:
+        return StepRun();
+    }
+}
+
+bool SWDParser::StepSearch()
+{
+    // the bits of the previous operation have been used by now
+    mBitsBuffer.ReleaseConsumed();
+
+    ParseResult res;
+    if( mTimeAttempts )
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        res = IsOperation( mOperation );
+        mStats.operation_attempt_ns +=
+            U64( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count() );
+    }
+    else
+        res = IsOperation( mOperation );
+
+    if( res == PR_MATCH )
+    {
+        // only OK operations are followed by idle bits
+        if( mOperation.ACK == ACK_OK )
+            mState = PS_OPERATION_IDLE;
+        else
+            PassOperation();
+
+        return true;
+    }
+
+    if( res == PR_NO_MATCH )
+        res = IsLineReset();
+
+    if( res == PR_MATCH )
+    {
+        ++mStats.line_resets;
+        mLineReset.Clear();
+        mState = PS_LINE_RESET;
+        return true;
+    }
+
+    if( res == PR_NEED_MORE_BITS )
+        return false;
+
+    // This is neither a valid transaction nor a valid reset,
+    // so drop the first bit and the following ones that can't start either.
+    mDropped.Clear( BIT_LOW );
+    mBitsBuffer.AddTo( mDropped, 0, 1 );
+    mBitsBuffer.Consume( 1 );
+    mState = PS_DROPPING;
+
+    return true;
+}
+
+bool SWDParser::StepDropping()
+{
+    mBitsBuffer.ReleaseConsumed();
+
+    const size_t num_bits = mBitsBuffer.Size();
+    const U64 lo = mBitsBuffer.GetRisingLevels( 0 );
+    const U64 hi = mBitsBuffer.GetRisingLevels( 64 );
+
+    const U64 candidates = SWDBitScanner::FindRequests( lo, hi ) | SWDBitScanner::FindLineResets( lo, hi );
+
+    // We can't tell anything yet about the offsets that don't have a whole request
+    // after them, or which are followed only by ones that are too few for a line reset.
+    U64 undecided = SWDBitScanner::MaskFrom( S64( num_bits ) - REQUEST_LENGTH + 1 );
+    undecided |= SWDBitScanner::FindOpenRuns( lo, hi, num_bits ) &
+                 SWDBitScanner::MaskFrom( S64( num_bits ) - S64( SWDBitScanner::LINE_RESET_BITS ) + 1 );
+
+    const int skip = CountTrailingZeros64( candidates | undecided );
+    mBitsBuffer.AddTo( mDropped, 0, size_t( skip ) );
+    mBitsBuffer.Consume( size_t( skip ) );
+
+    if( skip < 64 && ( candidates >> skip ) & 1 )
+    {
+        mStats.bits_dropped += mDropped.count;
+        mListener->OnDroppedBits( mDropped );
+        mState = PS_SEARCH;
+        return true;
+    }
+
+    return skip > 0;
+}
+
+bool SWDParser::StepRun()
+{
+    SWDBitRun& run = GetRun();
+
+    // the line reset's bits aren't viewed by anyone, unlike the operation's
+    if( mState == PS_LINE_RESET )
+        mBitsBuffer.ReleaseConsumed();
+
+    // find the first buffered bit with the other level
+    const U64 run_levels = run.level == BIT_HIGH ? ~0ULL : 0;
+    const size_t num_bits = mBitsBuffer.Size();
+    size_t run_length = 0;
+    while( run_length < num_bits )
+    {
+        U64 ends = mBitsBuffer.GetRisingLevels( run_length ) ^ run_levels;
+        if( num_bits - run_length < 64 )
+            ends &= ( 1ULL << ( num_bits - run_length ) ) - 1;
+
+        if( ends != 0 )
+        {
+            run_length += size_t( CountTrailingZeros64( ends ) );
+            break;
+        }
+
+        run_length = std::min( run_length + 64, num_bits );
+    }
+
+    mBitsBuffer.AddTo( run, 0, run_length );
+    mBitsBuffer.Consume( run_length );
+
+    if( run_length == num_bits )
+        return false;
+
+    // the bit that ended the run belongs to whatever follows
+    if( mState == PS_OPERATION_IDLE )
+        PassOperation();
+    else
+        PassLineReset();
+
+    mState = PS_SEARCH;
+
+    return true;
+}
+
+void SWDParser::PassOperation()
+{
+    const SWDBit& last_bit = mOperation.trailing.Empty() ? mOperation.bits.Back() : mOperation.trailing.last;
+
+    mCheckpoint.resume_sample = last_bit.falling;
+    mCheckpoint.last_rising = last_bit.rising;
+    mCheckpoint.select_register = mSelectRegister;
+
+    U64 fingerprint = 0;
+    for( size_t ndx = 0; ndx < mOperation.bits.Size(); ++ndx )
+        fingerprint = SWDParserCheckpoint::AddToFingerprint( fingerprint, mOperation.bits[ ndx ] );
+
+    mCheckpoint.first_rising = mOperation.bits.Front().rising;
+    mCheckpoint.num_fingerprint_bits = U32( mOperation.bits.Size() );
+    mCheckpoint.fingerprint = fingerprint;
+
+    mListener->OnOperation( mOperation );
+}
+
+void SWDParser::PassLineReset()
+{
+    mCheckpoint.resume_sample = mLineReset.bits.last.falling;
+    mCheckpoint.last_rising = mLineReset.bits.last.rising;
+    mCheckpoint.select_register = mSelectRegister;
+
+    mCheckpoint.first_rising = mLineReset.bits.first.rising;
+    mCheckpoint.num_fingerprint_bits = 1;
+    mCheckpoint.fingerprint = SWDParserCheckpoint::AddToFingerprint( 0, mLineReset.bits.first );
+
+    mListener->OnLineReset( mLineReset );
+}
+
+size_t SWDParser::ExtendRun( const SWDBit* bits, size_t num_bits )
+{
+    SWDBitRun& run = GetRun();
+
+    size_t ndx = 0;
+    while( ndx < num_bits && bits[ ndx ].state_rising == run.level )
+        ++ndx;
+
+    // only the ends of the run are stored
+    if( ndx > 0 )
+    {
+        if( run.Empty() )
+            run.first = bits[ 0 ];
+
+        run.last = bits[ ndx - 1 ];
+        run.count += ndx;
+    }
+
+    return ndx;
+}
+
+SWDParser::ParseResult SWDParser::IsOperation( SWDOperation& tran )
+{
+    SWD_TRACE_SPAN( "IsOperation" );
+
+    ++mStats.operation_attempts;
+
+    tran.Clear();
+
+    if( mBitsBuffer.Size() < REQUEST_LENGTH )
+        return PR_NEED_MORE_BITS;
+
+    // turn the bits into a byte
+    tran.request_byte = U8( mBitsBuffer.GetRisingLevels( 0 ) & 0xff );
+
+    // are the request's constant bits (start, stop & park) or the parity wrong?
+    const SWDRequestInfo& info = GetRequestInfo( tran.request_byte );
+    if( !info.valid )
+    {
+        ++mStats.invalid_requests;
+        return PR_NO_MATCH;
+    }
+
+    if( mBitsBuffer.Size() < TRAN_REQ_AND_ACK )
+        return PR_NEED_MORE_BITS;
+
+    // get the indivitual bits
+    tran.APnDP = info.APnDP;
+    tran.RnW = info.RnW;
+    tran.addr = info.addr;
+    tran.parity_read = info.parity_read;
+
+    // Set the actual register in this operation based on the data from the request
+    // and the previous select register state.
+    tran.SetRegister( mSelectRegister );
+
+    // get the ACK value
+    tran.ACK = ( mBitsBuffer[ 9 ].state_rising == BIT_HIGH ? 1 : 0 ) + ( mBitsBuffer[ 10 ].state_rising == BIT_HIGH ? 2 : 0 ) +
+               ( mBitsBuffer[ 11 ].state_rising == BIT_HIGH ? 4 : 0 );
+
+    // we're only handling OK, WAIT and FAULT responses
+    if( tran.ACK == ACK_WAIT || tran.ACK == ACK_FAULT )
+    {
+        ++mStats.acks[ tran.ACK ];
+        ++mStats.operations;
+
+        // give this operation's bits to the tran object
+        tran.bits = mBitsBuffer.View( 0, TRAN_REQ_AND_ACK );
+
+        // consume this operation's bits
+        mBitsBuffer.Consume( TRAN_REQ_AND_ACK );
+
+        return PR_MATCH;
+    }
+
+    if( tran.ACK != ACK_OK )
+    {
+        ++mStats.acks[ tran.ACK ];
+        return PR_NO_MATCH;
+    }
+
+    const size_t tran_length = size_t( tran.IsRead() ? TRAN_READ_LENGTH : TRAN_WRITE_LENGTH );
+    if( mBitsBuffer.Size() < tran_length )
+        return PR_NEED_MORE_BITS;
+
+    // counted once the data is there, so the attempts waiting for it aren't
+    ++mStats.acks[ ACK_OK ];
+
+    // turnaround if write operation
+    bool read_rising = true;
+    size_t bi = 12;
+    if( !tran.IsRead() )
+    {
+        ++bi;
+        // !!! read_rising = false;
+    }
+
+    // read the data and the parity
+    SWDDataPhase data_phase = DecodeDataPhase( read_rising ? mBitsBuffer.GetRisingLevels( bi ) : mBitsBuffer.GetFallingLevels( bi ) );
+
+    tran.data = data_phase.data;
+    tran.data_parity = data_phase.data_parity;
+    tran.data_parity_ok = data_phase.data_parity_ok;
+
+    if( !tran.data_parity_ok )
+    {
+        ++mStats.data_parity_errors;
+        return PR_NO_MATCH;
+    }
+
+    ++mStats.operations;
+
+    // if this is a SELECT register write, remember the value
+    if( tran.reg == SWDR_DP_SELECT && !tran.RnW )
+        mSelectRegister = tran.data;
+
+    // give this operation's bits to the tran object and remove them from the buffer,
+    // the idle bits that follow are counted by StepRun
+    tran.bits = mBitsBuffer.View( 0, tran_length );
+    mBitsBuffer.Consume( tran_length );
+
+    return PR_MATCH;
+}
+
+SWDParser::ParseResult SWDParser::IsLineReset()
+{
+    SWD_TRACE_SPAN( "IsLineReset" );
+
+    // we need at least 50 bits with a value of 1
+    const size_t num_bits = std::min( mBitsBuffer.Size(), size_t( SWDBitScanner::LINE_RESET_BITS ) );
+
+    // we can't have a low bit
+    if( ( ~mBitsBuffer.GetRisingLevels( 0 ) & ( ( 1ULL << num_bits ) - 1 ) ) != 0 )
+        return PR_NO_MATCH;
+
+    return num_bits < SWDBitScanner::LINE_RESET_BITS ? PR_NEED_MORE_BITS : PR_MATCH;
+}
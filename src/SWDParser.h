@@ -0,0 +1,182 @@
+#ifndef SWD_PARSER_H
+#define SWD_PARSER_H
+
+#include <LogicPublicTypes.h>
+
+#include "SWDBitBuffer.h"
+#include "SWDTypes.h"
+
+// Receives what SWDParser decodes from the stream, in stream order.
+// The objects passed are only valid during the call.
+class SWDParserListener
+{
+  public:
+    virtual ~SWDParserListener()
+    {
+    }
+
+    virtual void OnOperation( SWDOperation& tran ) = 0;
+    virtual void OnLineReset( SWDLineReset& reset ) = 0;
+
+    // bits which are neither part of an operation nor of a line reset
+    virtual void OnDroppedBits( const SWDBitRun& bits ) = 0;
+};
+
+// What SWDParser has done since it was cleared.
+// The counters are cheap enough to be always on.
+struct SWDParserStats
+{
+    U64 bits_fed;
+
+    // the bits passed to OnDroppedBits, which are part of nothing
+    U64 bits_dropped;
+
+    // the operation attempts, including the ones that needed more bits,
+    // and the operations found
+    U64 operation_attempts;
+    U64 operations;
+
+    // the time spent in the operation attempts, only counted when timing them
+    U64 operation_attempt_ns;
+
+    // the attempts rejected for the start, stop, park or parity bits of the request,
+    // and the OK operations rejected for their data parity
+    U64 invalid_requests;
+    U64 data_parity_errors;
+
+    // the attempts that got as far as the ACK, by its value
+    U64 acks[ 8 ];
+
+    U64 line_resets;
+
+    // the bits buffered when Feed returned, and the most there ever were
+    size_t buffered_bits;
+    size_t peak_buffered_bits;
+};
+
+// Where SWDParser can carry on decoding after an operation or a line reset.
+// At these boundaries nothing of the stream before them matters to the decode
+// but the DP SELECT value, and the bits buffered past the boundary can be
+// sampled again from the SWCLK falling edge the next bit starts at, so that's
+// all a checkpoint holds.
+struct SWDParserCheckpoint
+{
+    // the falling SWCLK edge of the boundary's last bit, where the next bit starts
+    S64 resume_sample;
+
+    // the rising SWCLK edge of that bit, 1 sample before the actual like SWDBit::rising
+    S64 last_rising;
+
+    // The rising edge of the first bit of the operation, or of the line reset,
+    // and a hash of the SWCLK edges and the SWDIO levels of the bits from there,
+    // which tell together with the last bit that a capture is the one decoded.
+    // A line reset only has its first bit in the hash.
+    S64 first_rising;
+    U32 num_fingerprint_bits;
+    U64 fingerprint;
+
+    U32 select_register;
+
+    // the fingerprint with one more bit in it, which starts at 0
+    static U64 AddToFingerprint( U64 fingerprint, const SWDBit& bit );
+};
+
+// This object parses and buffers the bits of the SWD stream.
+// The bits are pushed in with Feed, in blocks of any size, and whatever they
+// complete is passed to the listener before Feed returns. All the state of the
+// decode lives in this object, so decoding can stop after any bit and carry on
+// with the next call to Feed.
+class SWDParser
+{
+  public:
+    SWDParser();
+
+    void Setup( SWDParserListener* pListener );
+
+    // starts over with a new stream
+    void Clear();
+
+    // starts over with the stream following the checkpoint
+    void Resume( const SWDParserCheckpoint& checkpoint );
+
+    void Feed( const SWDBit* bits, size_t num_bits );
+
+    // Passes on the operation or line reset that is still waiting for the end
+    // of its idle bits, and drops the bits left. Call this at the end of the stream.
+    void Flush();
+
+    const SWDParserStats& GetStats() const
+    {
+        return mStats;
+    }
+
+    // The checkpoint after the operation or line reset the listener was last
+    // given, which is up to date during OnOperation and OnLineReset.
+    const SWDParserCheckpoint& GetCheckpoint() const
+    {
+        return mCheckpoint;
+    }
+
+    // Times each operation attempt, which costs more than the attempts
+    // themselves, so the rest of the decode is slower while this is on.
+    void SetTimeAttempts( bool time_attempts )
+    {
+        mTimeAttempts = time_attempts;
+    }
+
+  private:
+    enum ParseResult
+    {
+        PR_NO_MATCH,
+        PR_MATCH,
+        PR_NEED_MORE_BITS,
+    };
+
+    enum ParserState
+    {
+        PS_SEARCH,         // looking for an operation or a line reset at the front bit
+        PS_DROPPING,       // dropping bits until the next possible operation or line reset
+        PS_OPERATION_IDLE, // counting the idle bits after an operation
+        PS_LINE_RESET,     // counting the high bits of a line reset
+    };
+
+    // decode steps on the buffered bits, which return false if they need more bits
+    bool Step();
+    bool StepSearch();
+    bool StepDropping();
+    bool StepRun();
+
+    // adds the bits from the front of bits that continue the run, returns their number
+    size_t ExtendRun( const SWDBit* bits, size_t num_bits );
+
+    ParseResult IsOperation( SWDOperation& tran );
+    ParseResult IsLineReset();
+
+    // pass on the operation or the line reset, with their checkpoint
+    void PassOperation();
+    void PassLineReset();
+
+    SWDBitRun& GetRun()
+    {
+        return mState == PS_OPERATION_IDLE ? mOperation.trailing : mLineReset.bits;
+    }
+
+    SWDParserListener* mListener;
+
+    SWDBitBuffer mBitsBuffer;
+    U32 mSelectRegister;
+
+    ParserState mState;
+
+    // the operation or line reset being counted, and the bits being dropped
+    SWDOperation mOperation;
+    SWDLineReset mLineReset;
+    SWDBitRun mDropped;
+
+    SWDParserCheckpoint mCheckpoint;
+
+    SWDParserStats mStats;
+    bool mTimeAttempts;
+};
+
+#endif // SWD_PARSER_H
@@ -0,0 +1,311 @@
+#include "SWDReferenceParser.h"
+
+#include "SWDTypes.h"
+
+// the register of the operation, spelled out instead of looked up in tables
+static SWDRegisters GetReferenceRegister( bool APnDP, bool RnW, U8 addr, U32 select_reg )
+{
+    if( APnDP ) // AccessPort or DebugPort?
+    {
+        U8 apbanksel = U8( select_reg & 0xf0 );
+        U8 apreg = apbanksel | addr;
+
+        switch( apreg )
+        {
+        case 0x00:
+            return SWDR_AP_CSW;
+        case 0x04:
+            return SWDR_AP_TAR;
+        case 0x0C:
+            return SWDR_AP_DRW;
+        case 0x10:
+            return SWDR_AP_BD0;
+        case 0x14:
+            return SWDR_AP_BD1;
+        case 0x18:
+            return SWDR_AP_BD2;
+        case 0x1C:
+            return SWDR_AP_BD3;
+        case 0xF4:
+            return SWDR_AP_CFG;
+        case 0xF8:
+            return SWDR_AP_BASE;
+        case 0xFC:
+            return SWDR_AP_IDR;
+        default:
+            return SWDR_AP_RAZ_WI;
+        }
+    }
+
+    switch( addr )
+    {
+    case 0x0:
+        return RnW ? SWDR_DP_IDCODE : SWDR_DP_ABORT;
+    case 0x4:
+        return ( select_reg & 1 ) != 0 ? SWDR_DP_WCR : SWDR_DP_CTRL_STAT;
+    case 0x8:
+        return RnW ? SWDR_DP_RESEND : SWDR_DP_SELECT;
+    default:
+        return RnW ? SWDR_DP_RDBUFF : SWDR_DP_ROUTESEL;
+    }
+}
+
+// ********************************************************************************
+
+SWDReferenceParser::SWDReferenceParser() : mBits( 0 ), mNumBits( 0 ), mNextBit( 0 ), mSelectRegister( 0 ), mOutOfBits( false )
+{
+}
+
+void SWDReferenceParser::Decode( const SWDBit* bits, size_t num_bits, SWDDecodeEventSource& events )
+{
+    mBits = bits;
+    mNumBits = num_bits;
+    mNextBit = 0;
+
+    mBitsBuffer.clear();
+    mSelectRegister = 0;
+    mOutOfBits = false;
+
+    SWDDecodeEvent event;
+    for( ;; )
+    {
+        if( IsOperation( event ) )
+            events.AddEvent( event );
+        else if( !mOutOfBits && IsLineReset( event ) )
+            events.AddEvent( event );
+        else if( mOutOfBits )
+            break;
+        else
+        {
+            // This is neither a valid transaction nor a valid reset,
+            // so remove the first bit and try again.
+            SWDBit bit = PopFrontBit();
+
+            SWDDecodeEvent dropped = SWDDecodeEvent();
+            dropped.type = SWDDecodeEvent::DE_DROPPED;
+            dropped.num_bits = 1;
+            dropped.start_sample = bit.GetStartSample();
+            dropped.end_sample = bit.GetEndSample();
+            events.AddEvent( dropped );
+        }
+    }
+
+    // whatever is left is too short to be anything
+    if( !mBitsBuffer.empty() )
+    {
+        SWDDecodeEvent dropped = SWDDecodeEvent();
+        dropped.type = SWDDecodeEvent::DE_DROPPED;
+        dropped.num_bits = mBitsBuffer.size();
+        dropped.start_sample = mBitsBuffer.front().GetStartSample();
+        dropped.end_sample = mBitsBuffer.back().GetEndSample();
+        events.AddEvent( dropped );
+
+        mBitsBuffer.clear();
+    }
+
+    events.Finish();
+}
+
+bool SWDReferenceParser::ParseBit( SWDBit& bit )
+{
+    if( mNextBit == mNumBits )
+        return false;
+
+    bit = mBits[ mNextBit++ ];
+    return true;
+}
+
+bool SWDReferenceParser::BufferBits( size_t num_bits )
+{
+    SWDBit bit;
+    while( mBitsBuffer.size() < num_bits )
+    {
+        if( !ParseBit( bit ) )
+        {
+            mOutOfBits = true;
+            return false;
+        }
+
+        mBitsBuffer.push_back( bit );
+    }
+
+    return true;
+}
+
+SWDBit SWDReferenceParser::PopFrontBit()
+{
+    SWDBit ret_val( mBitsBuffer.front() );
+    mBitsBuffer.erase( mBitsBuffer.begin() );
+
+    return ret_val;
+}
+
+bool SWDReferenceParser::IsOperation( SWDDecodeEvent& tran )
+{
+    tran = SWDDecodeEvent();
+    tran.type = SWDDecodeEvent::DE_OPERATION;
+
+    // read enough bits so that we don't have to worry of subscripts out of range
+    if( !BufferBits( TRAN_REQ_AND_ACK ) )
+        return false;
+
+    // turn the bits into a byte
+    for( size_t cnt = 0; cnt < 8; ++cnt )
+    {
+        tran.request_byte >>= 1;
+        tran.request_byte |= ( mBitsBuffer[ cnt ].IsHigh() ? 0x80 : 0 );
+    }
+
+    // are the request's constant bits (start, stop & park) wrong?
+    if( ( tran.request_byte & 0xC1 ) != 0x81 )
+        return false;
+
+    // get the indivitual bits
+    const bool APnDP = ( tran.request_byte & 0x02 ) != 0;
+    const bool RnW = ( tran.request_byte & 0x04 ) != 0;
+    const U8 addr = ( tran.request_byte & 0x18 ) >> 1;
+    const U8 parity_read = ( tran.request_byte & 0x20 ) != 0 ? 1 : 0;
+
+    // check parity
+    int check = ( mBitsBuffer[ 1 ].IsHigh() ? 1 : 0 ) + ( mBitsBuffer[ 2 ].IsHigh() ? 1 : 0 ) + ( mBitsBuffer[ 3 ].IsHigh() ? 1 : 0 ) +
+                ( mBitsBuffer[ 4 ].IsHigh() ? 1 : 0 );
+
+    if( parity_read != ( check & 1 ) )
+        return false;
+
+    tran.reg = GetReferenceRegister( APnDP, RnW, addr, mSelectRegister );
+
+    // get the ACK value
+    tran.ACK = ( mBitsBuffer[ 9 ].IsHigh() ? 1 : 0 ) + ( mBitsBuffer[ 10 ].IsHigh() ? 2 : 0 ) + ( mBitsBuffer[ 11 ].IsHigh() ? 4 : 0 );
+
+    tran.start_sample = mBitsBuffer[ 0 ].GetStartSample();
+
+    // we're only handling OK, WAIT and FAULT responses
+    if( tran.ACK == ACK_WAIT || tran.ACK == ACK_FAULT )
+    {
+        tran.num_bits = TRAN_REQ_AND_ACK;
+        tran.end_sample = mBitsBuffer[ TRAN_REQ_AND_ACK - 1 ].GetEndSample();
+
+        // consume this operation's bits
+        mBitsBuffer.erase( mBitsBuffer.begin(), mBitsBuffer.begin() + TRAN_REQ_AND_ACK );
+
+        return true;
+    }
+
+    if( tran.ACK != ACK_OK )
+        return false;
+
+    // turnaround if write operation
+    size_t bi = 12;
+    if( !BufferBits( TRAN_READ_LENGTH ) )
+        return false;
+
+    if( !RnW )
+    {
+        if( !BufferBits( TRAN_WRITE_LENGTH ) )
+            return false;
+
+        ++bi;
+    }
+
+    // read the data
+    check = 0;
+    size_t ndx;
+    for( ndx = 0; ndx < 32; ndx++ )
+    {
+        tran.data >>= 1;
+
+        if( mBitsBuffer[ bi + ndx ].IsHigh() )
+        {
+            tran.data |= 0x80000000;
+            ++check;
+        }
+    }
+
+    // data parity
+    tran.data_parity = mBitsBuffer[ bi + ndx ].IsHigh() ? 1 : 0;
+
+    if( tran.data_parity != ( check & 1 ) )
+        return false;
+
+    // if this is a SELECT register write, remember the value
+    if( tran.reg == SWDR_DP_SELECT && !RnW )
+        mSelectRegister = tran.data;
+
+    // buffered trailing zeros
+    ndx += bi + 1;
+    while( ndx < mBitsBuffer.size() && !mBitsBuffer[ ndx ].IsHigh() )
+        ++ndx;
+
+    if( ndx < mBitsBuffer.size() )
+    {
+        tran.num_bits = ndx;
+        tran.end_sample = mBitsBuffer[ ndx - 1 ].GetEndSample();
+
+        // remove this operation's bits from the buffer
+        mBitsBuffer.erase( mBitsBuffer.begin(), mBitsBuffer.begin() + ndx );
+
+        return true;
+    }
+
+    // we haven't seen a high bit, so carry on until we do, or the stream ends;
+    // the zero bits are only counted
+    tran.num_bits = mBitsBuffer.size();
+    tran.end_sample = mBitsBuffer.back().GetEndSample();
+    mBitsBuffer.clear();
+
+    SWDBit bit;
+    while( ParseBit( bit ) )
+    {
+        // keep the high bit because that one is probably next operation's start bit
+        if( bit.IsHigh() )
+        {
+            mBitsBuffer.push_back( bit );
+            break;
+        }
+
+        ++tran.num_bits;
+        tran.end_sample = bit.GetEndSample();
+    }
+
+    return true;
+}
+
+bool SWDReferenceParser::IsLineReset( SWDDecodeEvent& reset )
+{
+    reset = SWDDecodeEvent();
+    reset.type = SWDDecodeEvent::DE_LINE_RESET;
+
+    // we need at least 50 bits with a value of 1
+    for( size_t cnt = 0; cnt < 50; cnt++ )
+    {
+        if( !BufferBits( cnt + 1 ) )
+            return false;
+
+        // we can't have a low bit
+        if( !mBitsBuffer[ cnt ].IsHigh() )
+            return false;
+    }
+
+    // the high bits are only counted
+    reset.num_bits = mBitsBuffer.size();
+    reset.start_sample = mBitsBuffer.front().GetStartSample();
+    reset.end_sample = mBitsBuffer.back().GetEndSample();
+    mBitsBuffer.clear();
+
+    SWDBit bit;
+    while( ParseBit( bit ) )
+    {
+        // keep the low bit because that one is probably next operation's start bit
+        if( !bit.IsHigh() )
+        {
+            mBitsBuffer.push_back( bit );
+            break;
+        }
+
+        ++reset.num_bits;
+        reset.end_sample = bit.GetEndSample();
+    }
+
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef SWD_REFERENCE_PARSER_H
+#define SWD_REFERENCE_PARSER_H
+
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDBitBuffer.h"
+#include "SWDDecodeEvents.h"
+
+// The decoder the way it was before SWDParser was made fast: it looks for an
+// operation or a line reset at the front bit, pulling in bits one at a time as
+// it needs them, and drops that one bit if there's neither. It's slow, but
+// simple enough to be obviously right, which makes it what swd_diff checks
+// SWDParser and SWDChunkedDecoder against. Don't optimize it.
+// The original waited for more bits forever at the end of a capture. This one
+// does what SWDParser::Flush does instead: the idle bits of an operation and
+// the high bits of a line reset end with the stream, and the bits of whatever
+// needed more bits than there are are dropped.
+class SWDReferenceParser
+{
+  public:
+    SWDReferenceParser();
+
+    // decodes the whole stream into events
+    void Decode( const SWDBit* bits, size_t num_bits, SWDDecodeEventSource& events );
+
+  private:
+    // returns false at the end of the stream
+    bool ParseBit( SWDBit& bit );
+
+    // returns false and sets mOutOfBits if the stream ends first
+    bool BufferBits( size_t num_bits );
+
+    SWDBit PopFrontBit();
+
+    bool IsOperation( SWDDecodeEvent& tran );
+    bool IsLineReset( SWDDecodeEvent& reset );
+
+    const SWDBit* mBits;
+    size_t mNumBits;
+    size_t mNextBit;
+
+    std::vector<SWDBit> mBitsBuffer;
+    U32 mSelectRegister;
+
+    // the front bit needed more bits than the stream has
+    bool mOutOfBits;
+};
+
+#endif // SWD_REFERENCE_PARSER_H
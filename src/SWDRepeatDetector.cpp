@@ -0,0 +1,223 @@
+#include <algorithm>
+
+#include "SWDRepeatDetector.h"
+
+void SWDRepeatKey::SetOperation( SWDOperation& tran )
+{
+    request_byte = tran.request_byte;
+    ACK = tran.ACK;
+    reg = tran.reg;
+    data = tran.bits.Size() >= TRAN_READ_LENGTH ? tran.data : 0;
+    count = 1;
+}
+
+void SWDRepeatKey::SetRetries( const SWDRetryBurst& retries )
+{
+    request_byte = retries.request_byte;
+    ACK = retries.ACK;
+    reg = retries.reg;
+    data = 0;
+    count = retries.count;
+}
+
+void SWDHeldResults::Swap( SWDHeldResults& other )
+{
+    std::swap( key, other.key );
+    std::swap( start_sample, other.start_sample );
+    std::swap( end_sample, other.end_sample );
+    std::swap( checkpoint, other.checkpoint );
+
+    frames.swap( other.frames );
+    markers.swap( other.markers );
+}
+
+// ********************************************************************************
+
+SWDRepeatDetector::SWDRepeatDetector() : mListener( 0 ), mPool( MAX_PERIOD + 1 ), mSingleCopy( 0 )
+{
+    for( size_t ndx = 0; ndx < mPool.size(); ++ndx )
+        mSpare.push_back( &mPool[ ndx ] );
+
+    mRepeat = SWDRepeat();
+}
+
+void SWDRepeatDetector::Setup( SWDRepeatDetectorListener* pListener )
+{
+    mListener = pListener;
+}
+
+void SWDRepeatDetector::Clear()
+{
+    while( !mHeld.empty() )
+    {
+        mHeld.front()->Clear();
+        mSpare.push_back( mHeld.front() );
+        mHeld.pop_front();
+    }
+
+    if( mSingleCopy != 0 )
+        Release( mSingleCopy );
+
+    mHistory.clear();
+    mRepeat.count = 0;
+}
+
+void SWDRepeatDetector::Resume( const std::deque<SWDRepeatKey>& history )
+{
+    Clear();
+    mHistory = history;
+}
+
+void SWDRepeatDetector::Add( SWDHeldResults& results )
+{
+    SWDHeldResults* held = mSpare.back();
+    mSpare.pop_back();
+
+    held->Swap( results );
+    Hold( held );
+}
+
+void SWDRepeatDetector::Hold( SWDHeldResults* held )
+{
+    mHeld.push_back( held );
+
+    if( mRepeat.count != 0 )
+    {
+        // does it carry on the next copy of the sequence?
+        if( held->key == mHistory[ mHistory.size() - mRepeat.period + mHeld.size() - 1 ] )
+        {
+            if( mHeld.size() == mRepeat.period )
+                CollapseHeld();
+
+            return;
+        }
+
+        EndRepeat();
+    }
+
+    Search();
+}
+
+void SWDRepeatDetector::Flush()
+{
+    EndRepeat();
+
+    while( !mHeld.empty() )
+        PassOnFront();
+}
+
+bool SWDRepeatDetector::IsHeldCopy( size_t period ) const
+{
+    const size_t first = mHistory.size() - period;
+    for( size_t ndx = 0; ndx < mHeld.size(); ++ndx )
+    {
+        if( !( mHeld[ ndx ]->key == mHistory[ first + ndx ] ) )
+            return false;
+    }
+
+    return true;
+}
+
+void SWDRepeatDetector::Search()
+{
+    // the shortest sequence the held results can still be a copy of
+    size_t period = mHeld.size();
+    while( period <= mHistory.size() && !IsHeldCopy( period ) )
+        ++period;
+
+    if( period <= mHistory.size() )
+    {
+        // a whole copy starts a repeat, the start of a longer one waits for the rest
+        if( period == mHeld.size() )
+            CollapseHeld();
+
+        return;
+    }
+
+    // The first one isn't part of a copy, but the ones after it can still
+    // be, even of a shorter sequence, so look at them again one at a time.
+    PassOnFront();
+
+    std::deque<SWDHeldResults*> rest;
+    rest.swap( mHeld );
+
+    for( size_t ndx = 0; ndx < rest.size(); ++ndx )
+        Hold( rest[ ndx ] );
+}
+
+void SWDRepeatDetector::CollapseHeld()
+{
+    if( mRepeat.count == 0 )
+    {
+        mRepeat.start_sample = mHeld.front()->start_sample;
+        mRepeat.period = mHeld.size();
+    }
+
+    ++mRepeat.count;
+    mRepeat.end_sample = mHeld.back()->end_sample;
+    mRepeat.checkpoint = mHeld.back()->checkpoint;
+
+    // the first copy isn't passed on by itself once there's a second one
+    if( mSingleCopy != 0 )
+        Release( mSingleCopy );
+
+    while( !mHeld.empty() )
+    {
+        SWDHeldResults* held = mHeld.front();
+        mHeld.pop_front();
+
+        AddToHistory( held->key );
+
+        // a single copy of a single result isn't worth a repeat, so keep it
+        if( mRepeat.period * mRepeat.count < 2 )
+            mSingleCopy = held;
+        else
+            Release( held );
+    }
+}
+
+void SWDRepeatDetector::PassOnFront()
+{
+    SWDHeldResults* held = mHeld.front();
+    mHeld.pop_front();
+
+    // the listener can look at the history, and at whether we're holding
+    AddToHistory( held->key );
+    mListener->OnResults( *held );
+
+    Release( held );
+}
+
+void SWDRepeatDetector::EndRepeat()
+{
+    if( mRepeat.count == 0 )
+        return;
+
+    // it's over before the listener looks at whether we're holding
+    const SWDRepeat repeat = mRepeat;
+    mRepeat.count = 0;
+
+    if( mSingleCopy != 0 )
+    {
+        mListener->OnResults( *mSingleCopy );
+        Release( mSingleCopy );
+    }
+    else
+    {
+        mListener->OnRepeat( repeat );
+    }
+}
+
+void SWDRepeatDetector::Release( SWDHeldResults*& held )
+{
+    held->Clear();
+    mSpare.push_back( held );
+    held = 0;
+}
+
+void SWDRepeatDetector::AddToHistory( const SWDRepeatKey& key )
+{
+    mHistory.push_back( key );
+    if( mHistory.size() > MAX_PERIOD )
+        mHistory.pop_front();
+}
@@ -0,0 +1,184 @@
+#ifndef SWD_REPEAT_DETECTOR_H
+#define SWD_REPEAT_DETECTOR_H
+
+#include <deque>
+#include <vector>
+
+#include <AnalyzerResults.h>
+#include <LogicPublicTypes.h>
+
+#include "SWDParser.h"
+#include "SWDTypes.h"
+
+// what makes two operations, or two bursts of retries, the same
+struct SWDRepeatKey
+{
+    U8 request_byte;
+    U8 ACK;
+    SWDRegisters reg;
+
+    // 0 without a data phase
+    U32 data;
+
+    // the operations of a burst of retries, 1 otherwise
+    U64 count;
+
+    void SetOperation( SWDOperation& tran );
+    void SetRetries( const SWDRetryBurst& retries );
+
+    bool operator==( const SWDRepeatKey& other ) const
+    {
+        return request_byte == other.request_byte && ACK == other.ACK && reg == other.reg && data == other.data && count == other.count;
+    }
+};
+
+// The frames and markers of an operation or of a burst of retries, kept back
+// until the analyzer knows whether they're shown or collapsed into a repeat.
+struct SWDHeldResults : public SWDResultsOutput
+{
+    struct Marker
+    {
+        U64 sample_number;
+        AnalyzerResults::MarkerType marker_type;
+    };
+
+    SWDRepeatKey key;
+
+    S64 start_sample;
+    S64 end_sample;
+
+    // where the parser can carry on after them
+    SWDParserCheckpoint checkpoint;
+
+    std::vector<Frame> frames;
+    std::vector<Marker> markers;
+
+    void Clear()
+    {
+        frames.clear();
+        markers.clear();
+    }
+
+    // swaps the contents without copying the frames and markers
+    void Swap( SWDHeldResults& other );
+
+    virtual void AddFrame( const Frame& frame )
+    {
+        frames.push_back( frame );
+    }
+    virtual void AddMarker( U64 sample_number, AnalyzerResults::MarkerType marker_type )
+    {
+        Marker marker = { sample_number, marker_type };
+        markers.push_back( marker );
+    }
+};
+
+// the copies of a sequence that follow its first one, collapsed
+struct SWDRepeat
+{
+    S64 start_sample;
+    S64 end_sample;
+
+    // the operations and bursts of retries in the sequence, and the number of copies
+    U64 period;
+    U64 count;
+
+    // where the parser can carry on after the last copy
+    SWDParserCheckpoint checkpoint;
+};
+
+// Receives what SWDRepeatDetector passes on, in stream order.
+class SWDRepeatDetectorListener
+{
+  public:
+    virtual ~SWDRepeatDetectorListener()
+    {
+    }
+
+    // results which aren't part of a repeat
+    virtual void OnResults( SWDHeldResults& results ) = 0;
+
+    virtual void OnRepeat( const SWDRepeat& repeat ) = 0;
+};
+
+// Finds sequences of operations that repeat right after themselves, like the
+// ones of a poll loop. The first copy of a sequence is passed on as it is, and
+// the copies after it are collapsed into one SWDRepeat, which is passed on
+// once the next results don't continue the sequence. A single copy of a
+// single result is passed on as it is instead.
+// Results are held back while they could be the start of another copy, which
+// is for at most MAX_PERIOD results, and only their keys are kept after that.
+class SWDRepeatDetector
+{
+  public:
+    // the longest sequence looked for
+    enum
+    {
+        MAX_PERIOD = 32,
+    };
+
+    SWDRepeatDetector();
+
+    void Setup( SWDRepeatDetectorListener* pListener );
+
+    // forgets the results seen so far, call it after Flush
+    void Clear();
+
+    // takes the results, leaving them empty
+    void Add( SWDHeldResults& results );
+
+    // passes on the repeat and the results held back
+    void Flush();
+
+    // the keys the results after the ones passed on so far are compared to,
+    // which Resume takes to carry on from there; only whole when not holding
+    const std::deque<SWDRepeatKey>& GetHistory() const
+    {
+        return mHistory;
+    }
+
+    // forgets the results seen so far, and carries on after the ones of the history
+    void Resume( const std::deque<SWDRepeatKey>& history );
+
+    // whether there are results held back or a repeat being collapsed, which
+    // the results after them could still join
+    bool IsHolding() const
+    {
+        return !mHeld.empty() || mRepeat.count != 0;
+    }
+
+  private:
+    // whether the held results are the start of a copy of the last period results before them
+    bool IsHeldCopy( size_t period ) const;
+
+    // holds the results, and collapses or passes on what can be
+    void Hold( SWDHeldResults* held );
+
+    void Search();
+    void CollapseHeld();
+    void PassOnFront();
+    void EndRepeat();
+    void AddToHistory( const SWDRepeatKey& key );
+
+    // clears the results and makes them free to take more, leaving held 0
+    void Release( SWDHeldResults*& held );
+
+    SWDRepeatDetectorListener* mListener;
+
+    // the keys of the results passed on or collapsed, the latest last
+    std::deque<SWDRepeatKey> mHistory;
+
+    // the results held back, and the ones free to take more, all in mPool
+    std::deque<SWDHeldResults*> mHeld;
+    std::vector<SWDHeldResults*> mSpare;
+    std::vector<SWDHeldResults> mPool;
+
+    // the repeat being collapsed, if its count isn't 0
+    SWDRepeat mRepeat;
+
+    // the only copy of a repeat of a single result, which is passed on as it
+    // is unless another copy follows, 0 otherwise
+    SWDHeldResults* mSingleCopy;
+};
+
+#endif // SWD_REPEAT_DETECTOR_H
@@ -0,0 +1,409 @@
+#include <cstdlib>
+#include <sstream>
+
+#include "SWDScenarioGenerator.h"
+
+#include "SWDStreamBuilder.h"
+#include "SWDTypes.h"
+
+// the DP registers, by address
+const U8 DP_IDCODE = 0x0;
+const U8 DP_ABORT = 0x0;
+const U8 DP_CTRL_STAT = 0x4;
+const U8 DP_SELECT = 0x8;
+const U8 DP_RDBUFF = 0xC;
+
+// the AP registers, by offset, of which SELECT holds the bank
+const U8 AP_CSW = 0x00;
+const U8 AP_TAR = 0x04;
+const U8 AP_DRW = 0x0C;
+const U8 AP_BASE = 0xF8;
+const U8 AP_IDR = 0xFC;
+
+// ABORT bits
+const U32 ABORT_DAPABORT = 0x01;
+const U32 ABORT_STKERRCLR = 0x04;
+const U32 ABORT_WDERRCLR = 0x08;
+const U32 ABORT_ORUNERRCLR = 0x10;
+
+// CTRL/STAT with both power domains up, and the sticky error flags
+const U32 CTRL_STAT_POWERED = 0xF0000000;
+const U32 CTRL_STAT_POWER_UP_REQ = 0x50000000;
+const U32 CTRL_STAT_STICKYERR = 0x20;
+const U32 CTRL_STAT_WDATAERR = 0x80;
+
+const char* SCENARIO_NAMES[ SWDScenarioGenerator::NUM_SCENARIOS ] = {
+    "connect", "drw_burst", "multi_ap", "wait_storm", "fault_abort", "parity_error", "glitch",
+};
+
+SWDScenarioGenerator::SWDScenarioGenerator() : mBuilder( 0 ), mMinClockPeriod( 8 ), mMaxClockPeriod( 8 )
+{
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+        mWeights[ ndx ] = 1;
+
+    Setup( 0, 1 );
+}
+
+void SWDScenarioGenerator::Setup( SWDStreamBuilder* pBuilder, U32 seed )
+{
+    mBuilder = pBuilder;
+    mRng.seed( seed );
+
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+        mNumGenerated[ ndx ] = 0;
+
+    mNumOperations = 0;
+    mNumWaits = 0;
+    mNumFaults = 0;
+
+    mSelect = 0;
+    mSelectValid = false;
+}
+
+void SWDScenarioGenerator::SetClockPeriodRange( U32 min_samples, U32 max_samples )
+{
+    mMinClockPeriod = min_samples;
+    mMaxClockPeriod = max_samples < min_samples ? min_samples : max_samples;
+}
+
+const char* SWDScenarioGenerator::GetScenarioName( Scenario scenario )
+{
+    return SCENARIO_NAMES[ scenario ];
+}
+
+bool SWDScenarioGenerator::FindScenario( const std::string& name, Scenario& scenario )
+{
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+    {
+        if( name == SCENARIO_NAMES[ ndx ] )
+        {
+            scenario = Scenario( ndx );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SWDScenarioGenerator::SetWeight( Scenario scenario, U32 weight )
+{
+    mWeights[ scenario ] = weight;
+}
+
+bool SWDScenarioGenerator::SetMix( const std::string& mix )
+{
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+        mWeights[ ndx ] = 0;
+
+    std::istringstream is( mix );
+    std::string item;
+    while( std::getline( is, item, ',' ) )
+    {
+        const size_t eq = item.find( '=' );
+
+        Scenario scenario;
+        if( !FindScenario( item.substr( 0, eq ), scenario ) )
+            return false;
+
+        mWeights[ scenario ] = eq == std::string::npos ? 1 : U32( strtoul( item.c_str() + eq + 1, 0, 10 ) );
+    }
+
+    return true;
+}
+
+bool SWDScenarioGenerator::ParseScript( const std::string& text, std::vector<Scenario>& script )
+{
+    std::istringstream is( text );
+    std::string item;
+    while( std::getline( is, item, ',' ) )
+    {
+        const size_t star = item.find( '*' );
+
+        Scenario scenario;
+        if( !FindScenario( item.substr( 0, star ), scenario ) )
+            return false;
+
+        const U64 count = star == std::string::npos ? 1 : strtoull( item.c_str() + star + 1, 0, 10 );
+        script.insert( script.end(), size_t( count ), scenario );
+    }
+
+    return true;
+}
+
+bool SWDScenarioGenerator::ParseCount( const std::string& text, U64& count )
+{
+    char* end = 0;
+    count = strtoull( text.c_str(), &end, 10 );
+    if( end == text.c_str() )
+        return false;
+
+    const std::string suffix = end;
+    if( suffix == "k" )
+        count *= 1000ULL;
+    else if( suffix == "M" )
+        count *= 1000000ULL;
+    else if( suffix == "G" )
+        count *= 1000000000ULL;
+    else if( !suffix.empty() )
+        return false;
+
+    return true;
+}
+
+U32 SWDScenarioGenerator::Random( U32 num_values )
+{
+    // not a std distribution, whose results differ between standard libraries
+    return num_values <= 1 ? 0 : U32( mRng() % num_values );
+}
+
+SWDScenarioGenerator::Scenario SWDScenarioGenerator::PickScenario()
+{
+    U32 total = 0;
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+        total += mWeights[ ndx ];
+
+    U32 pick = Random( total );
+    for( size_t ndx = 0; ndx < NUM_SCENARIOS; ++ndx )
+    {
+        if( pick < mWeights[ ndx ] )
+            return Scenario( ndx );
+
+        pick -= mWeights[ ndx ];
+    }
+
+    return SCENARIO_DRW_BURST;
+}
+
+void SWDScenarioGenerator::Generate( Scenario scenario )
+{
+    mBuilder->SetClockPeriod( mMinClockPeriod + Random( mMaxClockPeriod - mMinClockPeriod + 1 ) );
+
+    switch( scenario )
+    {
+    case SCENARIO_CONNECT:
+        Connect();
+        break;
+    case SCENARIO_DRW_BURST:
+        DRWBurst();
+        break;
+    case SCENARIO_MULTI_AP:
+        MultiAP();
+        break;
+    case SCENARIO_WAIT_STORM:
+        WaitStorm();
+        break;
+    case SCENARIO_FAULT_ABORT:
+        FaultAbort();
+        break;
+    case SCENARIO_PARITY_ERROR:
+        ParityError();
+        break;
+    case SCENARIO_GLITCH:
+        Glitch();
+        break;
+    default:
+        return;
+    }
+
+    ++mNumGenerated[ scenario ];
+
+    // the host goes quiet for a while, sometimes with SWCLK stopped
+    mBuilder->Idle( 2 + Random( 16 ) );
+    if( Random( 4 ) == 0 )
+        mBuilder->Pause( mBuilder->GetClockPeriod() * ( 1 + Random( 1000 ) ) );
+}
+
+// ********************************************************************************
+
+void SWDScenarioGenerator::Operation( bool APnDP, bool RnW, U8 addr, U8 ack, U32 data, bool data_parity_ok )
+{
+    mBuilder->Operation( APnDP, RnW, addr, ack, data, data_parity_ok );
+    mBuilder->Idle( Random( 3 ) );
+
+    ++mNumOperations;
+    if( ack == ACK_WAIT )
+        ++mNumWaits;
+    else if( ack == ACK_FAULT )
+        ++mNumFaults;
+}
+
+void SWDScenarioGenerator::DPRead( U8 addr, U32 data )
+{
+    Operation( false, true, addr, ACK_OK, data );
+}
+
+void SWDScenarioGenerator::DPWrite( U8 addr, U32 data )
+{
+    Operation( false, false, addr, ACK_OK, data );
+
+    if( addr == DP_SELECT )
+    {
+        mSelect = data;
+        mSelectValid = true;
+    }
+}
+
+void SWDScenarioGenerator::Select( U8 apsel, U8 reg )
+{
+    const U32 select = ( U32( apsel ) << 24 ) | ( reg & 0xF0 );
+    if( !mSelectValid || mSelect != select )
+        DPWrite( DP_SELECT, select );
+}
+
+void SWDScenarioGenerator::APRead( U8 apsel, U8 reg, U32 data )
+{
+    Select( apsel, reg );
+    Operation( true, true, reg & 0x0C, ACK_OK, data );
+}
+
+void SWDScenarioGenerator::APWrite( U8 apsel, U8 reg, U32 data )
+{
+    Select( apsel, reg );
+    Operation( true, false, reg & 0x0C, ACK_OK, data );
+}
+
+// ********************************************************************************
+
+void SWDScenarioGenerator::Connect()
+{
+    // line reset, the JTAG to SWD sequence and another line reset
+    mBuilder->LineReset( 50 + Random( 20 ) );
+    mBuilder->Bits( 0xE79E, 16 );
+    mBuilder->LineReset( 50 + Random( 20 ) );
+    mSelectValid = false;
+
+    DPRead( DP_IDCODE, 0x0BB11477 );
+    DPWrite( DP_ABORT, ABORT_STKERRCLR | ABORT_WDERRCLR | ABORT_ORUNERRCLR );
+    DPWrite( DP_SELECT, 0 );
+    DPWrite( DP_CTRL_STAT, CTRL_STAT_POWER_UP_REQ );
+
+    // polling until the debug and system domains are up
+    const U32 num_polls = Random( 4 );
+    for( U32 ndx = 0; ndx < num_polls; ++ndx )
+        DPRead( DP_CTRL_STAT, CTRL_STAT_POWER_UP_REQ );
+
+    DPRead( DP_CTRL_STAT, CTRL_STAT_POWERED );
+}
+
+void SWDScenarioGenerator::DRWBurst()
+{
+    const U8 apsel = U8( Random( 2 ) );
+    const bool reading = Random( 2 ) == 0;
+
+    APWrite( apsel, AP_CSW, 0x23000012 );
+    APWrite( apsel, AP_TAR, 0x20000000 + ( Random( 0x1000 ) << 2 ) );
+
+    // the AP reads are posted, so the last value is read from RDBUFF
+    const U32 num_words = 1 + Random( 64 );
+    for( U32 ndx = 0; ndx < num_words; ++ndx )
+    {
+        if( reading )
+            APRead( apsel, AP_DRW, U32( mRng() ) );
+        else
+            APWrite( apsel, AP_DRW, U32( mRng() ) );
+    }
+
+    if( reading )
+        DPRead( DP_RDBUFF, U32( mRng() ) );
+}
+
+void SWDScenarioGenerator::MultiAP()
+{
+    const U32 num_aps = 2 + Random( 4 );
+    for( U32 apsel = 0; apsel < num_aps; ++apsel )
+    {
+        APRead( U8( apsel ), AP_IDR, 0x24770011 );
+        APRead( U8( apsel ), AP_BASE, 0xE00FF003 );
+        DPRead( DP_RDBUFF, 0x04770021 );
+    }
+
+    // back to the first AP's CSW
+    APRead( 0, AP_CSW, 0x03000040 );
+    DPRead( DP_RDBUFF, 0x23000052 );
+}
+
+void SWDScenarioGenerator::WaitStorm()
+{
+    const U8 apsel = U8( Random( 2 ) );
+
+    APWrite( apsel, AP_TAR, 0x40000000 + ( Random( 0x100 ) << 2 ) );
+
+    const U32 num_reads = 1 + Random( 8 );
+    for( U32 ndx = 0; ndx < num_reads; ++ndx )
+    {
+        // the target keeps answering WAIT until the slow bus access is done
+        const U32 num_waits = 1 + Random( 100 );
+        for( U32 wndx = 0; wndx < num_waits; ++wndx )
+            Operation( true, true, AP_DRW, ACK_WAIT, 0 );
+
+        // sometimes the host gives up and aborts the access
+        if( Random( 8 ) == 0 )
+        {
+            DPWrite( DP_ABORT, ABORT_DAPABORT );
+            return;
+        }
+
+        Operation( true, true, AP_DRW, ACK_OK, U32( mRng() ) );
+    }
+
+    DPRead( DP_RDBUFF, U32( mRng() ) );
+}
+
+void SWDScenarioGenerator::FaultAbort()
+{
+    const U8 apsel = U8( Random( 2 ) );
+
+    // the write fails on the bus, which only shows on the next AP access
+    APWrite( apsel, AP_TAR, 0xE0000000 + ( Random( 0x100 ) << 2 ) );
+    APWrite( apsel, AP_DRW, U32( mRng() ) );
+
+    const U32 num_faults = 1 + Random( 3 );
+    for( U32 ndx = 0; ndx < num_faults; ++ndx )
+        Operation( true, true, AP_DRW, ACK_FAULT, 0 );
+
+    // DP accesses still get OK, so the host finds out why and clears the error
+    DPRead( DP_CTRL_STAT, CTRL_STAT_POWERED | CTRL_STAT_STICKYERR );
+    DPWrite( DP_ABORT, ABORT_STKERRCLR );
+    DPRead( DP_CTRL_STAT, CTRL_STAT_POWERED );
+}
+
+void SWDScenarioGenerator::ParityError()
+{
+    const U8 apsel = U8( Random( 2 ) );
+
+    if( Random( 2 ) == 0 )
+    {
+        // the read data comes with the wrong parity, so the host reads it again from RDBUFF
+        const U32 data = U32( mRng() );
+        Select( apsel, AP_DRW );
+        Operation( true, true, AP_DRW, ACK_OK, data, false );
+        DPRead( DP_RDBUFF, data );
+    }
+    else
+    {
+        // the target rejects the next access after write data with the wrong parity
+        Select( apsel, AP_DRW );
+        Operation( true, false, AP_DRW, ACK_OK, U32( mRng() ), false );
+        Operation( true, false, AP_DRW, ACK_FAULT, 0 );
+
+        DPRead( DP_CTRL_STAT, CTRL_STAT_POWERED | CTRL_STAT_WDATAERR );
+        DPWrite( DP_ABORT, ABORT_WDERRCLR );
+        APWrite( apsel, AP_DRW, U32( mRng() ) );
+    }
+}
+
+void SWDScenarioGenerator::Glitch()
+{
+    const U8 apsel = U8( Random( 2 ) );
+
+    APWrite( apsel, AP_DRW, U32( mRng() ) );
+
+    // a glitch somewhere in the next operation, after which the host resyncs with a line reset
+    mBuilder->Glitch( Random( 2 ) == 0, 1 + Random( 2 ), Random( TRAN_WRITE_LENGTH ) );
+    APWrite( apsel, AP_DRW, U32( mRng() ) );
+
+    mBuilder->LineReset();
+    mSelectValid = false;
+
+    DPRead( DP_IDCODE, 0x0BB11477 );
+}
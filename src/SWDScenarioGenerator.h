@@ -0,0 +1,119 @@
+#ifndef SWD_SCENARIO_GENERATOR_H
+#define SWD_SCENARIO_GENERATOR_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+class SWDStreamBuilder;
+
+// Builds SWD traffic out of scenarios, the typical conversations between a
+// debugger and a target, each with its own mix of operations and errors.
+// Everything is drawn from a generator seeded by Setup, so the same seed,
+// settings and sequence of calls give the same stream.
+class SWDScenarioGenerator
+{
+  public:
+    enum Scenario
+    {
+        SCENARIO_CONNECT,      // line reset, JTAG to SWD, IDCODE and powering up the debug domain
+        SCENARIO_DRW_BURST,    // memory reads or writes through CSW, TAR and DRW
+        SCENARIO_MULTI_AP,     // reading the ID registers of several APs, with the SELECT writes
+        SCENARIO_WAIT_STORM,   // DRW reads the target answers WAIT to, over and over
+        SCENARIO_FAULT_ABORT,  // a FAULT, the CTRL/STAT read and the ABORT write clearing it
+        SCENARIO_PARITY_ERROR, // wrong data parity on a read or a write, and the recovery
+        SCENARIO_GLITCH,       // a glitch on SWCLK or SWDIO in the middle of an operation
+
+        NUM_SCENARIOS
+    };
+
+    SWDScenarioGenerator();
+
+    void Setup( SWDStreamBuilder* pBuilder, U32 seed );
+
+    // each scenario runs at a SWCLK period picked from this range, in samples
+    void SetClockPeriodRange( U32 min_samples, U32 max_samples );
+
+    static const char* GetScenarioName( Scenario scenario );
+
+    // returns false if there's no scenario by that name
+    static bool FindScenario( const std::string& name, Scenario& scenario );
+
+    // how often PickScenario picks the scenario relative to the others, all 1 by default
+    void SetWeight( Scenario scenario, U32 weight );
+
+    // Sets the weights from name=weight,..., where the scenarios not named aren't
+    // picked and a name alone has weight 1. Returns false on an unknown scenario.
+    bool SetMix( const std::string& mix );
+
+    // appends the scenarios of name[*count],... to script, returns false on an unknown scenario
+    static bool ParseScript( const std::string& text, std::vector<Scenario>& script );
+
+    // a number with an optional k, M or G suffix, returns false if it's not one
+    static bool ParseCount( const std::string& text, U64& count );
+
+    Scenario PickScenario();
+
+    // adds the scenario to the stream, with some idle time after it
+    void Generate( Scenario scenario );
+
+    U64 GetNumGenerated( Scenario scenario ) const
+    {
+        return mNumGenerated[ scenario ];
+    }
+
+    // the operations added so far, by ACK
+    U64 GetNumOperations() const
+    {
+        return mNumOperations;
+    }
+    U64 GetNumWaits() const
+    {
+        return mNumWaits;
+    }
+    U64 GetNumFaults() const
+    {
+        return mNumFaults;
+    }
+
+  private:
+    void Connect();
+    void DRWBurst();
+    void MultiAP();
+    void WaitStorm();
+    void FaultAbort();
+    void ParityError();
+    void Glitch();
+
+    U32 Random( U32 num_values );
+
+    void Operation( bool APnDP, bool RnW, U8 addr, U8 ack, U32 data, bool data_parity_ok = true );
+    void DPRead( U8 addr, U32 data );
+    void DPWrite( U8 addr, U32 data );
+
+    // the AP registers, which write SELECT first if it doesn't already select them
+    void APRead( U8 apsel, U8 reg, U32 data );
+    void APWrite( U8 apsel, U8 reg, U32 data );
+    void Select( U8 apsel, U8 reg );
+
+    SWDStreamBuilder* mBuilder;
+    std::mt19937 mRng;
+
+    U32 mMinClockPeriod;
+    U32 mMaxClockPeriod;
+
+    U32 mWeights[ NUM_SCENARIOS ];
+    U64 mNumGenerated[ NUM_SCENARIOS ];
+
+    U64 mNumOperations;
+    U64 mNumWaits;
+    U64 mNumFaults;
+
+    // the SELECT value the target has, which is unknown after a line reset
+    U32 mSelect;
+    bool mSelectValid;
+};
+
+#endif // SWD_SCENARIO_GENERATOR_H
@@ -3,7 +3,9 @@
 
 #include "SWDTypes.h"
 
-#define TENTH_US 0.0000001
+// the simulation's time unit, a tenth of a microsecond
+#define TENTH_US 1
+const U64 TICKS_PER_SECOND = 10000000;
 
 // This simulation data. Taken from a real capture.
 
@@ -771,13 +773,13 @@ void SWDSimulationDataGenerator::Initialize( U32 simulation_sample_rate, SWDAnal
     mSimulationSampleRateHz = simulation_sample_rate;
     mSettings = settings;
 
-    mClockGenerator.Init( simulation_sample_rate / 10, simulation_sample_rate );
-
     mSWDIO = mSWDSimulationChannels.Add( settings->mSWDIO, mSimulationSampleRateHz, BIT_LOW );
     mSWCLK = mSWDSimulationChannels.Add( settings->mSWCLK, mSimulationSampleRateHz, BIT_LOW );
 
-    // start from the end to force a line reset in GenerateSimulationData
-    mSimulCnt = sizeof( simul_data ) / sizeof( SimulationData ) - 1;
+    BuildSimulation();
+
+    mStepNdx = 0;
+    mTicks = 0;
 }
 
 U32 SWDSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_requested, U32 sample_rate,
@@ -789,67 +791,125 @@ U32 SWDSimulationDataGenerator::GenerateSimulationData( U64 largest_sample_reque
     // while the caller needs more samples
     while( mSWCLK->GetCurrentSampleNumber() < adjusted_largest_sample_requested )
     {
-        // if we've reached the end of the array of data
-        if( simul_data[ mSimulCnt ].request == 0 )
-        {
-            // pause, reset and restart the data
-            AdvanceAllBySec( 0.01 );
-            OutputLineReset();
-            mSimulCnt = 0;
-        }
+        const SimulationStep& step( mSteps[ mStepNdx ] );
+
+        mTicks += step.ticks;
+        mSWDSimulationChannels.AdvanceAll( U32( TicksToSample( mTicks ) - mSWCLK->GetCurrentSampleNumber() ) );
+
+        mSWDIO->TransitionIfNeeded( step.swdio );
+        mSWCLK->TransitionIfNeeded( step.swclk );
+
+        // start over at the end of the data
+        if( ++mStepNdx == mSteps.size() )
+            mStepNdx = 0;
+    }
+
+    *simulation_channels = mSWDSimulationChannels.GetArray();
+
+    return mSWDSimulationChannels.GetCount();
+}
+
+U64 SWDSimulationDataGenerator::TicksToSample( U64 ticks ) const
+{
+    // whole seconds apart, so it doesn't overflow
+    const U64 seconds = ticks / TICKS_PER_SECOND;
+    const U64 rest = ticks % TICKS_PER_SECOND;
+
+    return seconds * mSimulationSampleRateHz + ( rest * mSimulationSampleRateHz + TICKS_PER_SECOND / 2 ) / TICKS_PER_SECOND;
+}
+
+void SWDSimulationDataGenerator::BuildSimulation()
+{
+    mSteps.clear();
+    mBuildSWDIO = BIT_LOW;
+    mBuildSWCLK = BIT_LOW;
+    mBuildTicks = 0;
 
+    // pause, reset and the data
+    AdvanceTicks( TICKS_PER_SECOND / 100 );
+    OutputLineReset();
+
+    for( size_t ndx = 0; simul_data[ ndx ].request != 0; ++ndx )
+    {
         // shortcut to the simulated data object
-        const SimulationData& sim( simul_data[ mSimulCnt ] );
+        const SimulationData& sim( simul_data[ ndx ] );
 
         // the request and ACK with turnarounds
         // we need the first data bit to prepare the data line
         bool is_write = OutputRequest( sim.request, ACK_OK, ( sim.data & 1 ) ? BIT_HIGH : BIT_LOW );
         OutputData( sim.data, is_write ); // the WData part with parity
+    }
 
-        mSimulCnt++;
+    // show a fault and wait response
+    OutputRequest( 0xA5, ACK_FAULT, BIT_HIGH );
+    AdvanceTicks( TENTH_US * 100 );
+    OutputRequest( 0xB1, ACK_WAIT, BIT_LOW );
+    AdvanceTicks( TENTH_US * 100 );
 
-        // have we reached the end of the data?
-        if( simul_data[ mSimulCnt ].request == 0 )
-        {
-            // show a fault and wait response
-            OutputRequest( 0xA5, ACK_FAULT, BIT_HIGH );
-            AdvanceAllBySec( TENTH_US * 100 );
-            OutputRequest( 0xB1, ACK_WAIT, BIT_LOW );
-            AdvanceAllBySec( TENTH_US * 100 );
-        }
+    // the time left before the data starts over
+    AddStep();
+}
+
+void SWDSimulationDataGenerator::AddStep()
+{
+    // changes at the same time make a single step
+    if( mBuildTicks == 0 && !mSteps.empty() )
+    {
+        mSteps.back().swdio = mBuildSWDIO;
+        mSteps.back().swclk = mBuildSWCLK;
+        return;
     }
 
-    *simulation_channels = mSWDSimulationChannels.GetArray();
+    SimulationStep step;
+    step.ticks = mBuildTicks;
+    step.swdio = mBuildSWDIO;
+    step.swclk = mBuildSWCLK;
+    mSteps.push_back( step );
 
-    return mSWDSimulationChannels.GetCount();
+    mBuildTicks = 0;
+}
+
+void SWDSimulationDataGenerator::SetSWDIO( BitState state )
+{
+    if( state == mBuildSWDIO )
+        return;
+
+    mBuildSWDIO = state;
+    AddStep();
+}
+
+void SWDSimulationDataGenerator::ToggleSWCLK()
+{
+    mBuildSWCLK = mBuildSWCLK == BIT_HIGH ? BIT_LOW : BIT_HIGH;
+    AddStep();
 }
 
 void SWDSimulationDataGenerator::OutputWriteBit( BitState state )
 {
-    mSWDIO->TransitionIfNeeded( state );
+    SetSWDIO( state );
 
-    AdvanceAllBySec( TENTH_US * 3 );
+    AdvanceTicks( TENTH_US * 3 );
 
-    mSWCLK->Transition(); // CLK goes high
-    AdvanceAllBySec( TENTH_US * 4 );
-    mSWCLK->Transition(); // CLK goes low
+    ToggleSWCLK(); // CLK goes high
+    AdvanceTicks( TENTH_US * 4 );
+    ToggleSWCLK(); // CLK goes low
 
-    AdvanceAllBySec( TENTH_US * 3 );
+    AdvanceTicks( TENTH_US * 3 );
 }
 
 void SWDSimulationDataGenerator::OutputReadBit( BitState first_half, BitState second_half )
 {
-    mSWDIO->TransitionIfNeeded( first_half );
+    SetSWDIO( first_half );
 
-    AdvanceAllBySec( TENTH_US * 3 );
+    AdvanceTicks( TENTH_US * 3 );
 
-    mSWCLK->Transition(); // CLK goes high
-    AdvanceAllBySec( TENTH_US * 2 );
-    mSWDIO->TransitionIfNeeded( second_half );
-    AdvanceAllBySec( TENTH_US * 2 );
-    mSWCLK->Transition(); // CLK goes low
+    ToggleSWCLK(); // CLK goes high
+    AdvanceTicks( TENTH_US * 2 );
+    SetSWDIO( second_half );
+    AdvanceTicks( TENTH_US * 2 );
+    ToggleSWCLK(); // CLK goes low
 
-    AdvanceAllBySec( TENTH_US * 3 );
+    AdvanceTicks( TENTH_US * 3 );
 }
 
 void SWDSimulationDataGenerator::OutputLineReset()
@@ -865,14 +925,14 @@ void SWDSimulationDataGenerator::OutputLineReset()
         OutputWriteBit( BIT_LOW );
 
     // pause
-    AdvanceAllBySec( TENTH_US * 50 );
+    AdvanceTicks( TENTH_US * 50 );
 }
 
 void SWDSimulationDataGenerator::OutputTurnaround( BitState state )
 {
-    AdvanceAllBySec( TENTH_US * 10 );
+    AdvanceTicks( TENTH_US * 10 );
     OutputWriteBit( state );
-    AdvanceAllBySec( TENTH_US * 10 );
+    AdvanceTicks( TENTH_US * 10 );
 }
 
 bool SWDSimulationDataGenerator::OutputRequest( U8 req, U8 ack, BitState first_data_bit )
@@ -908,7 +968,8 @@ void SWDSimulationDataGenerator::OutputData( U32 data, bool is_write )
     // the 32 data bits
     U32 bmask;
     U8 num_bits = 0;
-    BitState parity_bit, next_bit;
+    BitState parity_bit = BIT_LOW;
+    BitState next_bit;
     for( bmask = 1; bmask != 0; bmask <<= 1 )
     {
         const bool is_last_bit = bmask == 0x80000000;
@@ -942,5 +1003,5 @@ void SWDSimulationDataGenerator::OutputData( U32 data, bool is_write )
         OutputWriteBit( BIT_LOW );
 
     // pause
-    AdvanceAllBySec( TENTH_US * 50 );
+    AdvanceTicks( TENTH_US * 50 );
 }
@@ -1,6 +1,8 @@
 #ifndef SWD_SIMULATION_DATA_GENERATOR_H
 #define SWD_SIMULATION_DATA_GENERATOR_H
 
+#include <vector>
+
 #include <AnalyzerHelpers.h>
 
 #include "SWDTypes.h"
@@ -19,12 +21,35 @@ class SWDSimulationDataGenerator
   protected:
     SWDAnalyzerSettings* mSettings;
     U32 mSimulationSampleRateHz;
-    U32 mSimulCnt;
 
-    void AdvanceAllBySec( double sec )
+    // One pass over the simulated data, built once by Initialize in ticks of
+    // a tenth of a microsecond, which doesn't depend on the sample rate. Each
+    // step holds the levels of both lines from a point in time on, and the
+    // ticks since the previous step. GenerateSimulationData plays the steps
+    // over and over, placing each one at the sample nearest its time.
+    struct SimulationStep
     {
-        mSWDSimulationChannels.AdvanceAll( mClockGenerator.AdvanceByTimeS( sec ) );
+        U32 ticks;
+        BitState swdio;
+        BitState swclk;
+    };
+
+    std::vector<SimulationStep> mSteps;
+
+    // the levels after the steps built so far, and the ticks since the last one
+    BitState mBuildSWDIO;
+    BitState mBuildSWCLK;
+    U32 mBuildTicks;
+
+    void BuildSimulation();
+    void AddStep();
+
+    void AdvanceTicks( U32 ticks )
+    {
+        mBuildTicks += ticks;
     }
+    void SetSWDIO( BitState state );
+    void ToggleSWCLK();
 
     // read and write in this context is a bit read or written from the perspective of the host
     void OutputWriteBit( BitState state );
@@ -35,9 +60,14 @@ class SWDSimulationDataGenerator
     void OutputData( U32 data, bool is_write );
     void OutputLineReset();
 
-  protected:
-    ClockGenerator mClockGenerator;
+    // the sample nearest the given time
+    U64 TicksToSample( U64 ticks ) const;
 
+    // the next step to play, and the time of the last one played
+    size_t mStepNdx;
+    U64 mTicks;
+
+  protected:
     SimulationChannelDescriptorGroup mSWDSimulationChannels;
     SimulationChannelDescriptor* mSWDIO;
     SimulationChannelDescriptor* mSWCLK;
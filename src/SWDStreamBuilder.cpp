@@ -0,0 +1,207 @@
+#include <algorithm>
+
+#include "SWDStreamBuilder.h"
+
+#include "SWDCaptureFile.h"
+#include "SWDTypes.h"
+
+SWDStreamBuilder::SWDStreamBuilder() : mClockPeriod( 10 ), mJitter( 0 )
+{
+    Clear();
+}
+
+void SWDStreamBuilder::Clear()
+{
+    mSample = 0;
+    mNumBits = 0;
+    mSWDIO = BIT_LOW;
+    mGlitchPending = false;
+
+    ClearEdges();
+}
+
+void SWDStreamBuilder::ClearEdges()
+{
+    mSWDIOEdges.clear();
+    mSWCLKEdges.clear();
+}
+
+void SWDStreamBuilder::SetClockPeriod( U32 samples )
+{
+    mClockPeriod = samples < 2 ? 2 : samples;
+}
+
+void SWDStreamBuilder::SetJitter( U32 samples, U32 seed )
+{
+    mJitter = samples;
+    mJitterRng.seed( seed );
+}
+
+U32 SWDStreamBuilder::MaxJitter() const
+{
+    // the rising edge must stay after the previous bit's falling edge
+    return std::min( mJitter, ( mClockPeriod / 2 - 1 ) / 2 );
+}
+
+U64 SWDStreamBuilder::Jitter( U32 max_jitter )
+{
+    if( max_jitter == 0 )
+        return 0;
+
+    return mJitterRng() % ( 2 * max_jitter + 1 );
+}
+
+void SWDStreamBuilder::SetSWDIO( BitState level )
+{
+    if( level == mSWDIO )
+        return;
+
+    mSWDIOEdges.push_back( mSample );
+    mSWDIO = level;
+}
+
+void SWDStreamBuilder::Bit( BitState level )
+{
+    if( mGlitchPending && mGlitchBit == mNumBits )
+        AddGlitch();
+
+    SetSWDIO( level );
+
+    // the edges move either way around their nominal position
+    const U32 max_jitter = MaxJitter();
+    mSWCLKEdges.push_back( mSample + mClockPeriod / 2 - max_jitter + Jitter( max_jitter ) );
+    mSWCLKEdges.push_back( mSample + mClockPeriod - max_jitter + Jitter( max_jitter ) );
+
+    mSample += mClockPeriod;
+    ++mNumBits;
+}
+
+void SWDStreamBuilder::Bits( U64 value, size_t num_bits )
+{
+    for( size_t ndx = 0; ndx < num_bits; ++ndx )
+        Bit( ( value >> ndx ) & 1 ? BIT_HIGH : BIT_LOW );
+}
+
+void SWDStreamBuilder::Idle( U64 num_bits )
+{
+    while( num_bits-- > 0 )
+        Bit( BIT_LOW );
+}
+
+void SWDStreamBuilder::LineReset( size_t num_high_bits )
+{
+    for( size_t ndx = 0; ndx < num_high_bits; ++ndx )
+        Bit( BIT_HIGH );
+
+    Idle( 2 );
+}
+
+void SWDStreamBuilder::Pause( U64 samples )
+{
+    mSample += samples;
+}
+
+void SWDStreamBuilder::Glitch( bool on_swclk, U32 width, U64 after_bits )
+{
+    mGlitchPending = true;
+    mGlitchBit = mNumBits + after_bits;
+    mGlitchOnSWCLK = on_swclk;
+    mGlitchWidth = width == 0 ? 1 : width;
+
+    if( after_bits == 0 )
+        AddGlitch();
+}
+
+void SWDStreamBuilder::AddGlitch()
+{
+    const U32 width = mGlitchWidth;
+    mGlitchPending = false;
+
+    // keep clear of the jittered falling edge before
+    mSample += MaxJitter() + 1;
+
+    if( mGlitchOnSWCLK )
+    {
+        mSWCLKEdges.push_back( mSample );
+        mSWCLKEdges.push_back( mSample + width );
+    }
+    else
+    {
+        const BitState level = mSWDIO;
+        SetSWDIO( level == BIT_HIGH ? BIT_LOW : BIT_HIGH );
+        mSample += width;
+        SetSWDIO( level );
+        mSample -= width;
+    }
+
+    mSample += width + 1;
+}
+
+U8 SWDStreamBuilder::MakeRequest( bool APnDP, bool RnW, U8 addr )
+{
+    const U8 a2 = ( addr >> 2 ) & 1;
+    const U8 a3 = ( addr >> 3 ) & 1;
+    const U8 parity = ( APnDP ? 1 : 0 ) ^ ( RnW ? 1 : 0 ) ^ a2 ^ a3;
+
+    // start, APnDP, RnW, A[2:3], parity, stop, park
+    return U8( 0x81 | ( APnDP ? 0x02 : 0 ) | ( RnW ? 0x04 : 0 ) | ( a2 << 3 ) | ( a3 << 4 ) | ( parity << 5 ) );
+}
+
+void SWDStreamBuilder::Operation( bool APnDP, bool RnW, U8 addr, U8 ack, U32 data, bool data_parity_ok )
+{
+    Bits( MakeRequest( APnDP, RnW, addr ), 8 );
+
+    // the turnaround to the target, which keeps the park bit's level on the line
+    Bit( BIT_HIGH );
+
+    Bits( ack, 3 );
+
+    if( ack == ACK_OK )
+    {
+        U32 parity = data_parity_ok ? 0 : 1;
+        for( U32 bits = data; bits != 0; bits &= bits - 1 )
+            parity ^= 1;
+
+        // the write data comes from the host after a turnaround,
+        // the read data from the target, with a turnaround after it
+        if( !RnW )
+            Bit( BIT_LOW );
+
+        Bits( data, 32 );
+        Bit( parity ? BIT_HIGH : BIT_LOW );
+
+        if( RnW )
+            Bit( BIT_LOW );
+    }
+    else
+    {
+        // the turnaround back to the host
+        Bit( BIT_LOW );
+    }
+}
+
+SWDChannel* SWDStreamBuilder::OpenSWDIO()
+{
+    SWDMemoryChannel* channel = new SWDMemoryChannel();
+    channel->Open( BIT_LOW, mSWDIOEdges.empty() ? 0 : &mSWDIOEdges[ 0 ], mSWDIOEdges.size() );
+
+    return channel;
+}
+
+SWDChannel* SWDStreamBuilder::OpenSWCLK()
+{
+    SWDMemoryChannel* channel = new SWDMemoryChannel();
+    channel->Open( BIT_LOW, mSWCLKEdges.empty() ? 0 : &mSWCLKEdges[ 0 ], mSWCLKEdges.size() );
+
+    return channel;
+}
+
+U64 SWDStreamBuilder::GetNumSWCLKEdges()
+{
+    return mSWCLKEdges.size();
+}
+
+U64 SWDStreamBuilder::GetSWCLKEdge( U64 ndx )
+{
+    return mSWCLKEdges[ ndx ];
+}
@@ -0,0 +1,116 @@
+#ifndef SWD_STREAM_BUILDER_H
+#define SWD_STREAM_BUILDER_H
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <LogicPublicTypes.h>
+
+#include "SWDChannel.h"
+
+// Builds the SWDIO and SWCLK transitions of an SWD stream in memory, for the
+// benchmarks and the generated captures. SWCLK starts low, and each bit is a
+// whole SWCLK period: SWDIO takes the bit's level while SWCLK is low, and is
+// sampled on the rising edge in the middle of the period. Both lines start low.
+class SWDStreamBuilder : public SWDChannelSource
+{
+  public:
+    SWDStreamBuilder();
+
+    // starts over with an empty stream
+    void Clear();
+
+    // Drops the transitions built so far, which have been written out, and
+    // carries on with the stream. The channels opened before are invalid.
+    void ClearEdges();
+
+    // the SWCLK period in samples, at least 2
+    void SetClockPeriod( U32 samples );
+    U32 GetClockPeriod() const
+    {
+        return mClockPeriod;
+    }
+
+    // Moves each SWCLK edge by up to this many samples either way. The jitter
+    // is limited to what keeps the edges in order at the current period.
+    void SetJitter( U32 samples, U32 seed );
+
+    void Bit( BitState level );
+
+    // the low num_bits bits of value, LSB first
+    void Bits( U64 value, size_t num_bits );
+
+    // idle cycles, with SWDIO low
+    void Idle( U64 num_bits );
+
+    // high bits followed by two idle cycles
+    void LineReset( size_t num_high_bits = 56 );
+
+    // SWCLK stays low for this many samples
+    void Pause( U64 samples );
+
+    // A pulse of width samples on one of the lines while SWCLK is low, which
+    // adds a bit on SWCLK and is not sampled on SWDIO. It comes before the bit
+    // after_bits bits from now, so it can land in the middle of an operation.
+    void Glitch( bool on_swclk, U32 width, U64 after_bits = 0 );
+
+    // A whole operation, from the request to the turnaround after the ACK or the data.
+    // The data phase is only there for OK responses.
+    void Operation( bool APnDP, bool RnW, U8 addr, U8 ack, U32 data, bool data_parity_ok = true );
+
+    // the request byte, with the start, stop and park bits and the parity
+    static U8 MakeRequest( bool APnDP, bool RnW, U8 addr );
+
+    // the number of bits, i.e. SWCLK periods, so far
+    U64 GetNumBits() const
+    {
+        return mNumBits;
+    }
+
+    // the sample after the end of the stream so far
+    U64 GetSampleNumber() const
+    {
+        return mSample;
+    }
+
+    const std::vector<U64>& GetSWDIOEdges() const
+    {
+        return mSWDIOEdges;
+    }
+    const std::vector<U64>& GetSWCLKEdges() const
+    {
+        return mSWCLKEdges;
+    }
+
+    // SWDChannelSource, over the transitions built so far
+    virtual SWDChannel* OpenSWDIO();
+    virtual SWDChannel* OpenSWCLK();
+    virtual U64 GetNumSWCLKEdges();
+    virtual U64 GetSWCLKEdge( U64 ndx );
+
+  private:
+    void SetSWDIO( BitState level );
+    U32 MaxJitter() const;
+    U64 Jitter( U32 max_jitter );
+    void AddGlitch();
+
+    U32 mClockPeriod;
+    U32 mJitter;
+    std::mt19937 mJitterRng;
+
+    U64 mSample;
+    U64 mNumBits;
+    BitState mSWDIO;
+
+    // the glitch to add before bit number mGlitchBit, if any
+    bool mGlitchPending;
+    U64 mGlitchBit;
+    bool mGlitchOnSWCLK;
+    U32 mGlitchWidth;
+
+    std::vector<U64> mSWDIOEdges;
+    std::vector<U64> mSWCLKEdges;
+};
+
+#endif // SWD_STREAM_BUILDER_H
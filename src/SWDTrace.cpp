@@ -0,0 +1,154 @@
+#include <fstream>
+#include <iomanip>
+
+#include "SWDTrace.h"
+
+// The spans of one thread, in blocks which never move once allocated, so
+// WriteChromeTrace can read the spans published by num_events while the
+// thread adds more.
+struct SWDTraceBlock
+{
+    enum
+    {
+        NUM_EVENTS = 4096,
+    };
+
+    SWDTraceEvent events[ NUM_EVENTS ];
+};
+
+struct SWDTraceBuffer
+{
+    enum
+    {
+        MAX_BLOCKS = SWDTrace::MAX_THREAD_EVENTS / SWDTraceBlock::NUM_EVENTS,
+    };
+
+    SWDTraceBuffer() : tid( 0 ), name( 0 ), num_events( 0 ), num_dropped( 0 ), next( 0 )
+    {
+        for( size_t ndx = 0; ndx < MAX_BLOCKS; ++ndx )
+            blocks[ ndx ] = 0;
+    }
+
+    U32 tid;
+    std::atomic<const char*> name;
+
+    std::atomic<SWDTraceBlock*> blocks[ MAX_BLOCKS ];
+    std::atomic<size_t> num_events;
+    std::atomic<U64> num_dropped;
+
+    SWDTraceBuffer* next;
+};
+
+std::atomic<SWDTraceBuffer*> SWDTrace::mBuffers( 0 );
+std::atomic<U32> SWDTrace::mNumThreads( 0 );
+
+// the trace's time 0
+static const U64 TRACE_EPOCH_NS = SWDTrace::Now();
+
+SWDTraceBuffer& SWDTrace::GetThreadBuffer()
+{
+    // The buffers stay around after their threads end, until the process does,
+    // so the spans of the threads that have finished can still be written.
+    static thread_local SWDTraceBuffer* buffer = 0;
+
+    if( buffer == 0 )
+    {
+        buffer = new SWDTraceBuffer();
+        buffer->tid = ++mNumThreads;
+
+        buffer->next = mBuffers.load();
+        while( !mBuffers.compare_exchange_weak( buffer->next, buffer ) )
+            ;
+    }
+
+    return *buffer;
+}
+
+void SWDTrace::SetThreadName( const char* name )
+{
+    GetThreadBuffer().name.store( name, std::memory_order_release );
+}
+
+void SWDTrace::Record( const char* name, U64 start_ns, U64 end_ns )
+{
+    SWDTraceBuffer& buffer = GetThreadBuffer();
+
+    // only this thread writes num_events
+    const size_t ndx = buffer.num_events.load( std::memory_order_relaxed );
+    if( ndx == MAX_THREAD_EVENTS )
+    {
+        buffer.num_dropped.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    SWDTraceBlock* block = buffer.blocks[ ndx / SWDTraceBlock::NUM_EVENTS ].load( std::memory_order_relaxed );
+    if( block == 0 )
+    {
+        block = new SWDTraceBlock();
+        buffer.blocks[ ndx / SWDTraceBlock::NUM_EVENTS ].store( block, std::memory_order_relaxed );
+    }
+
+    SWDTraceEvent& event = block->events[ ndx % SWDTraceBlock::NUM_EVENTS ];
+    event.name = name;
+    event.start_ns = start_ns - TRACE_EPOCH_NS;
+    event.duration_ns = end_ns - start_ns;
+
+    // publishes the event and the block it's in
+    buffer.num_events.store( ndx + 1, std::memory_order_release );
+}
+
+bool SWDTrace::WriteChromeTrace( const std::string& path, std::string& error )
+{
+    std::ofstream of( path.c_str(), std::ios::out );
+    if( !of )
+    {
+        error = "can't create " + path;
+        return false;
+    }
+
+    // the times are in microseconds
+    of << std::fixed << std::setprecision( 3 );
+    of << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool first = true;
+    for( SWDTraceBuffer* buffer = mBuffers.load(); buffer != 0; buffer = buffer->next )
+    {
+        const char* name = buffer->name.load( std::memory_order_acquire );
+        const size_t num_events = buffer->num_events.load( std::memory_order_acquire );
+        const U64 num_dropped = buffer->num_dropped.load( std::memory_order_relaxed );
+
+        if( name != 0 )
+        {
+            of << ( first ? "\n" : ",\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+               << ",\"args\":{\"name\":\"" << name << "\"}}";
+            first = false;
+        }
+
+        if( num_dropped != 0 )
+        {
+            of << ( first ? "\n" : ",\n" ) << "{\"name\":\"dropped spans\",\"ph\":\"C\",\"pid\":1,\"tid\":" << buffer->tid
+               << ",\"ts\":0,\"args\":{\"spans\":" << num_dropped << "}}";
+            first = false;
+        }
+
+        for( size_t ndx = 0; ndx < num_events; ++ndx )
+        {
+            const SWDTraceBlock* block = buffer->blocks[ ndx / SWDTraceBlock::NUM_EVENTS ].load( std::memory_order_relaxed );
+            const SWDTraceEvent& event = block->events[ ndx % SWDTraceBlock::NUM_EVENTS ];
+
+            of << ( first ? "\n" : ",\n" ) << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+               << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << "}";
+            first = false;
+        }
+    }
+
+    of << "\n]}\n";
+
+    if( !of )
+    {
+        error = "can't write " + path;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef SWD_TRACE_H
+#define SWD_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <LogicPublicTypes.h>
+
+// Timing spans of the decoder, for builds configured with SWD_TRACE=ON.
+// SWD_TRACE_SPAN( "name" ) times the rest of the enclosing scope. Each thread
+// records its spans in its own buffer, which only that thread writes to, so
+// recording takes no locks. WriteChromeTrace writes the spans of all the
+// threads in the Chrome trace event format, for chrome://tracing or Perfetto,
+// and can be called while the threads are still recording.
+// Without SWD_TRACE the spans compile to nothing, and there's nothing to write.
+
+struct SWDTraceEvent
+{
+    const char* name;
+    U64 start_ns;
+    U64 duration_ns;
+};
+
+struct SWDTraceBuffer;
+
+class SWDTrace
+{
+  public:
+    // the spans each thread records at the most, the later ones are dropped
+    static const size_t MAX_THREAD_EVENTS = 1 << 22;
+
+    static bool IsBuiltIn()
+    {
+#ifdef SWD_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static U64 Now()
+    {
+        return U64( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+    }
+
+    // the name of the calling thread in the trace; name must outlive the trace
+    static void SetThreadName( const char* name );
+
+    // records a span of the calling thread; name must outlive the trace
+    static void Record( const char* name, U64 start_ns, U64 end_ns );
+
+    // returns false and sets error if the file can't be written
+    static bool WriteChromeTrace( const std::string& path, std::string& error );
+
+  private:
+    static SWDTraceBuffer& GetThreadBuffer();
+
+    // the buffers of all the threads that recorded spans, newest first
+    static std::atomic<SWDTraceBuffer*> mBuffers;
+    static std::atomic<U32> mNumThreads;
+};
+
+// Times its scope, see SWD_TRACE_SPAN.
+class SWDTraceSpan
+{
+  public:
+    explicit SWDTraceSpan( const char* name ) : mName( name ), mStart( SWDTrace::Now() )
+    {
+    }
+
+    ~SWDTraceSpan()
+    {
+        SWDTrace::Record( mName, mStart, SWDTrace::Now() );
+    }
+
+  private:
+    const char* mName;
+    U64 mStart;
+};
+
+#define SWD_TRACE_CONCAT2( a, b ) a##b
+#define SWD_TRACE_CONCAT( a, b ) SWD_TRACE_CONCAT2( a, b )
+
+#ifdef SWD_TRACE
+#define SWD_TRACE_SPAN( name ) SWDTraceSpan SWD_TRACE_CONCAT( swd_trace_span_, __LINE__ )( name )
+#else
+#define SWD_TRACE_SPAN( name )
+#endif
+
+#endif // SWD_TRACE_H
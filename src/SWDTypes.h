@@ -2,8 +2,17 @@
 #define SWD_TYPES_H
 
 #include <LogicPublicTypes.h>
+#include <AnalyzerResults.h>
 
-#include "SWDAnalyzerResults.h"
+#include "SWDBitBuffer.h"
+
+class SWDAnalyzerSettings;
+
+const int TRAN_REQ_AND_ACK = 8 + 1 + 3;             // request/turnaround/ACK
+const int TRAN_READ_LENGTH = TRAN_REQ_AND_ACK + 33; // previous + 32bit data + parity
+const int TRAN_WRITE_LENGTH = TRAN_READ_LENGTH + 1; // previous + one bit for turnaround
+
+const int REQUEST_LENGTH = 8;
 
 // the possible frame types
 enum SWDFrameTypes
@@ -19,6 +28,10 @@ enum SWDFrameTypes
     SWDFT_WData,
     SWDFT_DataParity,
     SWDFT_TrailingBits,
+
+    SWDFT_Operation, // a whole operation in one frame, see SWDOperationFrame
+    SWDFT_Retries,   // WAIT or FAULT operations in a row, see SWDRetryBurst
+    SWDFT_Repeat,    // copies of the operations before it, mData1 has the copies and mData2 the operations in each
 };
 
 // the DebugPort and AccessPort registers as defined by SWD
@@ -58,28 +71,41 @@ enum SWDACK
     ACK_FAULT = 4,
 };
 
-// this is the basic token of the analyzer
-// objects of this type are buffered in SWDOperation
-struct SWDBit
+// everything that can be told about a request from its byte alone
+struct SWDRequestInfo
 {
-    BitState state_rising;
-    BitState state_falling;
+    bool valid; // start, stop and park bits and parity are correct
+
+    bool APnDP;
+    bool RnW;
+    U8 addr; // A[2..3]
+    U8 parity_read;
 
-    S64 low_start;
-    S64 rising;
-    S64 falling;
-    S64 low_end;
+    // the DebugPort register with SELECT.CTRLSEL cleared and set,
+    // SWDR_undefined for AccessPort requests
+    SWDRegisters dp_reg;
+    SWDRegisters dp_reg_ctrlsel;
+};
+
+// decodes the request byte with a single table lookup
+const SWDRequestInfo& GetRequestInfo( U8 request_byte );
+
+// the AccessPort register at addr in the bank selected by SELECT.APBANKSEL
+SWDRegisters GetAPRegister( U32 select_reg, U8 addr );
 
-    bool IsHigh( bool is_rising = true ) const
+// Where operations put their frames and markers, which the analyzer holds
+// back until it knows whether they're shown, see SWDHeldResults.
+class SWDResultsOutput
+{
+  public:
+    virtual ~SWDResultsOutput()
     {
-        return ( is_rising ? state_rising : state_falling ) == BIT_HIGH;
     }
 
-    S64 GetMinStartEnd() const;
-    S64 GetStartSample() const;
-    S64 GetEndSample() const;
+    virtual void AddFrame( const Frame& frame ) = 0;
 
-    Frame MakeFrame();
+    // the markers go on SWCLK
+    virtual void AddMarker( U64 sample_number, AnalyzerResults::MarkerType marker_type ) = 0;
 };
 
 // this object contains data about one SWD operation as described in section 5.3
@@ -103,14 +129,20 @@ struct SWDOperation
     U8 data_parity;
     bool data_parity_ok;
 
-    std::vector<SWDBit> bits;
+    // the bits of the request, ACK and data phases,
+    // valid until the next call to the SWDParser that produced them
+    SWDBitView bits;
+
+    // the idle low bits following the operation
+    SWDBitRun trailing;
 
     // DebugPort or AccessPort register that this operation is reading/writing
     SWDRegisters reg;
 
     void Clear();
-    void AddFrames( SWDAnalyzerResults* pResults );
-    void AddMarkers( SWDAnalyzerResults* pResults );
+    void AddFrames( SWDResultsOutput* pResults, const SWDAnalyzerSettings& settings );
+    void AddOperationFrame( SWDResultsOutput* pResults );
+    void AddMarkers( SWDResultsOutput* pResults, const SWDAnalyzerSettings& settings );
     void SetRegister( U32 select_reg );
 
     bool IsRead()
@@ -121,14 +153,48 @@ struct SWDOperation
 
 struct SWDLineReset
 {
-    std::vector<SWDBit> bits;
+    SWDBitRun bits;
 
     void Clear()
     {
-        bits.clear();
+        bits.Clear( BIT_HIGH );
     }
 
-    void AddFrames( AnalyzerResults* pResults );
+    void AddFrames( SWDResultsOutput* pResults );
+};
+
+// The WAIT or FAULT operations in a row with the same request, which the
+// analyzer shows as one frame once the next operation ends the burst.
+struct SWDRetryBurst
+{
+    U64 count;
+
+    U8 request_byte;
+    U8 ACK;
+    bool RnW;
+    bool APnDP;
+    SWDRegisters reg;
+
+    S64 start_sample;
+    S64 end_sample;
+
+    void Clear()
+    {
+        count = 0;
+    }
+    bool Empty() const
+    {
+        return count == 0;
+    }
+
+    // whether tran is a retry of the operations in the burst
+    bool IsRetry( const SWDOperation& tran ) const
+    {
+        return count != 0 && tran.request_byte == request_byte && tran.ACK == ACK;
+    }
+
+    void Add( SWDOperation& tran );
+    void AddFrames( SWDResultsOutput* pResults );
 };
 
 struct SWDRequestFrame : public Frame
@@ -175,40 +241,67 @@ struct SWDRequestFrame : public Frame
     std::string GetRegisterName() const;
 };
 
-class SWDAnalyzer;
-
-// This object parses and buffers the bits of the SWD stream.
-// IsOperation and IsLineReset return true if the subsequent bits in
-// the stream are a valid operation or line reset.
-class SWDParser
+// The request, the ACK and the data of an operation in a single frame,
+// which is what it gets in the compact frames mode instead of a frame for each.
+struct SWDOperationFrame : public Frame
 {
-  private:
-    AnalyzerChannelData* mSWDIO;
-    AnalyzerChannelData* mSWCLK;
+    // mData1 contains the data, or the number of operations for SWDFT_Retries,
+    // mData2 the request byte in bits 0-7, the ACK in bits 8-15 and the register enum from bit 16
 
-    SWDAnalyzer* mAnalyzer;
-
-    std::vector<SWDBit> mBitsBuffer;
-    U32 mSelectRegister;
-
-    SWDBit ParseBit();
-    void BufferBits( size_t num_bits );
-
-  public:
-    SWDParser();
+    // mFlag
+    enum
+    {
+        IS_READ = ( 1 << 0 ),
+        IS_ACCESS_PORT = ( 1 << 1 ),
+        HAS_DATA = ( 1 << 2 ), // the operation got an OK and has a data phase
+        DATA_PARITY = ( 1 << 3 ),
+        DATA_PARITY_OK = ( 1 << 4 ),
+    };
 
-    void Setup( AnalyzerChannelData* pSWDIO, AnalyzerChannelData* pSWCLK, SWDAnalyzer* pAnalyzer );
+    void SetFields( U8 request_byte, U8 ACK, SWDRegisters reg )
+    {
+        mData2 = request_byte | ( U64( ACK ) << 8 ) | ( U64( reg ) << 16 );
+    }
 
-    void Clear()
+    U8 GetRequestByte() const
+    {
+        return U8( mData2 );
+    }
+    U8 GetACK() const
+    {
+        return U8( mData2 >> 8 );
+    }
+    SWDRegisters GetRegister() const
     {
-        mBitsBuffer.clear();
-        mSelectRegister = 0;
+        return SWDRegisters( mData2 >> 16 );
     }
+    std::string GetRegisterName() const;
 
-    bool IsOperation( SWDOperation& tran );
-    bool IsLineReset( SWDLineReset& reset );
+    U32 GetData() const
+    {
+        return U32( mData1 );
+    }
+    U64 GetCount() const
+    {
+        return mData1;
+    }
 
-    SWDBit PopFrontBit();
+    bool IsRead() const
+    {
+        return ( mFlags & IS_READ ) != 0;
+    }
+    bool IsAccessPort() const
+    {
+        return ( mFlags & IS_ACCESS_PORT ) != 0;
+    }
+    bool HasData() const
+    {
+        return ( mFlags & HAS_DATA ) != 0;
+    }
+    bool IsDataParityOK() const
+    {
+        return ( mFlags & DATA_PARITY_OK ) != 0;
+    }
 };
 
 #endif // SWD_TYPES_H